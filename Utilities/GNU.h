@@ -243,6 +243,26 @@ inline std::uint64_t cntlz64(std::uint64_t arg)
 #endif
 }
 
+inline std::uint32_t cnttz32(std::uint32_t arg)
+{
+#if defined(_MSC_VER)
+	unsigned long res;
+	return _BitScanForward(&res, arg) ? res : 32;
+#else
+	return arg ? __builtin_ctz(arg) : 32;
+#endif
+}
+
+inline std::uint64_t cnttz64(std::uint64_t arg)
+{
+#if defined(_MSC_VER)
+	unsigned long res;
+	return _BitScanForward64(&res, arg) ? res : 64;
+#else
+	return arg ? __builtin_ctzll(arg) : 64;
+#endif
+}
+
 // compare 16 packed unsigned bytes (greater than)
 inline __m128i sse_cmpgt_epu8(__m128i A, __m128i B)
 {
@@ -136,6 +136,8 @@ enum x64_op_t : u32
 	X64OP_NONE,
 	X64OP_LOAD, // obtain and put the value into x64 register
 	X64OP_STORE, // take the value from x64 register or an immediate and use it
+	X64OP_LOAD_BE, // MOVBE r, m (byteswapped load)
+	X64OP_STORE_BE, // MOVBE m, r (byteswapped store)
 	X64OP_MOVS,
 	X64OP_STOS,
 	X64OP_XCHG,
@@ -347,6 +349,18 @@ void decode_x64_reg_op(const u8* code, x64_op_t& out_op, x64_reg_t& out_reg, siz
 			}
 			break;
 		}
+		case 0x38:
+		{
+			if (!lock && !repe && !repne && (op3 == 0xf0 || op3 == 0xf1)) // MOVBE r, m / MOVBE m, r (16, 32, 64)
+			{
+				out_op = op3 == 0xf0 ? X64OP_LOAD_BE : X64OP_STORE_BE;
+				out_reg = get_modRM_reg(code + 1, rex);
+				out_size = get_op_size(rex, oso);
+				out_length += get_modRM_size(code + 1) + 1;
+				return;
+			}
+			break;
+		}
 		}
 
 		break;
@@ -798,6 +812,9 @@ namespace rsx
 	extern std::function<bool(u32 addr, bool is_writing)> g_access_violation_handler;
 }
 
+// Commit PPU decoder table memory on first access (returns false if the address is not in the table)
+extern bool ppu_commit_decoder_table(const void* ptr);
+
 bool handle_access_violation(u32 addr, bool is_writing, x64_context* context)
 {
 	if (rsx::g_access_violation_handler && rsx::g_access_violation_handler(addr, is_writing))
@@ -879,6 +896,26 @@ bool handle_access_violation(u32 addr, bool is_writing, x64_context* context)
 
 			break;
 		}
+		case X64OP_LOAD_BE:
+		{
+			u32 value;
+			if (is_writing || !thread->read_reg(addr, value) || !put_x64_reg_value(context, reg, d_size, value))
+			{
+				return false;
+			}
+
+			break;
+		}
+		case X64OP_STORE_BE:
+		{
+			u64 reg_value;
+			if (!is_writing || !get_x64_reg_value(context, reg, d_size, i_size, reg_value) || !thread->write_reg(addr, (u32)reg_value))
+			{
+				return false;
+			}
+
+			break;
+		}
 		case X64OP_MOVS: // possibly, TODO
 		case X64OP_STOS:
 		default:
@@ -894,6 +931,12 @@ bool handle_access_violation(u32 addr, bool is_writing, x64_context* context)
 		return true;
 	}
 
+	// check if fault is caused by the write to decoded code
+	if (is_writing && vm::invalidate_code(addr))
+	{
+		return true;
+	}
+
 	// check if fault is caused by the reservation
 	return vm::reservation_query(addr, (u32)a_size, is_writing, [&]() -> bool
 	{
@@ -930,6 +973,25 @@ bool handle_access_violation(u32 addr, bool is_writing, x64_context* context)
 			std::memcpy(vm::base_priv(addr), &reg_value, d_size);
 			break;
 		}
+		case X64OP_STORE_BE:
+		{
+			u64 reg_value;
+			if (!get_x64_reg_value(context, reg, d_size, i_size, reg_value))
+			{
+				return false;
+			}
+
+			switch (d_size)
+			{
+			case 2: reg_value = se_storage<u16>::swap((u16)reg_value); break;
+			case 4: reg_value = se_storage<u32>::swap((u32)reg_value); break;
+			case 8: reg_value = se_storage<u64>::swap(reg_value); break;
+			default: return false;
+			}
+
+			std::memcpy(vm::base_priv(addr), &reg_value, d_size);
+			break;
+		}
 		case X64OP_MOVS:
 		{
 			if (d_size > 8)
@@ -1155,6 +1217,10 @@ static LONG exception_handler(PEXCEPTION_POINTERS pExp)
 	{
 		return EXCEPTION_CONTINUE_EXECUTION;
 	}
+	else if (pExp->ExceptionRecord->ExceptionCode == EXCEPTION_ACCESS_VIOLATION && ppu_commit_decoder_table((void*)pExp->ExceptionRecord->ExceptionInformation[1]))
+	{
+		return EXCEPTION_CONTINUE_EXECUTION;
+	}
 	else
 	{
 		return EXCEPTION_CONTINUE_SEARCH;
@@ -1250,6 +1316,11 @@ static void signal_handler(int sig, siginfo_t* info, void* uct)
 
 	// TODO: Exception specific informative messages
 
+	if (ppu_commit_decoder_table(info->si_addr))
+	{
+		return;
+	}
+
 	if (addr64 < 0x100000000ull && thread_ctrl::get_current())
 	{
 		// Try to process access violation
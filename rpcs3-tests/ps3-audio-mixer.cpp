@@ -0,0 +1,202 @@
+#include "stdafx.h"
+#include "Emu\Audio\AudioMixer.h"
+#include "Emu\Audio\AudioRing.h"
+
+#include <chrono>
+#include <random>
+#include <thread>
+
+TEST_CLASS(audio_mixer_test)
+{
+	// Port buffer layout used by cellAudio: 256 interleaved big-endian samples
+	static std::vector<be_t<f32>> make_port(u32 channels, std::mt19937& rng)
+	{
+		std::uniform_real_distribution<f32> dist(-1.0f, 1.0f);
+		std::vector<be_t<f32>> result(channels * 256);
+
+		for (auto& v : result)
+		{
+			v = dist(rng);
+		}
+
+		return result;
+	}
+
+	// Reference implementation (scalar loops previously used by cellAudio and libmixer)
+	static void mix_reference(f32* dst, const be_t<f32>* src, u32 channels, u32 samples, const f32* vol, f32 volume)
+	{
+		for (u32 i = 0; i < samples; i++)
+		{
+			const f32 m = vol ? vol[i] : volume;
+
+			if (channels == 1)
+			{
+				dst[i * 8 + 0] += src[i] * m;
+				dst[i * 8 + 1] += src[i] * m;
+				continue;
+			}
+
+			for (u32 ch = 0; ch < channels; ch++)
+			{
+				dst[i * 8 + ch] += src[i * channels + ch] * m;
+			}
+		}
+	}
+
+	TEST_METHOD(mix_matches_reference)
+	{
+		std::mt19937 rng(1);
+
+		f32 ramp[256];
+
+		for (u32 i = 0; i < 256; i++)
+		{
+			ramp[i] = i / 256.0f;
+		}
+
+		for (u32 channels : { 1, 2, 6, 8 })
+		{
+			const auto src = make_port(channels, rng);
+
+			for (const f32* vol : { (const f32*)nullptr, (const f32*)ramp })
+			{
+				std::vector<f32> expected(8 * 256, 0.5f);
+				std::vector<f32> result(8 * 256, 0.5f);
+
+				mix_reference(expected.data(), src.data(), channels, 256, vol, 0.75f);
+				audio_mixer::mix_to_8ch(result.data(), src.data(), channels, 256, vol, 0.75f);
+
+				if (expected != result)
+				{
+					TEST_FAILURE("mix_to_8ch mismatch (channels=%d, ramp=%d)", channels, vol != nullptr);
+				}
+			}
+		}
+	}
+
+	TEST_METHOD(downmix_matches_reference)
+	{
+		std::mt19937 rng(2);
+
+		const auto src_be = make_port(8, rng);
+		std::vector<f32> src(src_be.begin(), src_be.end());
+
+		f32 expected[2 * 256];
+		f32 result[2 * 256];
+
+		for (u32 i = 0; i < 256; i++)
+		{
+			const f32 mid = (src[i * 8 + 2] + src[i * 8 + 3]) * 0.708f;
+			expected[i * 2 + 0] = src[i * 8 + 0] + src[i * 8 + 4] + src[i * 8 + 6] + mid;
+			expected[i * 2 + 1] = src[i * 8 + 1] + src[i * 8 + 5] + src[i * 8 + 7] + mid;
+		}
+
+		audio_mixer::downmix_8ch_to_2ch(result, src.data(), 256);
+
+		if (memcmp(expected, result, sizeof(result)) != 0)
+		{
+			TEST_FAILURE("downmix_8ch_to_2ch mismatch");
+		}
+	}
+
+	// Mix eight 8-channel ports per block like the cellAudio thread does, and compare timing with the scalar loops
+	TEST_METHOD(mix_benchmark)
+	{
+		std::mt19937 rng(3);
+
+		std::vector<std::vector<be_t<f32>>> ports;
+
+		for (u32 i = 0; i < 8; i++)
+		{
+			ports.emplace_back(make_port(8, rng));
+		}
+
+		std::vector<f32> buf8ch(8 * 256);
+		f32 buf2ch[2 * 256];
+
+		const u32 blocks = 10000;
+
+		const auto measure = [&](auto&& mix)
+		{
+			const auto start = std::chrono::high_resolution_clock::now();
+
+			for (u32 n = 0; n < blocks; n++)
+			{
+				std::fill(buf8ch.begin(), buf8ch.end(), 0.0f);
+
+				for (auto& port : ports)
+				{
+					mix(port.data());
+				}
+
+				audio_mixer::downmix_8ch_to_2ch(buf2ch, buf8ch.data(), 256);
+			}
+
+			return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+		};
+
+		const auto scalar_time = measure([&](const be_t<f32>* src) { mix_reference(buf8ch.data(), src, 8, 256, nullptr, 0.5f); });
+		const auto simd_time = measure([&](const be_t<f32>* src) { audio_mixer::mix_to_8ch(buf8ch.data(), src, 8, 256, nullptr, 0.5f); });
+
+		TEST_LOG("%d blocks x %d ports: scalar %lld us, simd %lld us\n", blocks, ports.size(), scalar_time, simd_time);
+	}
+
+	TEST_METHOD(ring_waits_for_slow_consumer)
+	{
+		audio_ring_t ring(16, 4);
+
+		std::atomic<bool> stop{ false };
+		std::vector<float> received;
+
+		// consumer slower than the producer
+		std::thread consumer([&]()
+		{
+			while (received.size() < 64 * 16)
+			{
+				if (const float* block = ring.get_read_block())
+				{
+					std::this_thread::sleep_for(std::chrono::microseconds(200));
+					received.insert(received.end(), block, block + 16);
+					ring.commit_read();
+				}
+				else
+				{
+					ring.wait(std::chrono::milliseconds(1));
+				}
+			}
+		});
+
+		float block[16];
+
+		for (u32 i = 0; i < 64; i++)
+		{
+			std::fill_n(block, 16, static_cast<float>(i));
+
+			if (!ring.push(block, std::chrono::seconds(10), [&] { return stop.load(); }))
+			{
+				TEST_FAILURE("Block %d dropped", i);
+			}
+		}
+
+		consumer.join();
+
+		for (u32 i = 0; i < received.size(); i++)
+		{
+			if (received[i] != i / 16)
+			{
+				TEST_FAILURE("Unexpected sample %d (%f)", i, received[i]);
+			}
+		}
+
+		// without consumer the block is dropped after the timeout or when stopped
+		for (u32 i = 0; i < 4; i++)
+		{
+			ring.push(block, std::chrono::seconds(0), [] { return false; });
+		}
+
+		if (ring.dropped != 0 || ring.push(block, std::chrono::milliseconds(5), [] { return false; }) || ring.push(block, std::chrono::seconds(10), [] { return true; }) || ring.dropped != 2)
+		{
+			TEST_FAILURE("Full ring: unexpected result (dropped %d)", ring.dropped.load());
+		}
+	}
+};
@@ -0,0 +1,212 @@
+#include "stdafx.h"
+#include "Crypto\aes.h"
+#include "Crypto\sha1.h"
+
+#include <random>
+
+// NIST SP 800-38A, AES-128 (four blocks: the accelerated paths process whole 64-byte chunks)
+static const char* const g_aes_key = "2b7e151628aed2a6abf7158809cf4f3c";
+static const char* const g_aes_plaintext = "6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e5130c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710";
+
+TEST_CLASS(crypto_test)
+{
+	static std::vector<u8> hex(const char* str)
+	{
+		std::vector<u8> result;
+
+		for (; str[0] && str[1]; str += 2)
+		{
+			result.push_back(static_cast<u8>(std::stoul(std::string(str, 2), nullptr, 16)));
+		}
+
+		return result;
+	}
+
+	static std::string to_hex(const u8* data, std::size_t size)
+	{
+		std::string result;
+
+		for (std::size_t i = 0; i < size; i++)
+		{
+			result += fmt::format("%02x", data[i]);
+		}
+
+		return result;
+	}
+
+	// Run the check with the table implementation and with AES-NI/SHA-NI (if supported)
+	template<typename F>
+	static void for_each_implementation(F check)
+	{
+		aes_use_aesni(0);
+		sha1_use_shani(0);
+		check("table");
+
+		if (aes_use_aesni(1) | sha1_use_shani(1))
+		{
+			check("AES-NI/SHA-NI");
+		}
+		else
+		{
+			TEST_LOG("AES-NI and SHA-NI are not supported, only the table implementation is tested%s\n", "");
+		}
+	}
+
+	TEST_METHOD(aes_ecb_known_answer)
+	{
+		const auto k = hex(g_aes_key), p = hex(g_aes_plaintext);
+		const auto c = hex("3ad77bb40d7a3660a89ecaf32466ef97f5d3d58503b9699de785895a96fdbaaf43b1cd7f598ece23881b00e3ed0306887b0c785e27e8ad3f8223207104725dd4");
+
+		for_each_implementation([&](const char* impl)
+		{
+			aes_context enc, dec;
+			aes_setkey_enc(&enc, k.data(), 128);
+			aes_setkey_dec(&dec, k.data(), 128);
+
+			for (u32 i = 0; i < p.size(); i += 16)
+			{
+				u8 out[16], back[16];
+				aes_crypt_ecb(&enc, AES_ENCRYPT, p.data() + i, out);
+				aes_crypt_ecb(&dec, AES_DECRYPT, out, back);
+
+				if (std::memcmp(out, c.data() + i, 16) || std::memcmp(back, p.data() + i, 16))
+				{
+					TEST_FAILURE("ECB mismatch in block %d (%s): %s", i / 16, impl, to_hex(out, 16));
+				}
+			}
+		});
+	}
+
+	TEST_METHOD(aes_cbc_known_answer)
+	{
+		const auto k = hex(g_aes_key), p = hex(g_aes_plaintext);
+		const auto c = hex("7649abac8119b246cee98e9b12e9197d5086cb9b507219ee95db113a917678b273bed6b8e3c1743b7116e69e222295163ff1caa1681fac09120eca307586e1a7");
+		const auto iv = hex("000102030405060708090a0b0c0d0e0f");
+
+		for_each_implementation([&](const char* impl)
+		{
+			aes_context enc, dec;
+			aes_setkey_enc(&enc, k.data(), 128);
+			aes_setkey_dec(&dec, k.data(), 128);
+
+			std::vector<u8> out(p.size()), back(p.size());
+			auto v = iv;
+			aes_crypt_cbc(&enc, AES_ENCRYPT, p.size(), v.data(), p.data(), out.data());
+
+			// decrypt the first block separately, the rest continues with the updated IV
+			v = iv;
+			aes_crypt_cbc(&dec, AES_DECRYPT, 16, v.data(), out.data(), back.data());
+			aes_crypt_cbc(&dec, AES_DECRYPT, p.size() - 16, v.data(), out.data() + 16, back.data() + 16);
+
+			if (out != c || back != p)
+			{
+				TEST_FAILURE("CBC mismatch (%s): %s", impl, to_hex(out.data(), out.size()));
+			}
+		});
+	}
+
+	TEST_METHOD(aes_ctr_known_answer)
+	{
+		const auto k = hex(g_aes_key), p = hex(g_aes_plaintext);
+		const auto c = hex("874d6191b620e3261bef6864990db6ce9806f66b7970fdff8617187bb9fffdff5ae4df3edbd5d35e5b4f09020db03eab1e031dda2fbe03d1792170a0f3009cee");
+		const auto counter = hex("f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff");
+
+		for_each_implementation([&](const char* impl)
+		{
+			aes_context ctx;
+			aes_setkey_enc(&ctx, k.data(), 128);
+
+			// whole buffer, then the same stream in uneven parts (resumed within the stream block)
+			for (const u32 part : { 64, 5, 16, 23 })
+			{
+				std::vector<u8> out(p.size());
+				auto nonce = counter;
+				u8 stream[16];
+				std::size_t offset = 0;
+
+				for (u32 pos = 0; pos < p.size(); pos += part)
+				{
+					aes_crypt_ctr(&ctx, std::min<u32>(part, static_cast<u32>(p.size()) - pos), &offset, nonce.data(), stream, p.data() + pos, out.data() + pos);
+				}
+
+				if (out != c)
+				{
+					TEST_FAILURE("CTR mismatch (%s, parts of %d bytes): %s", impl, part, to_hex(out.data(), out.size()));
+				}
+			}
+		});
+	}
+
+	TEST_METHOD(aes_accelerated_matches_table)
+	{
+		std::mt19937 rng;
+
+		std::vector<u8> k(16), iv(16), data(16 * 1001);
+		for (auto& b : k) b = rng();
+		for (auto& b : iv) b = rng();
+		for (auto& b : data) b = rng();
+
+		// CBC decryption and CTR of a long buffer (4-block chunks and the remaining block)
+		const auto run = [&](std::vector<u8>& cbc, std::vector<u8>& ctr)
+		{
+			aes_context ctx;
+			cbc.resize(data.size());
+			ctr.resize(data.size() - 3);
+
+			aes_setkey_dec(&ctx, k.data(), 128);
+			auto v = iv;
+			aes_crypt_cbc(&ctx, AES_DECRYPT, data.size(), v.data(), data.data(), cbc.data());
+
+			aes_setkey_enc(&ctx, k.data(), 128);
+			v = iv;
+			u8 stream[16];
+			std::size_t offset = 0;
+			aes_crypt_ctr(&ctx, ctr.size(), &offset, v.data(), stream, data.data(), ctr.data());
+		};
+
+		std::vector<u8> cbc_table, ctr_table, cbc_ni, ctr_ni;
+
+		aes_use_aesni(0);
+		run(cbc_table, ctr_table);
+
+		if (!aes_use_aesni(1))
+		{
+			TEST_LOG("AES-NI is not supported%s\n", "");
+			return;
+		}
+
+		run(cbc_ni, ctr_ni);
+
+		if (cbc_ni != cbc_table || ctr_ni != ctr_table)
+		{
+			TEST_FAILURE("AES-NI result differs from the table implementation (CBC %s, CTR %s)", cbc_ni == cbc_table ? "ok" : "mismatch", ctr_ni == ctr_table ? "ok" : "mismatch");
+		}
+	}
+
+	TEST_METHOD(sha1_known_answer)
+	{
+		// FIPS 180-2 examples
+		const std::string one_million_a(1000000, 'a');
+
+		const std::pair<std::string, const char*> samples[] =
+		{
+			{ "abc", "a9993e364706816aba3e25717850c26c9cd0d89d" },
+			{ "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", "84983e441c3bd26ebaae4aa1f95129e5e54670f1" },
+			{ one_million_a, "34aa973cd4c4daa4f61eeb2bdbad27316534016f" },
+		};
+
+		for_each_implementation([&](const char* impl)
+		{
+			for (const auto& s : samples)
+			{
+				u8 digest[20];
+				sha1(reinterpret_cast<const u8*>(s.first.data()), s.first.size(), digest);
+
+				if (to_hex(digest, 20) != s.second)
+				{
+					TEST_FAILURE("SHA-1 mismatch for %d bytes (%s): %s", s.first.size(), impl, to_hex(digest, 20));
+				}
+			}
+		});
+	}
+};
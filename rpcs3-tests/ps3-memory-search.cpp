@@ -0,0 +1,113 @@
+#include "stdafx.h"
+#include "Emu\Memory\vm_search.h"
+
+TEST_CLASS(memory_search_test)
+{
+	TEST_METHOD(search_patterns)
+	{
+		setup_ps3_environment();
+
+		// allocate more than one search chunk
+		const u32 size = 3 * 1024 * 1024;
+		const u32 addr = vm::alloc(size, vm::main);
+
+		std::memset(vm::base(addr), 0, size);
+		std::memcpy(vm::base(addr + 0x100), "needle", 6);
+		std::memcpy(vm::base(addr + 0xfffff), "needle", 6); // crosses the chunk boundary
+		std::memcpy(vm::base(addr + size - 6), "needle", 6); // at the end of allocated memory
+		std::memcpy(vm::base(addr + 0x2000), "\x12\x34\x56\x78", 4);
+		vm::ps3::write32(addr + 0x3000, 0xdeadbeef);
+		vm::ps3::write32(addr + 0x4001, 0xdeadbeef); // unaligned
+
+		const auto results = vm::search(vm::main,
+		{
+			vm::search_pattern::from_string("needle"),
+			vm::search_pattern::from_hex("12 ?? 56 78"),
+			vm::search_pattern::from_value<u32>(0xdeadbeef),
+		});
+
+		const std::vector<std::pair<u32, u32>> expected =
+		{
+			{ addr + 0x100, 0 },
+			{ addr + 0x2000, 1 },
+			{ addr + 0x3000, 2 },
+			{ addr + 0xfffff, 0 },
+			{ addr + size - 6, 0 },
+		};
+
+		if (results.size() != expected.size())
+		{
+			TEST_FAILURE("Unexpected result count (%d)", results.size());
+		}
+
+		for (std::size_t i = 0; i < expected.size(); i++)
+		{
+			if (results[i].addr != expected[i].first || results[i].pattern != expected[i].second)
+			{
+				TEST_FAILURE("Unexpected result at 0x%x (pattern %d)", results[i].addr, results[i].pattern);
+			}
+		}
+
+		vm::dealloc(addr, vm::main);
+	}
+
+	TEST_METHOD(search_max_results)
+	{
+		setup_ps3_environment();
+
+		// one match in every 64 KB, in many chunks scanned by different threads
+		const u32 size = 4 * 1024 * 1024;
+		const u32 addr = vm::alloc(size, vm::main);
+
+		std::memset(vm::base(addr), 0, size);
+
+		for (u32 offset = 0; offset < size; offset += 0x10000)
+		{
+			std::memcpy(vm::base(addr + offset + 0x10), "needle", 6);
+		}
+
+		const auto results = vm::search(vm::main, { vm::search_pattern::from_string("needle") }, 10);
+
+		if (results.size() != 10)
+		{
+			TEST_FAILURE("Unexpected result count (%d)", results.size());
+		}
+
+		// the matches at the lowest addresses are returned
+		for (u32 i = 0; i < results.size(); i++)
+		{
+			if (results[i].addr != addr + i * 0x10000 + 0x10)
+			{
+				TEST_FAILURE("Unexpected result 0x%x at index %d", results[i].addr, i);
+			}
+		}
+
+		vm::dealloc(addr, vm::main);
+	}
+
+	TEST_METHOD(snapshot_diff)
+	{
+		setup_ps3_environment();
+
+		const u32 addr = vm::alloc(0x10000, vm::main);
+
+		std::memset(vm::base(addr), 0, 0x10000);
+		vm::ps3::write32(addr + 0x10, 100);
+		vm::ps3::write32(addr + 0x20, 100);
+
+		const vm::memory_snapshot snapshot(vm::main);
+
+		vm::ps3::write32(addr + 0x10, 101);
+		vm::ps3::write32(addr + 0x20, 99);
+
+		const auto changed = snapshot.diff(4, vm::memory_snapshot::compare::changed);
+		const auto increased = snapshot.diff(4, vm::memory_snapshot::compare::increased, true, &changed);
+
+		if (changed.size() != 2 || increased.size() != 1 || increased[0] != addr + 0x10)
+		{
+			TEST_FAILURE("Unexpected diff result (%d changed)", changed.size());
+		}
+
+		vm::dealloc(addr, vm::main);
+	}
+};
@@ -0,0 +1,169 @@
+#include "stdafx.h"
+#include "Emu\IdManager.h"
+#include "Emu\Cell\PPUThread.h"
+#include "Emu\Cell\PPUASMJITRecompiler.h"
+
+#include <random>
+
+TEST_CLASS(ppu_recompiler_test)
+{
+	// Instruction encoders (D, DS and X forms)
+	static u32 d(u32 opcd, u32 rt, u32 ra, s32 imm) { return opcd << 26 | rt << 21 | ra << 16 | (imm & 0xffff); }
+	static u32 ds(u32 opcd, u32 xo, u32 rt, u32 ra, s32 imm) { return opcd << 26 | rt << 21 | ra << 16 | (imm & 0xfffc) | xo; }
+	static u32 x(u32 xo, u32 rs, u32 ra, u32 rb) { return 31 << 26 | rs << 21 | ra << 16 | rb << 11 | xo << 1; }
+
+	static const u32 data_size = 0x200;
+
+	// Run code through the recompiler and through the interpreter with the same random inputs and compare the results
+	static void verify(std::initializer_list<u32> code)
+	{
+		setup_ps3_environment();
+		Emu.SetTestMode();
+
+		fxm::make_always<ppu_decoder_cache_t>();
+		const auto recompiler = fxm::make_always<ppu_recompiler>();
+		const auto ppu = idm::make_ptr<PPUThread>("test");
+
+		const u32 code_addr = vm::alloc(4096, vm::main);
+		const u32 data_addr = vm::alloc(4096, vm::main);
+
+		// the block ends at the end of the page
+		const u32 start = code_addr + 4096 - static_cast<u32>(code.size()) * 4;
+
+		for (u32 i = 0; i < code.size(); i++)
+		{
+			vm::ps3::write32(start + i * 4, code.begin()[i]);
+		}
+
+		std::mt19937_64 rng;
+
+		for (u32 n = 0; n < 20; n++)
+		{
+			// random registers and data, r1 and r2 point to the data (r2 to its end for negative offsets)
+			std::array<u64, 32> gpr;
+			std::vector<u64> data(data_size / 8);
+
+			for (auto& r : gpr) r = rng();
+			for (auto& v : data) v = rng();
+
+			gpr[1] = data_addr;
+			gpr[2] = data_addr + data_size;
+
+			const auto run = [&](bool recompiled, std::vector<u64>& result)
+			{
+				std::copy(gpr.begin(), gpr.end(), ppu->GPR);
+				std::memcpy(vm::base(data_addr), data.data(), data_size);
+
+				if (recompiled)
+				{
+					ppu->PC = start;
+
+					if (recompiler->get_block(start)(ppu.get()) != 0)
+					{
+						TEST_FAILURE("Block returned an error (PC=0x%x)", ppu->PC);
+					}
+
+					if (ppu->PC != code_addr + 4096)
+					{
+						TEST_FAILURE("Unexpected PC after the block (0x%x)", ppu->PC);
+					}
+				}
+				else
+				{
+					for (u32 op : code)
+					{
+						ppu_decoder_cache_t::decode(op)(*ppu, { op });
+					}
+				}
+
+				result.assign(ppu->GPR, ppu->GPR + 32);
+				result.resize(32 + data_size / 8);
+				std::memcpy(result.data() + 32, vm::base(data_addr), data_size);
+			};
+
+			std::vector<u64> interpreted, recompiled;
+			run(false, interpreted);
+			run(true, recompiled);
+
+			for (u32 i = 0; i < interpreted.size(); i++)
+			{
+				if (interpreted[i] != recompiled[i])
+				{
+					TEST_FAILURE("%s mismatch (code[0]=0x%08x): interpreter 0x%016llx, recompiler 0x%016llx", (i < 32 ? fmt::format("GPR[%d]", i) : fmt::format("data[0x%x]", (i - 32) * 8)).c_str(), code.begin()[0], interpreted[i], recompiled[i]);
+				}
+			}
+		}
+
+		vm::dealloc(code_addr, vm::main);
+		vm::dealloc(data_addr, vm::main);
+		idm::remove<PPUThread>(ppu->get_id());
+		fxm::remove<ppu_recompiler>();
+		fxm::remove<ppu_decoder_cache_t>();
+	}
+
+	TEST_METHOD(native_addi)
+	{
+		verify({ d(14, 3, 4, -5) });
+		verify({ d(14, 3, 0, 0x7fff) });
+		verify({ d(14, 3, 3, 0) });
+	}
+
+	TEST_METHOD(native_addis)
+	{
+		verify({ d(15, 5, 6, -0x8000) });
+		verify({ d(15, 5, 0, 1) });
+	}
+
+	TEST_METHOD(native_ori)
+	{
+		verify({ d(24, 8, 7, 0xabcd) });
+		verify({ d(24, 8, 8, 0) });
+		verify({ d(25, 10, 9, 0xffff) });
+		verify({ d(25, 9, 9, 0x8000) });
+	}
+
+	TEST_METHOD(native_or)
+	{
+		verify({ x(444, 12, 11, 13) });
+		verify({ x(444, 12, 11, 12) });
+		verify({ x(444, 11, 11, 13) });
+	}
+
+	TEST_METHOD(native_lwz_stw)
+	{
+		verify({ d(32, 14, 1, 8) });
+		verify({ d(32, 14, 2, -4) });
+		verify({ d(32, 1, 1, 0) });
+		verify({ d(36, 15, 1, 12) });
+		verify({ d(36, 15, 2, -0x20) });
+		verify({ d(36, 1, 1, 4) });
+	}
+
+	TEST_METHOD(native_ld_std)
+	{
+		verify({ ds(58, 0, 16, 1, 16) });
+		verify({ ds(58, 0, 16, 2, -8) });
+		verify({ ds(58, 0, 2, 2, -0x10) });
+		verify({ ds(62, 0, 17, 1, 24) });
+		verify({ ds(62, 0, 17, 2, -8) });
+		verify({ ds(62, 0, 1, 1, 0x40) });
+	}
+
+	TEST_METHOD(native_sequence)
+	{
+		// native instructions mixed with interpreter calls (ADD, RLDICL), the block keeps the state consistent
+		verify(
+		{
+			ds(58, 0, 3, 1, 0), // ld r3, 0(r1)
+			d(14, 3, 3, 0x100), // addi r3, r3, 0x100
+			x(266, 4, 3, 3), // add r4, r3, r3
+			x(444, 5, 4, 3), // or r5, r4, r3
+			d(24, 5, 5, 0x1234), // ori r5, r5, 0x1234
+			30 << 26 | 5 << 21 | 6 << 16 | 8 << 11 | 0 << 5, // rldicl r6, r5, 8, 0
+			ds(62, 0, 6, 1, 8), // std r6, 8(r1)
+			d(36, 5, 2, -4), // stw r5, -4(r2)
+			d(32, 7, 1, 12), // lwz r7, 12(r1)
+			d(15, 1, 1, 1), // addis r1, r1, 1
+		});
+	}
+};
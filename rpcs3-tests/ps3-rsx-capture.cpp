@@ -0,0 +1,75 @@
+#include "stdafx.h"
+#include "Emu\RSX\rsx_capture.h"
+
+TEST_CLASS(rsx_capture_test)
+{
+	static std::vector<gsl::byte> make_buffer(std::size_t size, u32 seed)
+	{
+		std::vector<gsl::byte> result(size);
+
+		for (std::size_t i = 0; i < size; i++)
+		{
+			result[i] = static_cast<gsl::byte>((i * seed) >> 3);
+		}
+
+		return result;
+	}
+
+	TEST_METHOD(capture_roundtrip)
+	{
+		const std::string path = fs::get_config_dir() + "rsx_capture_test.rcap";
+
+		{
+			frame_capture_data capture;
+			capture.reset(path);
+
+			for (u32 i = 0; i < 20; i++)
+			{
+				frame_capture_data::draw_state state = {};
+				state.name = fmt::format("Draw %d", i);
+				state.width = 1280;
+				state.height = 720;
+
+				// The color buffer changes every 5 draw calls, the depth buffer never changes
+				frame_capture_data::draw_buffers buffers;
+				buffers.color_buffer[0] = make_buffer(1280 * 720 * 4, 1 + i / 5);
+				buffers.depth_stencil[0] = make_buffer(1280 * 720 * 4, 3);
+
+				capture.add_draw_call(std::move(state), std::move(buffers));
+				capture.command_queue.emplace_back(i, i * 2);
+			}
+
+			capture.finish();
+		}
+
+		frame_capture_data capture;
+
+		if (!capture.load(path) || capture.draw_calls.size() != 20 || capture.command_queue.size() != 20)
+		{
+			TEST_FAILURE("Failed to load %s", path);
+		}
+
+		for (u32 i = 0; i < 20; i++)
+		{
+			const auto& state = capture.draw_calls[i];
+
+			if (state.name != fmt::format("Draw %d", i) || state.width != 1280 || state.color_buffer[1] || state.index)
+			{
+				TEST_FAILURE("Unexpected draw state %d", i);
+			}
+
+			if (capture.get_blob(state.color_buffer[0]) != make_buffer(1280 * 720 * 4, 1 + i / 5) || capture.get_blob(state.depth_stencil[0]) != make_buffer(1280 * 720 * 4, 3))
+			{
+				TEST_FAILURE("Unexpected buffer data (draw %d)", i);
+			}
+		}
+
+		// Unchanged buffers are stored once
+		if (fs::file(path).size() > 1024 * 1024)
+		{
+			TEST_FAILURE("Capture file is too big (%d bytes)", fs::file(path).size());
+		}
+
+		fs::remove_file(path);
+	}
+};
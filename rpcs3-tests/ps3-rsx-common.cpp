@@ -1,5 +1,9 @@
 #include "stdafx.h"
 #include "Emu\RSX\Common\BufferUtils.h"
+#include "Emu\RSX\Common\ProgramStateCache.h"
+#include "Emu\RSX\rsx_utils.h"
+
+#include <chrono>
 
 
 TEST_CLASS(rsx_common)
@@ -12,4 +16,177 @@ TEST_CLASS(rsx_common)
 
 		write_vertex_array_data_to_buffer(gsl::span<gsl::byte>(dest_buffer), src_buffer.data(), 0, 550, rsx::vertex_base_type::ub256, 4, 20);
 	}
+
+	// Fragment programs differing only by inline constants must share the fingerprint
+	TEST_METHOD(fragment_program_fingerprint)
+	{
+		using program_hash_util::fragment_program_utils;
+
+		// MOV R0, c[0]; END with constant slot, then MOV R0, R1; END
+		u32 ucode1[12] = { 0x0, 0x200, 0x0, 0x0, 0x3f800000, 0x0, 0x0, 0x3f800000, 0x100, 0x4, 0x0, 0x0 };
+		u32 ucode2[12] = { 0x0, 0x200, 0x0, 0x0, 0x0, 0x3f000000, 0x0, 0x0, 0x100, 0x4, 0x0, 0x0 };
+		u32 ucode3[12] = { 0x0, 0x200, 0x0, 0x0, 0x3f800000, 0x0, 0x0, 0x3f800000, 0x100, 0x8, 0x0, 0x0 };
+
+		const u64 hash1 = fragment_program_utils::get_fragment_program_ucode_hash(ucode1);
+
+		if (hash1 != fragment_program_utils::get_fragment_program_ucode_hash(ucode2))
+		{
+			TEST_FAILURE("Inline constants changed the fingerprint");
+		}
+
+		if (hash1 == fragment_program_utils::get_fragment_program_ucode_hash(ucode3))
+		{
+			TEST_FAILURE("Different instructions share the fingerprint");
+		}
+	}
+
+	// Reference morton addressing (texel by texel, as previously done in convert_linear_swizzle)
+	static u32 swizzled_offset(u32 x, u32 y, u32 width, u32 height)
+	{
+		u32 result = 0;
+		u32 bit = 0;
+
+		for (u32 i = 0; (1u << i) < width || (1u << i) < height; i++)
+		{
+			if ((1u << i) < width && (1u << i) < height)
+			{
+				result |= ((x >> i) & 1) << bit++;
+				result |= ((y >> i) & 1) << bit++;
+			}
+			else if ((1u << i) < width)
+			{
+				result |= ((x >> i) & 1) << bit++;
+			}
+			else
+			{
+				result |= ((y >> i) & 1) << bit++;
+			}
+		}
+
+		return result;
+	}
+
+	TEST_METHOD(swizzle_matches_reference)
+	{
+		std::mt19937 rng(4);
+
+		for (u32 texel_size : { 1, 2, 4, 8, 16 })
+		{
+			for (u32 width : { 1, 2, 4, 8, 32, 256 })
+			{
+				for (u32 height : { 1, 2, 4, 16, 128 })
+				{
+					const u32 pitch = width + 3;
+					std::vector<u8> swizzled(width * height * texel_size);
+					std::vector<u8> linear(pitch * height * texel_size);
+					std::vector<u8> expected(linear.size());
+
+					for (auto& v : swizzled)
+					{
+						v = (u8)rng();
+					}
+
+					for (u32 y = 0; y < height; y++)
+					{
+						for (u32 x = 0; x < width; x++)
+						{
+							memcpy(&expected[(y * pitch + x) * texel_size], &swizzled[swizzled_offset(x, y, width, height) * texel_size], texel_size);
+						}
+					}
+
+					rsx::convert_linear_swizzle(swizzled.data(), linear.data(), texel_size, width, height, pitch, true);
+
+					if (linear != expected)
+					{
+						TEST_FAILURE("Unswizzle mismatch (texel_size=%d, width=%d, height=%d)", texel_size, width, height);
+					}
+
+					std::vector<u8> result(swizzled.size());
+					rsx::convert_linear_swizzle(linear.data(), result.data(), texel_size, width, height, pitch, false);
+
+					if (result != swizzled)
+					{
+						TEST_FAILURE("Swizzle mismatch (texel_size=%d, width=%d, height=%d)", texel_size, width, height);
+					}
+				}
+			}
+		}
+	}
+
+	TEST_METHOD(byteswap_copy)
+	{
+		be_t<u16> src16[37];
+		be_t<u64> src64[11];
+		u16 dst16[37];
+		u64 dst64[11];
+
+		for (u32 i = 0; i < 37; i++)
+		{
+			src16[i] = i * 0x0101 + 0x1234;
+		}
+
+		for (u32 i = 0; i < 11; i++)
+		{
+			src64[i] = i * 0x0101010101010101ull + 0x123456789abcdef0ull;
+		}
+
+		rsx::copy_byteswapped(dst16, src16, sizeof(u16), 37);
+		rsx::copy_byteswapped(dst64, src64, sizeof(u64), 11);
+
+		for (u32 i = 0; i < 37; i++)
+		{
+			if (dst16[i] != src16[i])
+			{
+				TEST_FAILURE("16-bit byteswap mismatch at %d", i);
+			}
+		}
+
+		for (u32 i = 0; i < 11; i++)
+		{
+			if (dst64[i] != src64[i])
+			{
+				TEST_FAILURE("64-bit byteswap mismatch at %d", i);
+			}
+		}
+	}
+
+	// Unswizzle every texel size and square size from 16x16 to 2048x2048, and compare timing with texel by texel addressing
+	TEST_METHOD(swizzle_benchmark)
+	{
+		for (u32 texel_size : { 1, 2, 4, 8, 16 })
+		{
+			for (u32 size = 16; size <= 2048; size *= 4)
+			{
+				std::vector<u8> swizzled(size * size * texel_size);
+				std::vector<u8> linear(swizzled.size());
+
+				const u32 iterations = std::max<u32>(1, (1 << 22) / (size * size));
+
+				auto start = std::chrono::high_resolution_clock::now();
+
+				for (u32 n = 0; n < iterations; n++)
+				{
+					for (u32 y = 0; y < size; y++)
+					{
+						for (u32 x = 0; x < size; x++)
+						{
+							memcpy(&linear[(y * size + x) * texel_size], &swizzled[swizzled_offset(x, y, size, size) * texel_size], texel_size);
+						}
+					}
+				}
+
+				const auto scalar_time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+				start = std::chrono::high_resolution_clock::now();
+
+				for (u32 n = 0; n < iterations; n++)
+				{
+					rsx::convert_linear_swizzle(swizzled.data(), linear.data(), texel_size, size, size, size, true);
+				}
+
+				const auto simd_time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+
+				TEST_LOG("texel %d bytes, %dx%d x %d: reference %lld us, converter %lld us\n", texel_size, size, size, iterations, scalar_time, simd_time);
+			}
+		}
+	}
 };
@@ -0,0 +1,180 @@
+#include "stdafx.h"
+#include "Emu\IdManager.h"
+#include "Emu\Cell\SPUThread.h"
+#include "Emu\Cell\SPUInterpreter.h"
+
+#include <chrono>
+#include <thread>
+
+TEST_CLASS(spu_interpreter_test)
+{
+	// Instruction encoders (RR, RI7, RI10, RI16 and RRR forms)
+	static u32 rr(u32 op, u32 rt, u32 ra, u32 rb) { return op << 21 | rb << 14 | ra << 7 | rt; }
+	static u32 ri7(u32 op, u32 rt, u32 ra, u32 i7) { return op << 21 | (i7 & 0x7f) << 14 | ra << 7 | rt; }
+	static u32 ri10(u32 op, u32 rt, u32 ra, s32 si10) { return op << 24 | (si10 & 0x3ff) << 14 | ra << 7 | rt; }
+	static u32 ri16(u32 op, u32 rt, s32 i16) { return op << 23 | (i16 & 0xffff) << 7 | rt; }
+	static u32 rrr(u32 op, u32 rt, u32 ra, u32 rb, u32 rc) { return op << 28 | rt << 21 | rb << 14 | ra << 7 | rc; }
+
+	// HLE hook used to return control to the test (the thread stops at the hooked instruction)
+	static bool stop_hook(SPUThread& spu)
+	{
+		spu.stop();
+		return false;
+	}
+
+	static void write_code(SPUThread& spu, u32 lsa, std::initializer_list<u32> code)
+	{
+		for (u32 op : code)
+		{
+			spu._ref<u32>(lsa) = op;
+			lsa += 4;
+		}
+	}
+
+	// Execute the SPU thread from pc until it stops
+	static void run(SPUThread& spu, u32 pc)
+	{
+		spu.pc = pc;
+		spu.exec();
+
+		const auto start = std::chrono::steady_clock::now();
+
+		while (!spu.is_stopped())
+		{
+			if (std::chrono::steady_clock::now() - start > std::chrono::seconds(30))
+			{
+				TEST_FAILURE("SPU thread timeout (pc=0x%x)", spu.pc);
+			}
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
+
+	// Synthetic kernel: integer and float arithmetic in a counted loop, ends with a stop hook
+	static void write_kernel(SPUThread& spu, u32 count)
+	{
+		write_code(spu, 0,
+		{
+			ri16(0x82, 3, count >> 16), // ILHU r3, count >> 16
+			ri16(0xc1, 3, count & 0xffff), // IOHL r3, count & 0xffff
+			ri16(0x81, 4, 1), // IL r4, 1
+			ri16(0x81, 5, 3), // IL r5, 3
+			rr(0xc0, 6, 6, 4), // A r6, r6, r4
+			rr(0x241, 7, 7, 6), // XOR r7, r7, r6
+			rr(0xc1, 8, 7, 5), // AND r8, r7, r5
+			ri7(0x7b, 9, 6, 3), // SHLI r9, r6, 3
+			rr(0x3c0, 10, 9, 8), // CEQ r10, r9, r8
+			rr(0x2c4, 11, 4, 5), // FA r11, r4, r5
+			rr(0x2c6, 12, 11, 5), // FM r12, r11, r5
+			rrr(0xe, 13, 12, 5, 13), // FMA r13, r12, r5, r13
+			ri10(0x1c, 3, 3, -1), // AI r3, r3, -1
+			ri16(0x42, 3, -9), // BRNZ r3, loop
+		});
+
+		spu.RegisterHleFunction(14 * 4, stop_hook);
+	}
+
+	TEST_METHOD(decoder_cache_matches_table)
+	{
+		setup_ps3_environment();
+		Emu.SetTestMode();
+
+		const auto spu = idm::make_ptr<SPUThread>("test", 0);
+
+		const u32 count = 3000000;
+		write_kernel(*spu, count);
+
+		const auto measure = [&](std::array<v128, 128>& result)
+		{
+			spu->gpr = {};
+
+			const auto start = std::chrono::high_resolution_clock::now();
+			run(*spu, 0);
+			const auto time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+
+			result = spu->gpr;
+			return time;
+		};
+
+		std::array<v128, 128> table_gpr, cached_gpr;
+
+		// Without the decoder cache cpu_task dispatches every instruction through the opcode table
+		fxm::remove<spu_decoder_cache_t>();
+		const auto table_time = measure(table_gpr);
+
+		const auto decoder_cache = fxm::make_always<spu_decoder_cache_t>();
+		const auto cached_time = measure(cached_gpr);
+
+		if (!(decoder_cache->pages[spu->offset / 4096] & spu_decoder_cache_t::page_decoded))
+		{
+			TEST_FAILURE("LS page 0x%x was not decoded", spu->offset);
+		}
+
+		if (memcmp(table_gpr.data(), cached_gpr.data(), sizeof(table_gpr)) != 0)
+		{
+			TEST_FAILURE("Register state mismatch (%s)", "cached vs table");
+		}
+
+		const double instructions = count * 10.0 + 4;
+		const auto mips = [&](long long time) { return time ? instructions / time : 0.0; };
+
+		TEST_LOG("%.0f instructions: table %.1f MIPS, cached %.1f MIPS\n", instructions, mips(table_time), mips(cached_time));
+
+		idm::remove<SPUThread>(spu->get_id());
+		fxm::remove<spu_decoder_cache_t>();
+	}
+
+	TEST_METHOD(decoder_cache_self_modifying_code)
+	{
+		setup_ps3_environment();
+		Emu.SetTestMode();
+
+		const auto decoder_cache = fxm::make_always<spu_decoder_cache_t>();
+		const auto spu = idm::make_ptr<SPUThread>("test", 0);
+
+		const u32 il_r3_1 = ri16(0x81, 3, 1);
+		const u32 il_r3_2 = ri16(0x81, 3, 2);
+
+		// first page: the instruction patched by the second page (four copies, STQD writes 16 bytes)
+		write_code(*spu, 0, { il_r3_1, il_r3_1, il_r3_1, il_r3_1 });
+		spu->RegisterHleFunction(0x10, stop_hook);
+
+		// second page: write IL r3, 2 over the decoded page and execute it
+		write_code(*spu, 0x1000,
+		{
+			ri16(0x82, 4, il_r3_2 >> 16), // ILHU r4, hi
+			ri16(0xc1, 4, il_r3_2 & 0xffff), // IOHL r4, lo
+			ri16(0x81, 5, 0), // IL r5, 0
+			ri10(0x24, 4, 5, 0), // STQD r4, 0(r5)
+			ri16(0x60, 0, 0), // BRA 0
+		});
+
+		run(*spu, 0);
+
+		if (spu->gpr[3]._u32[3] != 1 || !(decoder_cache->pages[spu->offset / 4096] & spu_decoder_cache_t::page_decoded))
+		{
+			TEST_FAILURE("First run failed (r3=%d)", spu->gpr[3]._u32[3]);
+		}
+
+		// the store to the decoded (write-protected) page must discard its decoded instructions
+		run(*spu, 0x1000);
+
+		if (spu->_ref<u32>(0) != il_r3_2)
+		{
+			TEST_FAILURE("LS was not written (0x%08x)", spu->_ref<u32>(0).value());
+		}
+
+		if (spu->gpr[3]._u32[3] != 2)
+		{
+			TEST_FAILURE("Stale decoded instruction executed (r3=%d)", spu->gpr[3]._u32[3]);
+		}
+
+		if (!(decoder_cache->pages[spu->offset / 4096] & spu_decoder_cache_t::page_decoded))
+		{
+			TEST_FAILURE("LS page 0x%x was not decoded again", spu->offset);
+		}
+
+		idm::remove<SPUThread>(spu->get_id());
+		fxm::remove<spu_decoder_cache_t>();
+	}
+};
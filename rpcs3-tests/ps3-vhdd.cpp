@@ -0,0 +1,241 @@
+#include "stdafx.h"
+#include "Emu\HDD\HDD.h"
+
+#include <chrono>
+
+TEST_CLASS(vhdd_test)
+{
+	static std::vector<u8> make_data(std::size_t size, u8 seed)
+	{
+		std::vector<u8> data(size);
+
+		for (std::size_t i = 0; i < data.size(); i++)
+		{
+			data[i] = static_cast<u8>(i * seed + i / 2048);
+		}
+
+		return data;
+	}
+
+	static void write_file(vfsHDD& hdd, const std::string& name, const std::vector<u8>& data)
+	{
+		if (!hdd.Create(vfsHDD_Entry_File, name) || !hdd.Open(name, fom::write))
+		{
+			TEST_FAILURE("Failed to create %s", name);
+		}
+
+		if (hdd.Write(data.data(), data.size()) != data.size())
+		{
+			TEST_FAILURE("Failed to write %s", name);
+		}
+
+		hdd.Close();
+	}
+
+	static void check_file(const std::string& path, const std::string& name, const std::vector<u8>& data)
+	{
+		vfsHDD hdd(nullptr, path);
+
+		std::vector<u8> result(data.size());
+
+		if (!hdd.Open(name) || hdd.GetSize() != data.size() || hdd.Read(result.data(), result.size()) != data.size() || result != data)
+		{
+			TEST_FAILURE("%s: data mismatch", name);
+		}
+	}
+
+	// Convert the image to version 1 (no allocation bitmap, blocks in use are only marked in their headers)
+	static void downgrade(const std::string& path)
+	{
+		vfsHDD_Hdr hdr;
+
+		{
+			fs::file f(path, fom::read | fom::write);
+
+			if (!f || f.read(&hdr, sizeof(vfsHDD_Hdr)) != sizeof(vfsHDD_Hdr))
+			{
+				TEST_FAILURE("Failed to read the header of %s", path);
+			}
+
+			hdr.version = 0x0001;
+			hdr.block_count = hdr.bitmap_block;
+			hdr.bitmap_block = 0;
+
+			f.seek(0);
+			f.write(&hdr, sizeof(vfsHDD_Hdr));
+		}
+
+		fs::truncate_file(path, hdr.block_count * hdr.block_size);
+	}
+
+	TEST_METHOD(file_roundtrip)
+	{
+		const std::string path = fs::get_config_dir() + "vhdd_test.hdd";
+
+		vfsHDDManager::CreateHDD(path, 64 * 1024 * 1024, 2048);
+
+		std::vector<u8> data(8 * 1024 * 1024);
+
+		for (std::size_t i = 0; i < data.size(); i++)
+		{
+			data[i] = static_cast<u8>(i * 7 + i / 4096);
+		}
+
+		const auto start = std::chrono::high_resolution_clock::now();
+
+		{
+			vfsHDD hdd(nullptr, path);
+
+			if (!hdd.Create(vfsHDD_Entry_File, "data.bin") || !hdd.Open("data.bin", fom::write))
+			{
+				TEST_FAILURE("Failed to create %s", "data.bin");
+			}
+
+			// small writes as done by VHDDManager import
+			for (std::size_t i = 0; i < data.size(); i += 256)
+			{
+				hdd.Write(data.data() + i, 256);
+			}
+
+			hdd.Close();
+		}
+
+		const auto written = std::chrono::high_resolution_clock::now();
+
+		{
+			vfsHDD hdd(nullptr, path);
+
+			if (!hdd.Open("data.bin"))
+			{
+				TEST_FAILURE("Failed to open %s", "data.bin");
+			}
+
+			std::vector<u8> result(data.size());
+
+			if (hdd.GetSize() != data.size() || hdd.Read(result.data(), result.size()) != data.size() || result != data)
+			{
+				TEST_FAILURE("Data mismatch (size=0x%llx)", hdd.GetSize());
+			}
+
+			// seek into the middle of a block
+			u8 value;
+
+			if (!hdd.Seek(5000001) || hdd.Read(&value, 1) != 1 || value != data[5000001])
+			{
+				TEST_FAILURE("Seek failed (pos=%d)", 5000001);
+			}
+		}
+
+		const auto read = std::chrono::high_resolution_clock::now();
+
+		fs::remove_file(path);
+
+		const auto ms = [](auto duration) { return std::chrono::duration_cast<std::chrono::milliseconds>(duration).count(); };
+
+		TEST_LOG("8 MB file: write %lld ms, read %lld ms\n", ms(written - start), ms(read - written));
+	}
+
+	TEST_METHOD(upgrade_version1)
+	{
+		const std::string path = fs::get_config_dir() + "vhdd_test_v1.hdd";
+
+		vfsHDDManager::CreateHDD(path, 16 * 1024 * 1024, 2048);
+
+		const auto old_data = make_data(1024 * 1024, 7);
+		const auto new_data = make_data(4 * 1024 * 1024, 13);
+
+		{
+			vfsHDD hdd(nullptr, path);
+			write_file(hdd, "old.bin", old_data);
+		}
+
+		downgrade(path);
+
+		// blocks of the existing file must be marked in use by the upgrade, otherwise they're reused for the new file
+		{
+			vfsHDD hdd(nullptr, path);
+			write_file(hdd, "new.bin", new_data);
+		}
+
+		fs::file f(path);
+		vfsHDD_Hdr hdr;
+
+		if (!f || f.read(&hdr, sizeof(vfsHDD_Hdr)) != sizeof(vfsHDD_Hdr) || hdr.version != g_hdd_version || !hdr.bitmap_block)
+		{
+			TEST_FAILURE("Image was not upgraded (version 0x%x)", hdr.version);
+		}
+
+		f.close();
+
+		check_file(path, "old.bin", old_data);
+		check_file(path, "new.bin", new_data);
+
+		fs::remove_file(path);
+	}
+
+	TEST_METHOD(removed_blocks_stay_free)
+	{
+		const std::string path = fs::get_config_dir() + "vhdd_test_remove.hdd";
+
+		vfsHDDManager::CreateHDD(path, 16 * 1024 * 1024, 2048);
+
+		// two files of this size don't fit in the image
+		const auto data = make_data(10 * 1024 * 1024, 11);
+
+		{
+			vfsHDD hdd(nullptr, path);
+			write_file(hdd, "first.bin", data);
+
+			if (!hdd.RemoveEntry("first.bin"))
+			{
+				TEST_FAILURE("Failed to remove %s", "first.bin");
+			}
+		}
+
+		// the bitmap is rebuilt from the block headers, so removed blocks must be marked free in their headers
+		downgrade(path);
+
+		{
+			vfsHDD hdd(nullptr, path);
+			write_file(hdd, "second.bin", data);
+		}
+
+		check_file(path, "second.bin", data);
+
+		fs::remove_file(path);
+	}
+
+	TEST_METHOD(shared_block_map)
+	{
+		const std::string path = fs::get_config_dir() + "vhdd_test_shared.hdd";
+
+		vfsHDDManager::CreateHDD(path, 16 * 1024 * 1024, 2048);
+
+		const auto data_a = make_data(1024 * 1024, 3);
+		const auto data_b = make_data(1024 * 1024, 5);
+
+		{
+			// two files written at the same time through different instances
+			vfsHDD a(nullptr, path), b(nullptr, path);
+
+			if (!a.Create(vfsHDD_Entry_File, "a.bin") || !a.Open("a.bin", fom::write) || !b.Create(vfsHDD_Entry_File, "b.bin") || !b.Open("b.bin", fom::write))
+			{
+				TEST_FAILURE("Failed to create %s", "a.bin, b.bin");
+			}
+
+			for (std::size_t i = 0; i < data_a.size(); i += 0x10000)
+			{
+				a.Write(data_a.data() + i, 0x10000);
+				b.Write(data_b.data() + i, 0x10000);
+			}
+
+			a.Close();
+			b.Close();
+		}
+
+		check_file(path, "a.bin", data_a);
+		check_file(path, "b.bin", data_b);
+
+		fs::remove_file(path);
+	}
+};
@@ -0,0 +1,160 @@
+#include "stdafx.h"
+#include "Emu\Video\VideoConvert.h"
+
+TEST_CLASS(video_convert_test)
+{
+	struct color_sample
+	{
+		video_convert::color_matrix matrix;
+		u8 y, u, v;
+		u8 r, g, b;
+	};
+
+	TEST_METHOD(rgb32_known_colors)
+	{
+		using video_convert::color_matrix;
+
+		// Broadcast range color bars and their expected RGB values
+		static const color_sample samples[] =
+		{
+			{ color_matrix::bt601, 16, 128, 128, 0, 0, 0 },
+			{ color_matrix::bt601, 235, 128, 128, 255, 255, 255 },
+			{ color_matrix::bt601, 126, 128, 128, 128, 128, 128 },
+			{ color_matrix::bt601, 81, 90, 240, 255, 0, 0 },
+			{ color_matrix::bt601, 145, 54, 34, 0, 255, 1 },
+			{ color_matrix::bt601, 41, 240, 110, 0, 0, 255 },
+			{ color_matrix::bt709, 16, 128, 128, 0, 0, 0 },
+			{ color_matrix::bt709, 235, 128, 128, 255, 255, 255 },
+			{ color_matrix::bt709, 63, 102, 240, 255, 1, 0 },
+			{ color_matrix::bt709, 173, 42, 26, 0, 255, 1 },
+			{ color_matrix::bt709, 32, 240, 118, 1, 0, 255 },
+		};
+
+		// Odd width: two SIMD blocks, then the scalar path including the last column
+		const u32 width = 35, height = 3;
+		const u32 uv_width = (width + 1) / 2, uv_height = (height + 1) / 2;
+
+		for (const auto& s : samples)
+		{
+			const std::vector<u8> y(width * height, s.y);
+			const std::vector<u8> u(uv_width * uv_height, s.u);
+			const std::vector<u8> v(uv_width * uv_height, s.v);
+
+			std::vector<u8> rgba(width * height * 4);
+			std::vector<u8> argb(width * height * 4);
+
+			video_convert::yuv420_to_rgb32(rgba.data(), width * 4, y.data(), width, u.data(), v.data(), uv_width, width, height, video_convert::rgb_format::rgba, s.matrix, 0x80);
+			video_convert::yuv420_to_rgb32(argb.data(), width * 4, y.data(), width, u.data(), v.data(), uv_width, width, height, video_convert::rgb_format::argb, s.matrix, 0x80);
+
+			for (u32 i = 0; i < width * height; i++)
+			{
+				const u8* p = &rgba[i * 4];
+				const u8* q = &argb[i * 4];
+
+				if (p[0] != s.r || p[1] != s.g || p[2] != s.b || p[3] != 0x80)
+				{
+					TEST_FAILURE("RGBA mismatch at pixel %d for YUV(%d, %d, %d): got (%d, %d, %d, %d)", i, s.y, s.u, s.v, p[0], p[1], p[2], p[3]);
+				}
+
+				if (q[0] != 0x80 || q[1] != s.r || q[2] != s.g || q[3] != s.b)
+				{
+					TEST_FAILURE("ARGB mismatch at pixel %d for YUV(%d, %d, %d): got (%d, %d, %d, %d)", i, s.y, s.u, s.v, q[0], q[1], q[2], q[3]);
+				}
+			}
+		}
+	}
+
+	TEST_METHOD(rgb32_chroma_per_pixel_pair)
+	{
+		// Each chroma sample covers two columns and two rows, the last odd column uses its own sample
+		const u32 width = 19, height = 2;
+		const u32 uv_width = (width + 1) / 2;
+
+		const std::vector<u8> y(width * height, 126);
+		std::vector<u8> u(uv_width, 128);
+		std::vector<u8> v(uv_width, 128);
+
+		// Red-ish color in the last chroma sample only
+		u[uv_width - 1] = 90;
+		v[uv_width - 1] = 240;
+
+		std::vector<u8> out(width * height * 4);
+		video_convert::yuv420_to_rgb32(out.data(), width * 4, y.data(), width, u.data(), v.data(), uv_width, width, height, video_convert::rgb_format::rgba, video_convert::color_matrix::bt601, 0xff);
+
+		for (u32 row = 0; row < height; row++)
+		{
+			for (u32 x = 0; x < width; x++)
+			{
+				const u8* p = &out[(row * width + x) * 4];
+				const bool red = x == width - 1;
+
+				if (red ? p[0] != 255 || p[1] != 52 || p[2] != 51 : p[0] != 128 || p[1] != 128 || p[2] != 128)
+				{
+					TEST_FAILURE("Unexpected color at (%d, %d): (%d, %d, %d)", x, row, p[0], p[1], p[2]);
+				}
+			}
+		}
+	}
+
+	TEST_METHOD(uyvy422_odd_width)
+	{
+		const u32 width = 21, height = 3;
+		const u32 uv_width = (width + 1) / 2, uv_height = (height + 1) / 2;
+
+		std::vector<u8> y(width * height), u(uv_width * uv_height), v(uv_width * uv_height);
+
+		for (u32 i = 0; i < y.size(); i++) y[i] = i;
+		for (u32 i = 0; i < u.size(); i++) u[i] = 0x80 + i;
+		for (u32 i = 0; i < v.size(); i++) v[i] = 0xc0 + i;
+
+		// one guard byte after the picture
+		std::vector<u8> out(width * height * 2 + 1, 0xcd);
+		video_convert::yuv420_to_uyvy422(out.data(), width * 2, y.data(), width, u.data(), v.data(), uv_width, width, height);
+
+		for (u32 row = 0; row < height; row++)
+		{
+			for (u32 x = 0; x < width; x++)
+			{
+				const u8* p = &out[(row * width + x) * 2];
+				const u8 c = (x % 2 ? v : u)[(row / 2) * uv_width + x / 2];
+
+				if (p[0] != c || p[1] != y[row * width + x])
+				{
+					TEST_FAILURE("UYVY mismatch at (%d, %d): got (0x%x, 0x%x)", x, row, p[0], p[1]);
+				}
+			}
+		}
+
+		if (out.back() != 0xcd)
+		{
+			TEST_FAILURE("Output overrun (0x%x)", out.back());
+		}
+	}
+
+	TEST_METHOD(copy_yuv420_odd_size)
+	{
+		const u32 width = 5, height = 3, pitch = 8, uv_pitch = 4;
+		const u32 uv_width = 3, uv_height = 2;
+
+		std::vector<u8> y(pitch * height), u(uv_pitch * uv_height), v(uv_pitch * uv_height);
+
+		for (u32 i = 0; i < y.size(); i++) y[i] = i;
+		for (u32 i = 0; i < u.size(); i++) u[i] = 0x40 + i;
+		for (u32 i = 0; i < v.size(); i++) v[i] = 0x80 + i;
+
+		std::vector<u8> out(width * height + uv_width * uv_height * 2 + 1, 0xcd);
+		video_convert::copy_yuv420(out.data(), y.data(), pitch, u.data(), v.data(), uv_pitch, width, height);
+
+		std::vector<u8> expected;
+
+		for (u32 row = 0; row < height; row++) expected.insert(expected.end(), &y[row * pitch], &y[row * pitch] + width);
+		for (u32 row = 0; row < uv_height; row++) expected.insert(expected.end(), &u[row * uv_pitch], &u[row * uv_pitch] + uv_width);
+		for (u32 row = 0; row < uv_height; row++) expected.insert(expected.end(), &v[row * uv_pitch], &v[row * uv_pitch] + uv_width);
+		expected.push_back(0xcd);
+
+		if (out != expected)
+		{
+			TEST_FAILURE("Packed YUV420 mismatch (%d bytes)", out.size());
+		}
+	}
+};
@@ -0,0 +1,231 @@
+#include "stdafx.h"
+#include "Emu\SysCalls\Modules.h"
+#include "Emu\Video\VideoConvert.h"
+
+extern "C"
+{
+#include "libavcodec/avcodec.h"
+#include "libavformat/avformat.h"
+}
+
+#include "Emu\SysCalls\Modules\cellPamf.h"
+#include "Emu\SysCalls\Modules\cellVdec.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+
+TEST_CLASS(video_decode_test)
+{
+	TEST_METHOD(frame_pool_reuses_frames)
+	{
+		VideoDecoder vdec(CELL_VDEC_CODEC_TYPE_AVC, 0, 0, 0, vm::null, 0);
+
+		AVFrame* a = vdec.alloc_frame();
+		AVFrame* b = vdec.alloc_frame();
+
+		if (!a || !b || a == b)
+		{
+			TEST_FAILURE("alloc_frame() returned 0x%x and 0x%x", (u64)a, (u64)b);
+		}
+
+		// Picture buffer as returned by the decoder, with another reference kept like the decoder's buffer pool does
+		a->format = AV_PIX_FMT_YUV420P;
+		a->width = 64;
+		a->height = 32;
+
+		if (av_frame_get_buffer(a, 32) < 0)
+		{
+			TEST_FAILURE("av_frame_get_buffer() failed (%d)", 0);
+		}
+
+		AVBufferRef* picture = av_buffer_ref(a->buf[0]);
+
+		vdec.release_frame(a);
+
+		if (a->buf[0] || a->data[0] || av_buffer_get_ref_count(picture) != 1)
+		{
+			TEST_FAILURE("Released frame still references its picture buffer (refs=%d)", av_buffer_get_ref_count(picture));
+		}
+
+		av_buffer_unref(&picture);
+
+		if (vdec.frame_pool.size() != 1 || vdec.alloc_frame() != a || !vdec.frame_pool.empty())
+		{
+			TEST_FAILURE("Released frame was not reused (pool size %d)", vdec.frame_pool.size());
+		}
+
+		vdec.release_frame(a);
+		vdec.release_frame(b);
+
+		// Pooled frames are freed by the destructor
+		if (vdec.frame_pool.size() != 2)
+		{
+			TEST_FAILURE("Unexpected pool size (%d)", vdec.frame_pool.size());
+		}
+	}
+
+	TEST_METHOD(frame_pool_concurrent_use)
+	{
+		VideoDecoder vdec(CELL_VDEC_CODEC_TYPE_AVC, 0, 0, 0, vm::null, 0);
+
+		// Decoder thread allocates frames while the PPU thread releases pictures (cellVdecGetPicture)
+		const auto worker = [&]()
+		{
+			for (u32 i = 0; i < 100000; i++)
+			{
+				AVFrame* frame = vdec.alloc_frame();
+				frame->pts = i;
+				vdec.release_frame(frame);
+			}
+		};
+
+		std::thread t1(worker), t2(worker);
+		t1.join();
+		t2.join();
+
+		// At most one frame per thread was in use at the same time
+		if (vdec.frame_pool.empty() || vdec.frame_pool.size() > 2)
+		{
+			TEST_FAILURE("Unexpected pool size (%d)", vdec.frame_pool.size());
+		}
+	}
+
+	struct decode_result
+	{
+		u32 frames;
+		int threads;
+		long long time; // microseconds
+	};
+
+	// Decode the whole video stream like the cellVdec thread does (with conversion to ARGB as done by cellVdecGetPicture),
+	// on one thread or with the threading settings of vdecOpen
+	static decode_result decode_stream(const char* path, bool threaded)
+	{
+		AVFormatContext* fmt = nullptr;
+
+		if (avformat_open_input(&fmt, path, nullptr, nullptr) < 0)
+		{
+			TEST_FAILURE("avformat_open_input() failed (%s)", path);
+		}
+
+		avformat_find_stream_info(fmt, nullptr);
+
+		const int stream = av_find_best_stream(fmt, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+
+		if (stream < 0)
+		{
+			avformat_close_input(&fmt);
+			TEST_FAILURE("No video stream found (%s)", path);
+		}
+
+		AVCodecContext* ctx = fmt->streams[stream]->codec;
+		AVCodec* codec = avcodec_find_decoder(ctx->codec_id);
+
+		if (threaded)
+		{
+			VideoDecoder::set_threading(ctx);
+		}
+		else
+		{
+			ctx->thread_count = 1;
+		}
+
+		AVDictionary* opts = nullptr;
+		av_dict_set(&opts, "refcounted_frames", "1", 0);
+
+		if (!codec || avcodec_open2(ctx, codec, &opts) < 0)
+		{
+			av_dict_free(&opts);
+			avformat_close_input(&fmt);
+			TEST_FAILURE("avcodec_open2() failed (%s)", path);
+		}
+
+		av_dict_free(&opts);
+
+		AVFrame* frame = av_frame_alloc();
+		std::vector<u8> argb;
+		decode_result result{};
+
+		const auto convert = [&]()
+		{
+			argb.resize(frame->width * frame->height * 4);
+			video_convert::yuv420_to_rgb32(argb.data(), frame->width * 4, frame->data[0], frame->linesize[0], frame->data[1], frame->data[2], frame->linesize[1],
+				frame->width, frame->height, video_convert::rgb_format::argb, video_convert::color_matrix::bt709, 0xff);
+			av_frame_unref(frame);
+			result.frames++;
+		};
+
+		const auto start = std::chrono::high_resolution_clock::now();
+
+		AVPacket packet;
+		av_init_packet(&packet);
+
+		while (av_read_frame(fmt, &packet) >= 0)
+		{
+			if (packet.stream_index == stream)
+			{
+				int got_picture = 0;
+				avcodec_decode_video2(ctx, frame, &got_picture, &packet);
+
+				if (got_picture)
+				{
+					convert();
+				}
+			}
+
+			av_free_packet(&packet);
+		}
+
+		// Drain pictures delayed by frame threading
+		packet.data = nullptr;
+		packet.size = 0;
+
+		while (true)
+		{
+			int got_picture = 0;
+
+			if (avcodec_decode_video2(ctx, frame, &got_picture, &packet) < 0 || !got_picture)
+			{
+				break;
+			}
+
+			convert();
+		}
+
+		result.threads = ctx->thread_count;
+		result.time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+
+		av_frame_free(&frame);
+		avcodec_close(ctx);
+		avformat_close_input(&fmt);
+		return result;
+	}
+
+	// Set RPCS3_VDEC_BENCH_STREAM to a PAMF/MPEG-PS file (H.264 or MPEG-2) to compare single-threaded and threaded decoding
+	TEST_METHOD(decode_benchmark)
+	{
+		const char* path = std::getenv("RPCS3_VDEC_BENCH_STREAM");
+
+		if (!path || !*path)
+		{
+			TEST_LOG("%s is not set, skipped\n", "RPCS3_VDEC_BENCH_STREAM");
+			return;
+		}
+
+		av_register_all();
+		avcodec_register_all();
+
+		const auto single = decode_stream(path, false);
+		const auto threaded = decode_stream(path, true);
+
+		if (single.frames != threaded.frames)
+		{
+			TEST_FAILURE("Frame count mismatch (%d vs %d)", single.frames, threaded.frames);
+		}
+
+		const auto fps = [](const decode_result& r) { return r.time ? r.frames * 1000000.0 / r.time : 0.0; };
+
+		TEST_LOG("%d frames: 1 thread %.1f fps, %d threads %.1f fps\n", single.frames, fps(single), threaded.threads, fps(threaded));
+	}
+};
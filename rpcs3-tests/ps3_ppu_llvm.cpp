@@ -256,6 +256,62 @@ public:
 		(compiler.*recomp_fn)(args...);
 		builder.CreateRet(builder.getInt32(0));
 
+		return create_executable(std::move(module), executable_map);
+	}
+
+	/// Build a function from guest code like the recompilation engine does (guest registers are promoted to locals).
+	/// Guest memory accesses must be preceded by a store of the modified guest register at offset in PPUThread.
+	static std::pair<std::unique_ptr<llvm::ExecutionEngine>, Executable> build_translated_test(u32 start_address, u32 instruction_count, u32 offset)
+	{
+		LLVMContext &context(getGlobalContext());
+		IRBuilder<> builder(getGlobalContext());
+		std::unordered_map<std::string, void*> executable_map;
+
+		std::unique_ptr<llvm::Module> module = Compiler::create_module(context);
+
+		TestCompiler compiler(&context, &builder, executable_map);
+		compiler.translate_to_llvm_ir(module.get(), "test", start_address, instruction_count);
+
+		Function *function = module->getFunction("test");
+		Value *state = &*function->arg_begin();
+		u32 memory_access_count = 0;
+
+		for (BasicBlock &block_i : *function) {
+			bool is_spilled = false;
+
+			for (Instruction &inst_i : block_i) {
+				Value *ptr = nullptr;
+
+				if (auto store = dyn_cast<StoreInst>(&inst_i)) {
+					ptr = store->getPointerOperand();
+
+					// Store to the guest register in PPUThread
+					auto gep = dyn_cast<GetElementPtrInst>(ptr->stripPointerCasts());
+					if (gep && gep->getPointerOperand() == state && gep->getNumIndices() == 1) {
+						auto index = dyn_cast<ConstantInt>(gep->getOperand(1));
+						is_spilled |= index && index->getZExtValue() == offset;
+					}
+				}
+				else if (auto load = dyn_cast<LoadInst>(&inst_i)) {
+					ptr = load->getPointerOperand();
+				}
+
+				// Guest memory access
+				if (ptr && isa<IntToPtrInst>(ptr->stripPointerCasts())) {
+					Assert::IsTrue(is_spilled, L"Guest register not written back before a memory access");
+					is_spilled = false;
+					memory_access_count++;
+				}
+			}
+		}
+
+		Assert::AreNotEqual(0u, memory_access_count);
+
+		return create_executable(std::move(module), executable_map);
+	}
+
+	static std::pair<std::unique_ptr<llvm::ExecutionEngine>, Executable> create_executable(std::unique_ptr<llvm::Module> module, std::unordered_map<std::string, void*> &executable_map)
+	{
 		Compiler::optimise_module(module.get());
 		llvm::Module *module_ptr = module.get();
 
@@ -957,4 +1013,58 @@ TEST_CLASS(ppu_llvm_test_class)
 	TEST_INSTRUCTION_USING_DETERMINED_INPUT(STSWI4, STSWI, 5u, 23u, 25u);
 	TEST_INSTRUCTION_USING_DETERMINED_INPUT(DCBZ1, DCBZ, 0u, 23u);
 	TEST_INSTRUCTION_USING_DETERMINED_INPUT(DCBZ2, DCBZ, 14u, 23u);
+
+	TEST_METHOD(promoted_registers)
+	{
+		InitializeNativeTarget();
+		InitializeNativeTargetAsmPrinter();
+		InitializeNativeTargetDisassembler();
+
+		Emu.SetTestMode();
+		vm::ps3::init();
+		u32 code_addr = vm::alloc(4096, vm::memory_location_t::main);
+		u32 data_addr = vm::alloc(4096, vm::memory_location_t::main);
+
+		static const u32 code[] = {
+			0x38600005, // li r3, 5
+			0x90640000, // stw r3, 0(r4)
+			0x38630001, // addi r3, r3, 1
+			0x80a40000, // lwz r5, 0(r4)
+			0x90640004, // stw r3, 4(r4)
+		};
+
+		for (u32 i = 0; i < sizeof(code) / 4; i++) {
+			vm::ps3::write32(code_addr + i * 4, code[i]);
+		}
+
+		// r3 is modified before the memory accesses, its value must be in PPUThread if they fault
+		std::pair<std::unique_ptr<llvm::ExecutionEngine>, Executable> build_result = TestCompiler::build_translated_test(code_addr, sizeof(code) / 4, OFFSET_32(PPUThread, GPR[3]));
+
+		PPUThread * s_ppu_state = idm::make_ptr<PPUThread>("Test Thread").get();
+		PPUDecoder decoder(new PPUInterpreter(*s_ppu_state));
+
+		PPUState input;
+		PPUState recomp_output_state;
+		PPUState interp_output_state;
+
+		for (int i = 0; i < 10; i++) {
+			input.SetRandom(data_addr);
+			input.GPR[4] = data_addr;
+
+			input.Store(*s_ppu_state);
+			Assert::AreEqual((u32)ExecutionStatus::ExecutionStatusBlockEnded, build_result.second(s_ppu_state, 0));
+			recomp_output_state.Load(*s_ppu_state, data_addr);
+
+			input.Store(*s_ppu_state);
+			for (u32 op : code) {
+				decoder.Decode(op);
+			}
+			interp_output_state.Load(*s_ppu_state, data_addr);
+
+			Assert::AreEqual(std::string(), StateDiff(recomp_output_state, interp_output_state));
+		}
+
+		vm::dealloc(code_addr, vm::memory_location_t::main);
+		vm::dealloc(data_addr, vm::memory_location_t::main);
+	}
 };
\ No newline at end of file
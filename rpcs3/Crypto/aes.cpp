@@ -55,6 +55,194 @@
 }
 #endif
 
+/*
+ * AES-NI support (detected at runtime)
+ */
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define AESNI_TARGET
+#else
+#include <cpuid.h>
+#define AESNI_TARGET __attribute__((target("sse2,aes")))
+#endif
+#include <wmmintrin.h>
+
+static int aesni_detect( void )
+{
+#if defined(_MSC_VER)
+    int regs[4];
+    __cpuid( regs, 1 );
+    return ( regs[2] & 0x02000000 ) != 0;
+#else
+    unsigned int eax, ebx, ecx, edx;
+    return __get_cpuid( 1, &eax, &ebx, &ecx, &edx ) && ( ecx & bit_AES ) != 0;
+#endif
+}
+
+static const int aesni_supported = aesni_detect();
+
+static int aesni_enabled = aesni_supported;
+
+int aes_use_aesni( int enable )
+{
+    aesni_enabled = enable && aesni_supported;
+    return( aesni_enabled );
+}
+
+/*
+ * The round keys computed by aes_setkey_enc() and aes_setkey_dec() have
+ * the layout expected by AESENC and AESDEC (Equivalent Inverse Cipher).
+ */
+AESNI_TARGET static void aesni_crypt_ecb( const aes_context *ctx,
+                                          int mode,
+                                          const unsigned char input[16],
+                                          unsigned char output[16] )
+{
+    const __m128i *rk = (const __m128i *) ctx->rk;
+    __m128i state = _mm_xor_si128( _mm_loadu_si128( (const __m128i *) input ), _mm_loadu_si128( rk++ ) );
+    int i;
+
+    if( mode == AES_DECRYPT )
+    {
+        for( i = 1; i < ctx->nr; i++ )
+            state = _mm_aesdec_si128( state, _mm_loadu_si128( rk++ ) );
+
+        state = _mm_aesdeclast_si128( state, _mm_loadu_si128( rk ) );
+    }
+    else
+    {
+        for( i = 1; i < ctx->nr; i++ )
+            state = _mm_aesenc_si128( state, _mm_loadu_si128( rk++ ) );
+
+        state = _mm_aesenclast_si128( state, _mm_loadu_si128( rk ) );
+    }
+
+    _mm_storeu_si128( (__m128i *) output, state );
+}
+
+/*
+ * Process four independent blocks at once to hide the AESENC/AESDEC latency
+ */
+AESNI_TARGET static void aesni_crypt_ecb4( const aes_context *ctx,
+                                           int mode,
+                                           __m128i b[4] )
+{
+    const __m128i *rk = (const __m128i *) ctx->rk;
+    __m128i k = _mm_loadu_si128( rk++ );
+    int i;
+
+    b[0] = _mm_xor_si128( b[0], k );
+    b[1] = _mm_xor_si128( b[1], k );
+    b[2] = _mm_xor_si128( b[2], k );
+    b[3] = _mm_xor_si128( b[3], k );
+
+    if( mode == AES_DECRYPT )
+    {
+        for( i = 1; i < ctx->nr; i++ )
+        {
+            k = _mm_loadu_si128( rk++ );
+            b[0] = _mm_aesdec_si128( b[0], k );
+            b[1] = _mm_aesdec_si128( b[1], k );
+            b[2] = _mm_aesdec_si128( b[2], k );
+            b[3] = _mm_aesdec_si128( b[3], k );
+        }
+
+        k = _mm_loadu_si128( rk );
+        b[0] = _mm_aesdeclast_si128( b[0], k );
+        b[1] = _mm_aesdeclast_si128( b[1], k );
+        b[2] = _mm_aesdeclast_si128( b[2], k );
+        b[3] = _mm_aesdeclast_si128( b[3], k );
+    }
+    else
+    {
+        for( i = 1; i < ctx->nr; i++ )
+        {
+            k = _mm_loadu_si128( rk++ );
+            b[0] = _mm_aesenc_si128( b[0], k );
+            b[1] = _mm_aesenc_si128( b[1], k );
+            b[2] = _mm_aesenc_si128( b[2], k );
+            b[3] = _mm_aesenc_si128( b[3], k );
+        }
+
+        k = _mm_loadu_si128( rk );
+        b[0] = _mm_aesenclast_si128( b[0], k );
+        b[1] = _mm_aesenclast_si128( b[1], k );
+        b[2] = _mm_aesenclast_si128( b[2], k );
+        b[3] = _mm_aesenclast_si128( b[3], k );
+    }
+}
+
+/*
+ * AES-NI CBC decryption of whole 64-byte chunks, returns the number of bytes processed
+ */
+AESNI_TARGET static size_t aesni_decrypt_cbc4( const aes_context *ctx,
+                                               size_t length,
+                                               unsigned char iv[16],
+                                               const unsigned char *input,
+                                               unsigned char *output )
+{
+    __m128i last = _mm_loadu_si128( (const __m128i *) iv );
+    __m128i b[4], c[4];
+    size_t done;
+    int i;
+
+    for( done = 0; length - done >= 64; done += 64 )
+    {
+        for( i = 0; i < 4; i++ )
+            b[i] = c[i] = _mm_loadu_si128( (const __m128i *) ( input + done ) + i );
+
+        aesni_crypt_ecb4( ctx, AES_DECRYPT, b );
+
+        _mm_storeu_si128( (__m128i *) ( output + done ) + 0, _mm_xor_si128( b[0], last ) );
+        _mm_storeu_si128( (__m128i *) ( output + done ) + 1, _mm_xor_si128( b[1], c[0] ) );
+        _mm_storeu_si128( (__m128i *) ( output + done ) + 2, _mm_xor_si128( b[2], c[1] ) );
+        _mm_storeu_si128( (__m128i *) ( output + done ) + 3, _mm_xor_si128( b[3], c[2] ) );
+
+        last = c[3];
+    }
+
+    _mm_storeu_si128( (__m128i *) iv, last );
+
+    return( done );
+}
+
+/*
+ * AES-NI CTR encryption of whole 64-byte chunks, returns the number of bytes processed
+ */
+AESNI_TARGET static size_t aesni_crypt_ctr4( const aes_context *ctx,
+                                             size_t length,
+                                             unsigned char nonce_counter[16],
+                                             unsigned char stream_block[16],
+                                             const unsigned char *input,
+                                             unsigned char *output )
+{
+    __m128i b[4];
+    size_t done;
+    int i, j;
+
+    for( done = 0; length - done >= 64; done += 64 )
+    {
+        for( i = 0; i < 4; i++ )
+        {
+            b[i] = _mm_loadu_si128( (const __m128i *) nonce_counter );
+
+            for( j = 16; j > 0; j-- )
+                if( ++nonce_counter[j - 1] != 0 )
+                    break;
+        }
+
+        aesni_crypt_ecb4( ctx, AES_ENCRYPT, b );
+
+        for( i = 0; i < 4; i++ )
+            _mm_storeu_si128( (__m128i *) ( output + done ) + i, _mm_xor_si128( b[i], _mm_loadu_si128( (const __m128i *) ( input + done ) + i ) ) );
+    }
+
+    if( done )
+        _mm_storeu_si128( (__m128i *) stream_block, b[3] );
+
+    return( done );
+}
+
 #if defined(POLARSSL_AES_ROM_TABLES)
 /*
  * Forward S-box
@@ -644,6 +832,12 @@ int aes_crypt_ecb( aes_context *ctx,
     int i;
     uint32_t *RK, X0, X1, X2, X3, Y0, Y1, Y2, Y3;
 
+    if( aesni_enabled )
+    {
+        aesni_crypt_ecb( ctx, mode, input, output );
+        return( 0 );
+    }
+
     RK = ctx->rk;
 
     GET_UINT32_LE( X0, input,  0 ); X0 ^= *RK++;
@@ -746,6 +940,15 @@ int aes_crypt_cbc( aes_context *ctx,
 
     if( mode == AES_DECRYPT )
     {
+        if( aesni_enabled )
+        {
+            size_t done = aesni_decrypt_cbc4( ctx, length, iv, input, output );
+
+            input  += done;
+            output += done;
+            length -= done;
+        }
+
         while( length > 0 )
         {
             memcpy( temp, input, 16 );
@@ -840,6 +1043,15 @@ int aes_crypt_ctr( aes_context *ctx,
     int c, i;
     size_t n = *nc_off;
 
+    if( aesni_enabled && n == 0 )
+    {
+        size_t done = aesni_crypt_ctr4( ctx, length, nonce_counter, stream_block, input, output );
+
+        input  += done;
+        output += done;
+        length -= done;
+    }
+
     while( length-- )
     {
         if( n == 0 ) {
@@ -972,4 +1184,4 @@ void aes_cmac(aes_context *ctx, int length, unsigned char *input, unsigned char
 
     for (i = 0; i < 16; i++)
 		output[i] = X[i];
-}
\ No newline at end of file
+}
\ No newline at end of file
@@ -174,6 +174,13 @@ int aes_crypt_ctr( aes_context *ctx,
 
 void aes_cmac(aes_context *ctx, int length, unsigned char *input, unsigned char *output);
 
+/**
+ * \brief          Enable or disable AES-NI (enabled by default if the CPU supports it)
+ *
+ * \return         1 if AES-NI is used after the call
+ */
+int aes_use_aesni( int enable );
+
 #ifdef __cplusplus
 }
 #endif
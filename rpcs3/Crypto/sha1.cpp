@@ -54,6 +54,217 @@
 }
 #endif
 
+/*
+ * SHA-NI support (detected at runtime)
+ */
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define SHANI_TARGET
+#else
+#include <cpuid.h>
+#define SHANI_TARGET __attribute__((target("sse4.1,sha")))
+#endif
+#include <immintrin.h>
+
+static int shani_detect( void )
+{
+#if defined(_MSC_VER)
+    int regs[4];
+    __cpuid( regs, 0 );
+    if( regs[0] < 7 )
+        return( 0 );
+    __cpuidex( regs, 7, 0 );
+    return ( regs[1] & 0x20000000 ) != 0;
+#else
+    unsigned int eax, ebx, ecx, edx;
+    if( __get_cpuid_max( 0, 0 ) < 7 )
+        return( 0 );
+    __cpuid_count( 7, 0, eax, ebx, ecx, edx );
+    return ( ebx & 0x20000000 ) != 0;
+#endif
+}
+
+static const int shani_supported = shani_detect();
+
+static int shani_enabled = shani_supported;
+
+int sha1_use_shani( int enable )
+{
+    shani_enabled = enable && shani_supported;
+    return( shani_enabled );
+}
+
+SHANI_TARGET static void shani_process( uint32_t state[5], const unsigned char data[64] )
+{
+    const __m128i MASK = _mm_set_epi64x( 0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL );
+    __m128i ABCD, ABCD_SAVE, E0, E0_SAVE, E1;
+    __m128i MSG0, MSG1, MSG2, MSG3;
+
+    ABCD = _mm_shuffle_epi32( _mm_loadu_si128( (const __m128i *) state ), 0x1B );
+    E0 = _mm_set_epi32( state[4], 0, 0, 0 );
+
+    ABCD_SAVE = ABCD;
+    E0_SAVE = E0;
+
+        /* Rounds 0-3 */
+        MSG0 = _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i *) ( data + 0 ) ), MASK );
+        E0 = _mm_add_epi32( E0, MSG0 );
+        E1 = ABCD;
+        ABCD = _mm_sha1rnds4_epu32( ABCD, E0, 0 );
+
+        /* Rounds 4-7 */
+        MSG1 = _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i *) ( data + 16 ) ), MASK );
+        E1 = _mm_sha1nexte_epu32( E1, MSG1 );
+        E0 = ABCD;
+        ABCD = _mm_sha1rnds4_epu32( ABCD, E1, 0 );
+        MSG0 = _mm_sha1msg1_epu32( MSG0, MSG1 );
+
+        /* Rounds 8-11 */
+        MSG2 = _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i *) ( data + 32 ) ), MASK );
+        E0 = _mm_sha1nexte_epu32( E0, MSG2 );
+        E1 = ABCD;
+        ABCD = _mm_sha1rnds4_epu32( ABCD, E0, 0 );
+        MSG1 = _mm_sha1msg1_epu32( MSG1, MSG2 );
+        MSG0 = _mm_xor_si128( MSG0, MSG2 );
+
+        /* Rounds 12-15 */
+        MSG3 = _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i *) ( data + 48 ) ), MASK );
+        E1 = _mm_sha1nexte_epu32( E1, MSG3 );
+        E0 = ABCD;
+        MSG0 = _mm_sha1msg2_epu32( MSG0, MSG3 );
+        ABCD = _mm_sha1rnds4_epu32( ABCD, E1, 0 );
+        MSG2 = _mm_sha1msg1_epu32( MSG2, MSG3 );
+        MSG1 = _mm_xor_si128( MSG1, MSG3 );
+
+        /* Rounds 16-19 */
+        E0 = _mm_sha1nexte_epu32( E0, MSG0 );
+        E1 = ABCD;
+        MSG1 = _mm_sha1msg2_epu32( MSG1, MSG0 );
+        ABCD = _mm_sha1rnds4_epu32( ABCD, E0, 0 );
+        MSG3 = _mm_sha1msg1_epu32( MSG3, MSG0 );
+        MSG2 = _mm_xor_si128( MSG2, MSG0 );
+
+        /* Rounds 20-23 */
+        E1 = _mm_sha1nexte_epu32( E1, MSG1 );
+        E0 = ABCD;
+        MSG2 = _mm_sha1msg2_epu32( MSG2, MSG1 );
+        ABCD = _mm_sha1rnds4_epu32( ABCD, E1, 1 );
+        MSG0 = _mm_sha1msg1_epu32( MSG0, MSG1 );
+        MSG3 = _mm_xor_si128( MSG3, MSG1 );
+
+        /* Rounds 24-27 */
+        E0 = _mm_sha1nexte_epu32( E0, MSG2 );
+        E1 = ABCD;
+        MSG3 = _mm_sha1msg2_epu32( MSG3, MSG2 );
+        ABCD = _mm_sha1rnds4_epu32( ABCD, E0, 1 );
+        MSG1 = _mm_sha1msg1_epu32( MSG1, MSG2 );
+        MSG0 = _mm_xor_si128( MSG0, MSG2 );
+
+        /* Rounds 28-31 */
+        E1 = _mm_sha1nexte_epu32( E1, MSG3 );
+        E0 = ABCD;
+        MSG0 = _mm_sha1msg2_epu32( MSG0, MSG3 );
+        ABCD = _mm_sha1rnds4_epu32( ABCD, E1, 1 );
+        MSG2 = _mm_sha1msg1_epu32( MSG2, MSG3 );
+        MSG1 = _mm_xor_si128( MSG1, MSG3 );
+
+        /* Rounds 32-35 */
+        E0 = _mm_sha1nexte_epu32( E0, MSG0 );
+        E1 = ABCD;
+        MSG1 = _mm_sha1msg2_epu32( MSG1, MSG0 );
+        ABCD = _mm_sha1rnds4_epu32( ABCD, E0, 1 );
+        MSG3 = _mm_sha1msg1_epu32( MSG3, MSG0 );
+        MSG2 = _mm_xor_si128( MSG2, MSG0 );
+
+        /* Rounds 36-39 */
+        E1 = _mm_sha1nexte_epu32( E1, MSG1 );
+        E0 = ABCD;
+        MSG2 = _mm_sha1msg2_epu32( MSG2, MSG1 );
+        ABCD = _mm_sha1rnds4_epu32( ABCD, E1, 1 );
+        MSG0 = _mm_sha1msg1_epu32( MSG0, MSG1 );
+        MSG3 = _mm_xor_si128( MSG3, MSG1 );
+
+        /* Rounds 40-43 */
+        E0 = _mm_sha1nexte_epu32( E0, MSG2 );
+        E1 = ABCD;
+        MSG3 = _mm_sha1msg2_epu32( MSG3, MSG2 );
+        ABCD = _mm_sha1rnds4_epu32( ABCD, E0, 2 );
+        MSG1 = _mm_sha1msg1_epu32( MSG1, MSG2 );
+        MSG0 = _mm_xor_si128( MSG0, MSG2 );
+
+        /* Rounds 44-47 */
+        E1 = _mm_sha1nexte_epu32( E1, MSG3 );
+        E0 = ABCD;
+        MSG0 = _mm_sha1msg2_epu32( MSG0, MSG3 );
+        ABCD = _mm_sha1rnds4_epu32( ABCD, E1, 2 );
+        MSG2 = _mm_sha1msg1_epu32( MSG2, MSG3 );
+        MSG1 = _mm_xor_si128( MSG1, MSG3 );
+
+        /* Rounds 48-51 */
+        E0 = _mm_sha1nexte_epu32( E0, MSG0 );
+        E1 = ABCD;
+        MSG1 = _mm_sha1msg2_epu32( MSG1, MSG0 );
+        ABCD = _mm_sha1rnds4_epu32( ABCD, E0, 2 );
+        MSG3 = _mm_sha1msg1_epu32( MSG3, MSG0 );
+        MSG2 = _mm_xor_si128( MSG2, MSG0 );
+
+        /* Rounds 52-55 */
+        E1 = _mm_sha1nexte_epu32( E1, MSG1 );
+        E0 = ABCD;
+        MSG2 = _mm_sha1msg2_epu32( MSG2, MSG1 );
+        ABCD = _mm_sha1rnds4_epu32( ABCD, E1, 2 );
+        MSG0 = _mm_sha1msg1_epu32( MSG0, MSG1 );
+        MSG3 = _mm_xor_si128( MSG3, MSG1 );
+
+        /* Rounds 56-59 */
+        E0 = _mm_sha1nexte_epu32( E0, MSG2 );
+        E1 = ABCD;
+        MSG3 = _mm_sha1msg2_epu32( MSG3, MSG2 );
+        ABCD = _mm_sha1rnds4_epu32( ABCD, E0, 2 );
+        MSG1 = _mm_sha1msg1_epu32( MSG1, MSG2 );
+        MSG0 = _mm_xor_si128( MSG0, MSG2 );
+
+        /* Rounds 60-63 */
+        E1 = _mm_sha1nexte_epu32( E1, MSG3 );
+        E0 = ABCD;
+        MSG0 = _mm_sha1msg2_epu32( MSG0, MSG3 );
+        ABCD = _mm_sha1rnds4_epu32( ABCD, E1, 3 );
+        MSG2 = _mm_sha1msg1_epu32( MSG2, MSG3 );
+        MSG1 = _mm_xor_si128( MSG1, MSG3 );
+
+        /* Rounds 64-67 */
+        E0 = _mm_sha1nexte_epu32( E0, MSG0 );
+        E1 = ABCD;
+        MSG1 = _mm_sha1msg2_epu32( MSG1, MSG0 );
+        ABCD = _mm_sha1rnds4_epu32( ABCD, E0, 3 );
+        MSG3 = _mm_sha1msg1_epu32( MSG3, MSG0 );
+        MSG2 = _mm_xor_si128( MSG2, MSG0 );
+
+        /* Rounds 68-71 */
+        E1 = _mm_sha1nexte_epu32( E1, MSG1 );
+        E0 = ABCD;
+        MSG2 = _mm_sha1msg2_epu32( MSG2, MSG1 );
+        ABCD = _mm_sha1rnds4_epu32( ABCD, E1, 3 );
+        MSG3 = _mm_xor_si128( MSG3, MSG1 );
+
+        /* Rounds 72-75 */
+        E0 = _mm_sha1nexte_epu32( E0, MSG2 );
+        E1 = ABCD;
+        MSG3 = _mm_sha1msg2_epu32( MSG3, MSG2 );
+        ABCD = _mm_sha1rnds4_epu32( ABCD, E0, 3 );
+
+        /* Rounds 76-79 */
+        E1 = _mm_sha1nexte_epu32( E1, MSG3 );
+        E0 = ABCD;
+        ABCD = _mm_sha1rnds4_epu32( ABCD, E1, 3 );
+
+    E0 = _mm_sha1nexte_epu32( E0, E0_SAVE );
+    ABCD = _mm_add_epi32( ABCD, ABCD_SAVE );
+
+    _mm_storeu_si128( (__m128i *) state, _mm_shuffle_epi32( ABCD, 0x1B ) );
+    state[4] = _mm_extract_epi32( E0, 3 );
+}
+
 /*
  * SHA-1 context setup
  */
@@ -73,6 +284,12 @@ void sha1_process( sha1_context *ctx, const unsigned char data[64] )
 {
     uint32_t temp, W[16], A, B, C, D, E;
 
+    if( shani_enabled )
+    {
+        shani_process( ctx->state, data );
+        return;
+    }
+
     GET_UINT32_BE( W[ 0], data,  0 );
     GET_UINT32_BE( W[ 1], data,  4 );
     GET_UINT32_BE( W[ 2], data,  8 );
@@ -394,4 +611,4 @@ void sha1_hmac( const unsigned char *key, size_t keylen,
     sha1_hmac_finish( &ctx, output );
 
     memset( &ctx, 0, sizeof( sha1_context ) );
-}
\ No newline at end of file
+}
\ No newline at end of file
@@ -158,6 +158,13 @@ void sha1_hmac( const unsigned char *key, size_t keylen,
                 const unsigned char *input, size_t ilen,
                 unsigned char output[20] );
 
+/**
+ * \brief          Enable or disable SHA-NI (enabled by default if the CPU supports it)
+ *
+ * \return         1 if SHA-NI is used after the call
+ */
+int sha1_use_shani( int enable );
+
 #ifdef __cplusplus
 }
 #endif
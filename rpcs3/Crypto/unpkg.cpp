@@ -56,8 +56,142 @@ static bool CheckHeader(const fs::file& pkg_f, PKGHeader& header)
 	return true;
 }
 
+// Thread executing one task at a time, started once per installation
+class pkg_worker final
+{
+	std::mutex m_mutex;
+	std::condition_variable m_cv;
+	std::function<void()> m_task;
+	std::exception_ptr m_exception;
+	bool m_stop = false;
+
+	std::thread m_thread;
+
+public:
+	pkg_worker()
+		: m_thread([this]
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			while (true)
+			{
+				m_cv.wait(lock, [&] { return m_task || m_stop; });
+
+				if (!m_task)
+				{
+					return;
+				}
+
+				lock.unlock();
+
+				try
+				{
+					m_task();
+				}
+				catch (...)
+				{
+					m_exception = std::current_exception();
+				}
+
+				lock.lock();
+				m_task = nullptr;
+				m_cv.notify_all();
+			}
+		})
+	{
+	}
+
+	~pkg_worker()
+	{
+		wait_noexcept();
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stop = true;
+			m_cv.notify_all();
+		}
+
+		m_thread.join();
+	}
+
+	// Start the task (waits for the previous one)
+	void start(std::function<void()> task)
+	{
+		wait();
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_task = std::move(task);
+		m_cv.notify_all();
+	}
+
+	// Wait for the current task and rethrow its exception
+	void wait()
+	{
+		wait_noexcept();
+
+		if (const auto exception = m_exception)
+		{
+			m_exception = nullptr;
+			std::rethrow_exception(exception);
+		}
+	}
+
+private:
+	void wait_noexcept()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_cv.wait(lock, [&] { return !m_task; });
+	}
+};
+
+// Call func(first, count) for consecutive ranges of `count` blocks using the calling thread and the workers
+static void ParallelBlocks(std::vector<std::unique_ptr<pkg_worker>>& workers, u64 count, const std::function<void(u64 first, u64 count)>& func)
+{
+	const u64 min_chunk = 0x4000; // 256 KB
+
+	const u64 threads = std::max<u64>(1, std::min<u64>(workers.size() + 1, count / min_chunk));
+
+	const u64 chunk = (count + threads - 1) / threads;
+
+	u64 used = 0;
+
+	for (u64 first = chunk; first < count; first += chunk)
+	{
+		workers[used++]->start([&func, first, size = std::min<u64>(chunk, count - first)] { func(first, size); });
+	}
+
+	// the workers must complete before func is destroyed, even if some task failed
+	std::exception_ptr exception;
+
+	try
+	{
+		func(0, std::min<u64>(chunk, count));
+	}
+	catch (...)
+	{
+		exception = std::current_exception();
+	}
+
+	for (u64 i = 0; i < used; i++)
+	{
+		try
+		{
+			workers[i]->wait();
+		}
+		catch (...)
+		{
+			exception = std::current_exception();
+		}
+	}
+
+	if (exception)
+	{
+		std::rethrow_exception(exception);
+	}
+}
+
 // PKG Decryption
-bool pkg_install(const fs::file& pkg_f, const std::string& dir, volatile f64& progress)
+bool pkg_install(const fs::file& pkg_f, const std::string& dir, std::atomic<f64>& progress)
 {
 	const std::size_t BUF_SIZE = 8192 * 1024; // 8 MB
 
@@ -78,42 +212,59 @@ bool pkg_install(const fs::file& pkg_f, const std::string& dir, volatile f64& pr
 		return false;
 	}
 
-	// Allocate buffer with BUF_SIZE size or more if required
-	const std::unique_ptr<u128[]> buf(new u128[std::max<u64>(BUF_SIZE, sizeof(PKGEntry) * header.file_count) / sizeof(u128)]);
+	// Allocate two buffers with BUF_SIZE size or more if required (one is decrypted while the other is being written)
+	const std::size_t buf_count = std::max<u64>(BUF_SIZE, sizeof(PKGEntry) * header.file_count) / sizeof(u128);
+
+	const std::unique_ptr<u128[]> bufs[2]{ std::unique_ptr<u128[]>(new u128[buf_count]), std::unique_ptr<u128[]>(new u128[buf_count]) };
+
+	const auto& buf = bufs[0];
+
+	// Decryption threads (in addition to the calling thread) and the thread writing the previous buffer
+	std::vector<std::unique_ptr<pkg_worker>> workers(std::max<u32>(std::thread::hardware_concurrency(), 1) - 1);
+
+	for (auto& worker : workers)
+	{
+		worker = std::make_unique<pkg_worker>();
+	}
+
+	pkg_worker writer;
 
 	// Define decryption subfunction (`psp` arg selects the key for specific block)
-	auto decrypt = [&](u64 offset, u64 size, bool psp) -> u64
+	auto decrypt = [&](u64 offset, u64 size, bool psp, u128* out) -> u64
 	{
 		CHECK_ASSERTION(pkg_f.seek(start_offset + header.data_offset + offset) != -1);
 
 		// Read the data and set available size
-		const u64 read = pkg_f.read(buf.get(), size);
+		const u64 read = pkg_f.read(out, size);
 
 		// Get block count
 		const u64 blocks = (read + 15) / 16;
 
 		if (header.pkg_type == PKG_RELEASE_TYPE_DEBUG)
 		{
-			// Debug key
-			be_t<u64> input[8] =
+			ParallelBlocks(workers, blocks, [&](u64 first, u64 count)
 			{
-				header.qa_digest[0],
-				header.qa_digest[0],
-				header.qa_digest[1],
-				header.qa_digest[1],
-			};
+				// Debug key
+				be_t<u64> input[8] =
+				{
+					header.qa_digest[0],
+					header.qa_digest[0],
+					header.qa_digest[1],
+					header.qa_digest[1],
+				};
 
-			for (u64 i = 0; i < blocks; i++)
-			{
-				// Initialize "debug key" for current position
-				input[7] = offset / 16 + i;
+				for (u64 i = first; i < first + count; i++)
+				{
+					// Initialize "debug key" for current position
+					input[7] = offset / 16 + i;
 
-				u128 key;
-				
-				sha1(reinterpret_cast<const u8*>(input), sizeof(input), reinterpret_cast<u8*>(&key));
+					u128 key;
 
-				buf[i] ^= key;
-			}
+					sha1(reinterpret_cast<const u8*>(input), sizeof(input), reinterpret_cast<u8*>(&key));
+
+					out[i] ^= key;
+				}
+			});
 		}
 
 		if (header.pkg_type == PKG_RELEASE_TYPE_RELEASE)
@@ -123,27 +274,25 @@ bool pkg_install(const fs::file& pkg_f, const std::string& dir, volatile f64& pr
 			// Set decryption key
 			aes_setkey_enc(&ctx, psp ? PKG_AES_KEY2 : PKG_AES_KEY, 128);
 
-			// Initialize "release key" for start position
-			be_t<u128> input = header.klicensee.value() + offset / 16;
-
-			// Increment "release key" for every block
-			for (u64 i = 0; i < blocks; i++, input++)
+			ParallelBlocks(workers, blocks, [&](u64 first, u64 count)
 			{
-				u128 key;
+				// Initialize "release key" for start position, it's incremented for every block (AES-CTR)
+				be_t<u128> input = header.klicensee.value() + offset / 16 + first;
 
-				aes_crypt_ecb(&ctx, AES_ENCRYPT, reinterpret_cast<const u8*>(&input), reinterpret_cast<u8*>(&key));
+				u8 stream_block[16];
+				std::size_t stream_offset = 0;
 
-				buf[i] ^= key;
-			}
+				aes_crypt_ctr(&ctx, count * 16, &stream_offset, reinterpret_cast<u8*>(&input), stream_block, reinterpret_cast<const u8*>(out + first), reinterpret_cast<u8*>(out + first));
+			});
 		}
 
-		// Return the amount of data written in buf
+		// Return the amount of data written in out
 		return read;
 	};
 
 	LOG_SUCCESS(LOADER, "PKG: Installing in %s (%d entries)...", dir, header.file_count);
 
-	decrypt(0, header.file_count * sizeof(PKGEntry), header.pkg_platform == PKG_PLATFORM_TYPE_PSP);
+	decrypt(0, header.file_count * sizeof(PKGEntry), header.pkg_platform == PKG_PLATFORM_TYPE_PSP, buf.get());
 
 	std::vector<PKGEntry> entries(header.file_count);
 
@@ -159,7 +308,7 @@ bool pkg_install(const fs::file& pkg_f, const std::string& dir, volatile f64& pr
 			continue;
 		}
 
-		decrypt(entry.name_offset, entry.name_size, is_psp);
+		decrypt(entry.name_offset, entry.name_size, is_psp, buf.get());
 
 		const std::string name(reinterpret_cast<char*>(buf.get()), entry.name_size);
 
@@ -177,24 +326,62 @@ bool pkg_install(const fs::file& pkg_f, const std::string& dir, volatile f64& pr
 
 			if (fs::file out{ path, fom::write | fom::create | fom::trunc })
 			{
-				for (u64 pos = 0; pos < entry.file_size; pos += BUF_SIZE)
-				{
-					const u64 block_size = std::min<u64>(BUF_SIZE, entry.file_size - pos);
+				// Previous block is written by the writer thread while the next one is decrypted
+				bool written = true;
+				u64 pending = 0;
 
-					if (decrypt(entry.file_offset + pos, block_size, is_psp) != block_size)
+				// Progress is only updated by this thread after the block is written
+				const auto add_progress = [&]()
+				{
+					if (written)
 					{
-						LOG_ERROR(LOADER, "PKG: Failed to extract file %s", path);
-						break;
+						progress = progress + (pending + 0.0) / header.data_size;
 					}
 
-					if (out.write(buf.get(), block_size) != block_size)
+					pending = 0;
+				};
+
+				// the writer thread uses `out`, so it must complete before leaving this scope
+				try
+				{
+					for (u64 pos = 0, index = 0; pos < entry.file_size; pos += BUF_SIZE, index ^= 1)
 					{
-						LOG_ERROR(LOADER, "PKG: Failed to write file %s", path);
-						break;
+						const u64 block_size = std::min<u64>(BUF_SIZE, entry.file_size - pos);
+
+						if (decrypt(entry.file_offset + pos, block_size, is_psp, bufs[index].get()) != block_size)
+						{
+							LOG_ERROR(LOADER, "PKG: Failed to extract file %s", path);
+							break;
+						}
+
+						writer.wait();
+						add_progress();
+
+						if (!written)
+						{
+							break;
+						}
+
+						pending = block_size;
+
+						writer.start([&, block_size, data = bufs[index].get()]
+						{
+							if (out.write(data, block_size) != block_size)
+							{
+								LOG_ERROR(LOADER, "PKG: Failed to write file %s", path);
+								written = false;
+							}
+						});
 					}
-
-					progress += (block_size + 0.0) / header.data_size;
 				}
+				catch (...)
+				{
+					writer.wait();
+					throw;
+				}
+
+				writer.wait();
+				add_progress();
 
 				if (did_overwrite)
 				{
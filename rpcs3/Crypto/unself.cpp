@@ -1017,8 +1017,6 @@ bool SELFDecrypter::LoadMetadata()
 
 bool SELFDecrypter::DecryptData()
 {
-	aes_context aes;
-
 	// Calculate the total data size.
 	for (unsigned int i = 0; i < meta_hdr.section_count; i++)
 	{
@@ -1035,50 +1033,56 @@ bool SELFDecrypter::DecryptData()
 	// Set initial offset.
 	u32 data_buf_offset = 0;
 
+	// Sections are independent, so they are decrypted in parallel while the next one is being read.
+	std::vector<std::future<void>> tasks;
+
 	// Parse the metadata section headers to find the offsets of encrypted data.
 	for (unsigned int i = 0; i < meta_hdr.section_count; i++)
 	{
-		size_t ctr_nc_off = 0;
-		u8 ctr_stream_block[0x10];
-		u8 data_key[0x10];
-		u8 data_iv[0x10];
-
 		// Check if this is an encrypted section.
 		if (meta_shdr[i].encrypted == 3)
 		{
 			// Make sure the key and iv are not out of boundaries.
 			if((meta_shdr[i].key_idx <= meta_hdr.key_count - 1) && (meta_shdr[i].iv_idx <= meta_hdr.key_count))
 			{
-				// Get the key and iv from the previously stored key buffer.
-				memcpy(data_key, data_keys + meta_shdr[i].key_idx * 0x10, 0x10);
-				memcpy(data_iv, data_keys + meta_shdr[i].iv_idx * 0x10, 0x10);
+				u8* const buf = data_buf + data_buf_offset;
+				const u64 size = meta_shdr[i].data_size;
 
-				// Allocate a buffer to hold the data.
-				u8 *buf = (u8 *)malloc(meta_shdr[i].data_size);
-
-				// Seek to the section data offset and read the encrypted data.
+				// Seek to the section data offset and read the encrypted data directly into the output buffer.
 				CHECK_ASSERTION(self_f.Seek(meta_shdr[i].data_offset) != -1);
-				self_f.Read(buf, meta_shdr[i].data_size);
+				self_f.Read(buf, size);
+
+				tasks.emplace_back(std::async(std::launch::async, [=]()
+				{
+					aes_context aes;
+					size_t ctr_nc_off = 0;
+					u8 ctr_stream_block[0x10];
+					u8 data_key[0x10];
+					u8 data_iv[0x10];
 
-				// Zero out our ctr nonce.
-				memset(ctr_stream_block, 0, sizeof(ctr_stream_block));
+					// Get the key and iv from the previously stored key buffer.
+					memcpy(data_key, data_keys + meta_shdr[i].key_idx * 0x10, 0x10);
+					memcpy(data_iv, data_keys + meta_shdr[i].iv_idx * 0x10, 0x10);
 
-				// Perform AES-CTR encryption on the data blocks.
-				aes_setkey_enc(&aes, data_key, 128);
-				aes_crypt_ctr(&aes, meta_shdr[i].data_size, &ctr_nc_off, data_iv, ctr_stream_block, buf, buf);
+					// Zero out our ctr nonce.
+					memset(ctr_stream_block, 0, sizeof(ctr_stream_block));
 
-				// Copy the decrypted data.
-				memcpy(data_buf + data_buf_offset, buf, meta_shdr[i].data_size);
+					// Perform AES-CTR encryption on the data blocks.
+					aes_setkey_enc(&aes, data_key, 128);
+					aes_crypt_ctr(&aes, size, &ctr_nc_off, data_iv, ctr_stream_block, buf, buf);
+				}));
 
 				// Advance the buffer's offset.
 				data_buf_offset += meta_shdr[i].data_size;
-
-				// Release the temporary buffer.
-				free(buf);
 			}
 		}
 	}
 
+	for (auto& task : tasks)
+	{
+		task.get();
+	}
+
 	return true;
 }
 
@@ -1143,7 +1147,9 @@ bool SELFDecrypter::MakeElf(const std::string& elf, bool isElf32)
 			WritePhdr(e, phdr64_arr[i]);
 		}
 
-		// Write data.
+		// Decompress sections in parallel, the data is written in the original order.
+		std::vector<std::future<std::vector<u8>>> decomp_tasks(meta_hdr.section_count);
+
 		for (unsigned int i = 0; i < meta_hdr.section_count; i++)
 		{
 			// PHDR type.
@@ -1152,43 +1158,57 @@ bool SELFDecrypter::MakeElf(const std::string& elf, bool isElf32)
 				// Decompress if necessary.
 				if (meta_shdr[i].compressed == 2)
 				{
-					/// Removed all wxWidget dependent code. Replaced with zlib functions.
-					/// Also changed local mallocs to unique_ptrs.
-
-					// Store the length in writeable memory space.
-					std::unique_ptr<uLongf> decomp_buf_length(new uLongf);
-					memcpy(decomp_buf_length.get(), &phdr64_arr[meta_shdr[i].program_idx].p_filesz, sizeof(uLongf));
+					const u8* const zlib_buf = data_buf + data_buf_offset;
+					const uLong zlib_size = static_cast<uLong>(std::min<u64>(meta_shdr[i].data_size, data_buf_length - data_buf_offset));
+					const uLongf filesz = static_cast<uLongf>(phdr64_arr[meta_shdr[i].program_idx].p_filesz);
 
-					/// Create a pointer to a buffer for decompression.
-					std::unique_ptr<u8[]> decomp_buf(new u8[phdr64_arr[meta_shdr[i].program_idx].p_filesz]);
+					decomp_tasks[i] = std::async(std::launch::async, [=]()
+					{
+						// Create a buffer for decompression.
+						std::vector<u8> decomp_buf(filesz);
+
+						// Use zlib uncompress directly on the decrypted data.
+						// decomp_buf_length changes inside the call to uncompress, so it must be in writeable mem space.
+						uLongf decomp_buf_length = filesz;
+						int rv = uncompress(decomp_buf.data(), &decomp_buf_length, zlib_buf, zlib_size);
+
+						// Check for errors (TODO: Probably safe to remove this once these changes have passed testing.)
+						switch (rv)
+						{
+						case Z_MEM_ERROR:	LOG_ERROR(LOADER, "MakeELF encountered a Z_MEM_ERROR!"); break;
+						case Z_BUF_ERROR:	LOG_ERROR(LOADER, "MakeELF encountered a Z_BUF_ERROR!"); break;
+						case Z_DATA_ERROR:	LOG_ERROR(LOADER, "MakeELF encountered a Z_DATA_ERROR!"); break;
+						default: break;
+						}
+
+						return decomp_buf;
+					});
+				}
 
-					// Create a buffer separate from data_buf to uncompress.
-					std::unique_ptr<u8[]> zlib_buf(new u8[data_buf_length]);
-					memcpy(zlib_buf.get(), data_buf, data_buf_length);
+				// Advance the data buffer offset by data size.
+				data_buf_offset += meta_shdr[i].data_size;
+			}
+		}
 
-					// Use zlib uncompress on the new buffer.
-					// decomp_buf_length changes inside the call to uncompress, so it must be a pointer to correct type (in writeable mem space).
-					int rv = uncompress(decomp_buf.get(), decomp_buf_length.get(), zlib_buf.get() + data_buf_offset, data_buf_length);
+		// Write data.
+		data_buf_offset = 0;
 
-					// Check for errors (TODO: Probably safe to remove this once these changes have passed testing.)
-					switch (rv)
-					{
-					case Z_MEM_ERROR:	LOG_ERROR(LOADER, "MakeELF encountered a Z_MEM_ERROR!"); break;
-					case Z_BUF_ERROR:	LOG_ERROR(LOADER, "MakeELF encountered a Z_BUF_ERROR!"); break;
-					case Z_DATA_ERROR:	LOG_ERROR(LOADER, "MakeELF encountered a Z_DATA_ERROR!"); break;
-					default: break;
-					}
+		for (unsigned int i = 0; i < meta_hdr.section_count; i++)
+		{
+			// PHDR type.
+			if (meta_shdr[i].type == 2)
+			{
+				// Seek to the program header data offset and write the data.
+				CHECK_ASSERTION(e.seek(phdr64_arr[meta_shdr[i].program_idx].p_offset) != -1);
 
-					// Seek to the program header data offset and write the data.
-					CHECK_ASSERTION(e.seek(phdr64_arr[meta_shdr[i].program_idx].p_offset) != -1);
-					e.write(decomp_buf.get(), phdr64_arr[meta_shdr[i].program_idx].p_filesz);
+				if (decomp_tasks[i].valid())
+				{
+					const std::vector<u8> decomp_buf = decomp_tasks[i].get();
 
+					e.write(decomp_buf.data(), decomp_buf.size());
 				}
 				else
 				{
-					// Seek to the program header data offset and write the data.
-					CHECK_ASSERTION(e.seek(phdr64_arr[meta_shdr[i].program_idx].p_offset) != -1);
-					
 					e.write(data_buf + data_buf_offset, meta_shdr[i].data_size);
 				}
 
@@ -0,0 +1,245 @@
+#include "stdafx.h"
+#include "AudioMixer.h"
+
+namespace audio_mixer
+{
+	// Load four big-endian floats
+	static force_inline __m128 load_be(const be_t<f32>* src)
+	{
+		const __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+		return _mm_castsi128_ps(_mm_shuffle_epi8(data, _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3)));
+	}
+
+	// Store four floats as big-endian
+	static force_inline void save_be(be_t<f32>* dst, __m128 value)
+	{
+		const __m128i data = _mm_shuffle_epi8(_mm_castps_si128(value), _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst), data);
+	}
+
+	// Volume for samples i and i + 1 as { v0, v0, v1, v1 }
+	static force_inline __m128 load_vol2(const f32* vol, u32 i, __m128 volume)
+	{
+		if (!vol)
+		{
+			return volume;
+		}
+
+		const __m128 v = _mm_castpd_ps(_mm_load_sd(reinterpret_cast<const f64*>(vol + i)));
+		return _mm_unpacklo_ps(v, v);
+	}
+
+	void mix_to_8ch(f32* dst, const be_t<f32>* src, u32 channels, u32 samples, const f32* vol, f32 volume)
+	{
+		const __m128 fixed = _mm_set1_ps(volume);
+		u32 i = 0;
+
+		switch (channels)
+		{
+		case 1:
+		{
+			// Four mono samples per iteration, each duplicated into L/R
+			for (; i + 4 <= samples; i += 4)
+			{
+				__m128 s = load_be(src + i);
+				s = _mm_mul_ps(s, vol ? _mm_loadu_ps(vol + i) : fixed);
+
+				const __m128 lo = _mm_unpacklo_ps(s, s); // s0 s0 s1 s1
+				const __m128 hi = _mm_unpackhi_ps(s, s); // s2 s2 s3 s3
+
+				f32* d = dst + i * 8;
+				_mm_storel_pi(reinterpret_cast<__m64*>(d + 0), _mm_add_ps(_mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(d + 0)), lo));
+				_mm_storeh_pi(reinterpret_cast<__m64*>(d + 8), _mm_add_ps(_mm_loadh_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(d + 8)), lo));
+				_mm_storel_pi(reinterpret_cast<__m64*>(d + 16), _mm_add_ps(_mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(d + 16)), hi));
+				_mm_storeh_pi(reinterpret_cast<__m64*>(d + 24), _mm_add_ps(_mm_loadh_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(d + 24)), hi));
+			}
+
+			for (; i < samples; i++)
+			{
+				const f32 center = src[i] * (vol ? vol[i] : volume);
+				dst[i * 8 + 0] += center;
+				dst[i * 8 + 1] += center;
+			}
+
+			break;
+		}
+		case 2:
+		{
+			// Two stereo samples per iteration
+			for (; i + 2 <= samples; i += 2)
+			{
+				const __m128 s = _mm_mul_ps(load_be(src + i * 2), load_vol2(vol, i, fixed));
+
+				f32* d = dst + i * 8;
+				_mm_storel_pi(reinterpret_cast<__m64*>(d + 0), _mm_add_ps(_mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(d + 0)), s));
+				_mm_storeh_pi(reinterpret_cast<__m64*>(d + 8), _mm_add_ps(_mm_loadh_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(d + 8)), s));
+			}
+
+			for (; i < samples; i++)
+			{
+				const f32 m = vol ? vol[i] : volume;
+				dst[i * 8 + 0] += src[i * 2 + 0] * m;
+				dst[i * 8 + 1] += src[i * 2 + 1] * m;
+			}
+
+			break;
+		}
+		case 6:
+		{
+			// Two 5.1 samples (12 floats) per iteration
+			for (; i + 2 <= samples; i += 2)
+			{
+				const __m128 v0 = vol ? _mm_set1_ps(vol[i]) : fixed;
+				const __m128 v1 = vol ? _mm_set1_ps(vol[i + 1]) : fixed;
+
+				const __m128 a = _mm_mul_ps(load_be(src + i * 6 + 0), v0); // L0 R0 C0 LFE0
+				const __m128 b = load_be(src + i * 6 + 4); // RL0 RR0 L1 R1
+				const __m128 c = _mm_mul_ps(load_be(src + i * 6 + 8), v1); // C1 LFE1 RL1 RR1
+
+				const __m128 rear0 = _mm_mul_ps(b, v0);
+				const __m128 front1 = _mm_mul_ps(_mm_movehl_ps(b, b), v1);
+
+				f32* d = dst + i * 8;
+				_mm_storeu_ps(d + 0, _mm_add_ps(_mm_loadu_ps(d + 0), a));
+				_mm_storel_pi(reinterpret_cast<__m64*>(d + 4), _mm_add_ps(_mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(d + 4)), rear0));
+				_mm_storeu_ps(d + 8, _mm_add_ps(_mm_loadu_ps(d + 8), _mm_movelh_ps(front1, c)));
+				_mm_storel_pi(reinterpret_cast<__m64*>(d + 12), _mm_add_ps(_mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(d + 12)), _mm_movehl_ps(c, c)));
+			}
+
+			for (; i < samples; i++)
+			{
+				const f32 m = vol ? vol[i] : volume;
+
+				for (u32 ch = 0; ch < 6; ch++)
+				{
+					dst[i * 8 + ch] += src[i * 6 + ch] * m;
+				}
+			}
+
+			break;
+		}
+		case 8:
+		{
+			// One 7.1 sample per iteration
+			for (; i < samples; i++)
+			{
+				const __m128 m = vol ? _mm_set1_ps(vol[i]) : fixed;
+
+				f32* d = dst + i * 8;
+				_mm_storeu_ps(d + 0, _mm_add_ps(_mm_loadu_ps(d + 0), _mm_mul_ps(load_be(src + i * 8 + 0), m)));
+				_mm_storeu_ps(d + 4, _mm_add_ps(_mm_loadu_ps(d + 4), _mm_mul_ps(load_be(src + i * 8 + 4), m)));
+			}
+
+			break;
+		}
+		default:
+		{
+			throw EXCEPTION("Unsupported channel count (%d)", channels);
+		}
+		}
+	}
+
+	void downmix_8ch_to_2ch(f32* dst, const f32* src, u32 samples)
+	{
+		const __m128 k = _mm_set1_ps(0.708f);
+		u32 i = 0;
+
+		// Two samples per iteration
+		for (; i + 2 <= samples; i += 2)
+		{
+			const __m128 a0 = _mm_loadu_ps(src + i * 8 + 0); // L R C LFE
+			const __m128 b0 = _mm_loadu_ps(src + i * 8 + 4); // RL RR SL SR
+			const __m128 a1 = _mm_loadu_ps(src + i * 8 + 8);
+			const __m128 b1 = _mm_loadu_ps(src + i * 8 + 12);
+
+			// { C + LFE } for both channels
+			const __m128 mid0 = _mm_add_ps(_mm_shuffle_ps(a0, a0, _MM_SHUFFLE(2, 2, 2, 2)), _mm_shuffle_ps(a0, a0, _MM_SHUFFLE(3, 3, 3, 3)));
+			const __m128 mid1 = _mm_add_ps(_mm_shuffle_ps(a1, a1, _MM_SHUFFLE(2, 2, 2, 2)), _mm_shuffle_ps(a1, a1, _MM_SHUFFLE(3, 3, 3, 3)));
+
+			// { L + RL + SL, R + RR + SR } in low halves
+			const __m128 side0 = _mm_add_ps(_mm_add_ps(a0, b0), _mm_movehl_ps(b0, b0));
+			const __m128 side1 = _mm_add_ps(_mm_add_ps(a1, b1), _mm_movehl_ps(b1, b1));
+
+			const __m128 res = _mm_add_ps(_mm_movelh_ps(side0, side1), _mm_mul_ps(_mm_movelh_ps(mid0, mid1), k));
+			_mm_storeu_ps(dst + i * 2, res);
+		}
+
+		for (; i < samples; i++)
+		{
+			const f32* s = src + i * 8;
+			const f32 mid = (s[2] + s[3]) * 0.708f;
+			dst[i * 2 + 0] = s[0] + s[4] + s[6] + mid;
+			dst[i * 2 + 1] = s[1] + s[5] + s[7] + mid;
+		}
+	}
+
+	void add_be(be_t<f32>* dst, u32 dst_channels, const be_t<f32>* src, u32 src_channels, u32 samples, f32 volume)
+	{
+		const __m128 m = _mm_set1_ps(volume);
+
+		if (dst_channels == src_channels)
+		{
+			// Same layout: process as a flat array
+			const u32 count = samples * src_channels;
+			u32 i = 0;
+
+			for (; i + 4 <= count; i += 4)
+			{
+				save_be(dst + i, _mm_add_ps(load_be(dst + i), _mm_mul_ps(load_be(src + i), m)));
+			}
+
+			for (; i < count; i++)
+			{
+				dst[i] += src[i] * volume;
+			}
+
+			return;
+		}
+
+		const u32 channels = std::min(dst_channels, src_channels);
+
+		// Swaps bytes of two floats in the low half
+		const __m128i mask2 = _mm_set_epi8(15, 14, 13, 12, 11, 10, 9, 8, 4, 5, 6, 7, 0, 1, 2, 3);
+
+		for (u32 i = 0; i < samples; i++)
+		{
+			be_t<f32>* d = dst + i * dst_channels;
+			const be_t<f32>* s = src + i * src_channels;
+			u32 ch = 0;
+
+			for (; ch + 4 <= channels; ch += 4)
+			{
+				save_be(d + ch, _mm_add_ps(load_be(d + ch), _mm_mul_ps(load_be(s + ch), m)));
+			}
+
+			for (; ch + 2 <= channels; ch += 2)
+			{
+				const __m128i ss = _mm_shuffle_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(s + ch)), mask2);
+				const __m128i dd = _mm_shuffle_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(d + ch)), mask2);
+				const __m128 res = _mm_add_ps(_mm_castsi128_ps(dd), _mm_mul_ps(_mm_castsi128_ps(ss), m));
+				_mm_storel_epi64(reinterpret_cast<__m128i*>(d + ch), _mm_shuffle_epi8(_mm_castps_si128(res), mask2));
+			}
+
+			for (; ch < channels; ch++)
+			{
+				d[ch] += s[ch] * volume;
+			}
+		}
+	}
+
+	void store_be(be_t<f32>* dst, const f32* src, u32 count)
+	{
+		u32 i = 0;
+
+		for (; i + 8 <= count; i += 8)
+		{
+			save_be(dst + i + 0, _mm_loadu_ps(src + i + 0));
+			save_be(dst + i + 4, _mm_loadu_ps(src + i + 4));
+		}
+
+		for (; i < count; i++)
+		{
+			dst[i] = src[i];
+		}
+	}
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+// SIMD helpers for mixing guest (big-endian) audio buffers, shared by cellAudio and libmixer
+namespace audio_mixer
+{
+	// Mix interleaved big-endian samples with 1, 2, 6 or 8 channels into host 8-channel buffer (dst += src * volume).
+	// Mono is mixed into both front channels. If `vol` is set, it provides per-sample volume and `volume` is ignored.
+	void mix_to_8ch(f32* dst, const be_t<f32>* src, u32 channels, u32 samples, const f32* vol = nullptr, f32 volume = 1.0f);
+
+	// Downmix host 8-channel buffer to stereo (L + RL + SL + (C + LFE) * 0.708f)
+	void downmix_8ch_to_2ch(f32* dst, const f32* src, u32 samples);
+
+	// Add interleaved big-endian samples to big-endian buffer in-place, first min(dst_channels, src_channels) channels
+	void add_be(be_t<f32>* dst, u32 dst_channels, const be_t<f32>* src, u32 src_channels, u32 samples, f32 volume);
+
+	// Convert host floats to big-endian
+	void store_be(be_t<f32>* dst, const f32* src, u32 count);
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+// Single-producer single-consumer ring of fixed-size audio blocks.
+// Block data is exchanged without locks, the mutex is only used to sleep while the ring is empty or full
+// (both sides take it to publish or release a block, so the wakeup can't be lost between the check and the sleep).
+class audio_ring_t final
+{
+	const u32 m_block_size; // floats per block
+	const u32 m_count; // blocks
+
+	std::unique_ptr<float[]> m_data;
+
+	atomic_t<u32> m_push{ 0 }; // blocks written (modified by the producer only)
+	atomic_t<u32> m_pop{ 0 }; // blocks read (modified by the consumer only)
+
+	std::mutex m_mutex;
+	std::condition_variable m_cv; // signaled when a block is published
+	std::condition_variable m_cv_space; // signaled when a block is released
+
+public:
+	atomic_t<u64> dropped{ 0 }; // blocks discarded because the ring stayed full
+
+	audio_ring_t(u32 block_size, u32 count)
+		: m_block_size(block_size)
+		, m_count(count)
+		, m_data(new float[block_size * count]{})
+	{
+	}
+
+	u32 get_block_size() const
+	{
+		return m_block_size;
+	}
+
+	u32 size() const
+	{
+		return m_push.load() - m_pop.load();
+	}
+
+	// Get block for writing (nullptr if the ring is full)
+	float* get_write_block()
+	{
+		const u32 pos = m_push.load();
+
+		if (pos - m_pop.load() >= m_count)
+		{
+			return nullptr;
+		}
+
+		return m_data.get() + (pos % m_count) * m_block_size;
+	}
+
+	// Publish the block obtained by get_write_block()
+	void commit_write()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_push++;
+		}
+
+		m_cv.notify_one();
+	}
+
+	// Copy the block, waiting for the consumer while the ring is full
+	// (the block is dropped if the ring is still full after the timeout or if stop() returns true)
+	template<typename Rep, typename Period, typename F>
+	bool push(const float* data, const std::chrono::duration<Rep, Period>& timeout, F stop)
+	{
+		const auto deadline = std::chrono::steady_clock::now() + timeout;
+
+		float* block;
+
+		while (!(block = get_write_block()))
+		{
+			if (stop() || std::chrono::steady_clock::now() >= deadline)
+			{
+				dropped++;
+				return false;
+			}
+
+			// the stop condition is polled, so the wait is limited
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			m_cv_space.wait_for(lock, std::chrono::milliseconds(1), [&] { return size() < m_count; });
+		}
+
+		std::memcpy(block, data, m_block_size * sizeof(float));
+		commit_write();
+		return true;
+	}
+
+	// Get block for reading (nullptr if the ring is empty)
+	float* get_read_block()
+	{
+		const u32 pos = m_pop.load();
+
+		if (pos == m_push.load())
+		{
+			return nullptr;
+		}
+
+		return m_data.get() + (pos % m_count) * m_block_size;
+	}
+
+	// Release the block obtained by get_read_block()
+	void commit_read()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_pop++;
+		}
+
+		m_cv_space.notify_one();
+	}
+
+	// Wait until a block is available or the timeout expires
+	template<typename Rep, typename Period>
+	void wait(const std::chrono::duration<Rep, Period>& timeout)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		m_cv.wait_for(lock, timeout, [&] { return size() != 0; });
+	}
+};
@@ -15,9 +15,28 @@ struct ppu_decoder_cache_t
 {
 	ppu_inter_func_t* const pointer;
 
+	// State of every 4 KiB page in the table (see flags below)
+	std::array<atomic_t<u8>, 0x100000000ull / 4096> pages{};
+
+	enum : u8
+	{
+		page_committed = (1 << 0), // table memory is available, null entries are decoded on demand
+		page_decoded   = (1 << 1), // table entries are valid and the guest page is write-protected
+	};
+
 	ppu_decoder_cache_t();
 
 	~ppu_decoder_cache_t();
 
+	// Discard decoded entries in the specified range, they will be decoded again on first execution
 	void initialize(u32 addr, u32 size);
+
+	// Decode the page containing addr and write-protect it (returns false if the page is not cached: not allocated or can't be write-protected)
+	bool decode_page(u32 addr);
+
+	// Discard decoded entries in the specified range without restoring write access (called by vm with the reservation lock held)
+	void discard(u32 addr, u32 size);
+
+	// Get interpreter function for the opcode (slow, for pages which are not cached)
+	static ppu_inter_func_t decode(u32 opcode);
 };
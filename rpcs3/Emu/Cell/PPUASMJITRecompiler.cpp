@@ -0,0 +1,327 @@
+#include "stdafx.h"
+#include "Emu/System.h"
+#include "Emu/Memory/Memory.h"
+#include "Emu/IdManager.h"
+#include "Emu/perf.h"
+#include "Utilities/VirtualMemory.h"
+
+#include "PPUThread.h"
+#include "PPUOpcodes.h"
+#include "PPUASMJITRecompiler.h"
+
+#define ASMJIT_STATIC
+
+#ifdef _MSC_VER
+#pragma comment(lib, "asmjit.lib")
+#endif
+
+#include "asmjit.h"
+
+#define PPU_OFF_64(x) asmjit::host::qword_ptr(*cpu, OFFSET_32(PPUThread, x))
+#define PPU_OFF_32(x) asmjit::host::dword_ptr(*cpu, OFFSET_32(PPUThread, x))
+
+using namespace PPU_opcodes;
+
+ppu_recompiler::ppu_recompiler()
+	: m_jit(std::make_shared<asmjit::JitRuntime>())
+	, m_decoder_cache(fxm::get<ppu_decoder_cache_t>())
+	, m_blocks(static_cast<decltype(m_blocks)>(memory_helper::reserve_memory(0x200000000)))
+{
+	if (!m_decoder_cache)
+	{
+		throw EXCEPTION("PPU Decoder Cache not initialized");
+	}
+
+	LOG_SUCCESS(PPU, "PPU Recompiler (ASMJIT) created...");
+}
+
+ppu_recompiler::~ppu_recompiler()
+{
+	memory_helper::free_reserved_memory(m_blocks, 0x200000000);
+}
+
+// Execute single instruction (used for pages which can't be write-protected and cached)
+static u32 ppu_interpret_instruction(PPUThread* ppu) noexcept
+{
+	try
+	{
+		const u32 opcode = vm::ps3::read32(ppu->PC);
+		ppu_decoder_cache_t::decode(opcode)(*ppu, { opcode });
+		ppu->PC += 4;
+		return 0;
+	}
+	catch (...)
+	{
+		ppu->pending_exception = std::current_exception();
+		return 1;
+	}
+}
+
+ppu_jit_func_t ppu_recompiler::compile(u32 start)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	const u32 page = start & ~0xfff;
+
+	if (!m_pages[page / 4096])
+	{
+		memory_helper::commit_page_memory(m_blocks + page / 4, 4096 * 2);
+		m_pages[page / 4096] = 1;
+	}
+
+	const auto& decoder_cache = m_decoder_cache;
+
+	// the page is write-protected by the decoder cache, so code modification discards compiled blocks as well
+	while (!(decoder_cache->pages[page / 4096] & ppu_decoder_cache_t::page_decoded))
+	{
+		// blocks never cross a page boundary, compiled code is released with the JIT runtime
+		std::fill_n(m_blocks + page / 4, 1024, nullptr);
+
+		if (!decoder_cache->decode_page(start))
+		{
+			if (!vm::check_addr(start, 4))
+			{
+				throw EXCEPTION("Invalid PC (0x%08x)", start);
+			}
+
+			return &ppu_interpret_instruction;
+		}
+	}
+
+	// block may be compiled by another thread
+	if (const auto func = m_blocks[start / 4])
+	{
+		return func;
+	}
+
+	perf::scope perf_scope(perf::counter::jit_compile, start);
+
+	using namespace asmjit;
+
+	X86Compiler compiler(m_jit.get());
+	this->c = &compiler;
+
+	compiler.addFunc(kFuncConvHost, FuncBuilder1<u32, void*>());
+
+	// Initialize variables
+	X86GpVar cpu_var(compiler, kVarTypeIntPtr, "cpu");
+	compiler.setArg(0, cpu_var);
+	compiler.alloc(cpu_var, asmjit::host::rbp); // ASMJIT bug workaround
+	this->cpu = &cpu_var;
+
+	X86GpVar base_var(compiler, kVarTypeIntPtr, "base");
+	compiler.mov(base_var, imm_ptr(vm::base(0)));
+	this->base = &base_var;
+
+	X86GpVar addr_var(compiler, kVarTypeUInt32, "addr");
+	this->addr = &addr_var;
+	X86GpVar dw0_var(compiler, kVarTypeUInt32, "dw0");
+	this->dw0 = &dw0_var;
+	X86GpVar qw0_var(compiler, kVarTypeUInt64, "qw0");
+	this->qw0 = &qw0_var;
+
+	Label branch_label = compiler.newLabel();
+	this->branch = &branch_label;
+	Label end_label = compiler.newLabel();
+	this->end = &end_label;
+
+	// Translate instructions until the first branch or the end of the page
+	for (m_pos = start; m_pos < page + 4096;)
+	{
+		const ppu_opcode_t op{ vm::ps3::read32(m_pos) };
+
+		const u32 opcd = op.opcode >> 26;
+
+		if (!CompileNative(op))
+		{
+			// entries may be discarded concurrently (the block is compiled again in this case)
+			const auto func = decoder_cache->pointer[m_pos / 4];
+
+			InterpreterCall(op, func ? func : ppu_decoder_cache_t::decode(op.opcode));
+		}
+
+		m_pos += 4;
+
+		// branches, system calls and HLE calls end the block (status must be checked after them)
+		if (opcd == BC || opcd == SC || opcd == B || opcd == G_13 || opcd == HACK)
+		{
+			break;
+		}
+	}
+
+	// Go to the next address
+	compiler.mov(PPU_OFF_32(PC), m_pos);
+	compiler.xor_(addr_var, addr_var);
+	compiler.jmp(end_label);
+
+	// PC was set by the interpreter function to (target - 4)
+	compiler.bind(branch_label);
+	compiler.add(PPU_OFF_32(PC), 4);
+	compiler.xor_(addr_var, addr_var);
+
+	// Return addr_var
+	compiler.bind(end_label);
+	compiler.unuse(cpu_var);
+	compiler.unuse(base_var);
+	compiler.ret(addr_var);
+	compiler.endFunc();
+
+	const auto func = asmjit_cast<ppu_jit_func_t>(compiler.make());
+
+	if (!func)
+	{
+		throw EXCEPTION("Compilation failed (PC=0x%08x)", start);
+	}
+
+	m_blocks[start / 4] = func;
+	return func;
+}
+
+void ppu_recompiler::InterpreterCall(ppu_opcode_t op, ppu_inter_func_t func)
+{
+	auto gate = [](PPUThread* _ppu, u32 opcode, ppu_inter_func_t _func) noexcept -> u32
+	{
+		try
+		{
+			_func(*_ppu, { opcode });
+			return 0;
+		}
+		catch (...)
+		{
+			_ppu->pending_exception = std::current_exception();
+			return 1;
+		}
+	};
+
+	c->mov(PPU_OFF_32(PC), m_pos);
+	asmjit::X86CallNode* call = c->call(asmjit::imm_ptr(asmjit_cast<void*, u32(PPUThread*, u32, ppu_inter_func_t)>(gate)), asmjit::kFuncConvHost, asmjit::FuncBuilder3<u32, void*, u32, void*>());
+	call->setArg(0, *cpu);
+	call->setArg(1, asmjit::imm_u(op.opcode));
+	call->setArg(2, asmjit::imm_ptr(asmjit_cast<void*>(func)));
+	call->setRet(0, *addr);
+
+	// return immediately if an exception was thrown
+	c->test(*addr, *addr);
+	c->jnz(*end);
+
+	// leave the block if the instruction branched
+	c->cmp(PPU_OFF_32(PC), m_pos);
+	c->jne(*branch);
+}
+
+void ppu_recompiler::LoadAddress(ppu_opcode_t op, s32 d)
+{
+	if (op.ra)
+	{
+		c->mov(*addr, PPU_OFF_32(GPR[op.ra]));
+		if (d) c->add(*addr, d);
+	}
+	else
+	{
+		c->mov(*addr, static_cast<u32>(d));
+	}
+}
+
+bool ppu_recompiler::CompileNative(ppu_opcode_t op)
+{
+	switch (op.opcode >> 26)
+	{
+	case ADDI:
+	case ADDIS:
+	{
+		const s32 imm = (op.opcode >> 26) == ADDIS ? op.simm16 << 16 : op.simm16;
+
+		if (op.ra)
+		{
+			c->mov(*qw0, PPU_OFF_64(GPR[op.ra]));
+			if (imm) c->add(*qw0, imm);
+		}
+		else
+		{
+			c->mov(*qw0, asmjit::imm(static_cast<s64>(imm)));
+		}
+
+		c->mov(PPU_OFF_64(GPR[op.rd]), *qw0);
+		return true;
+	}
+
+	case ORI:
+	case ORIS:
+	{
+		const u32 imm = (op.opcode >> 26) == ORIS ? op.uimm16 << 16 : op.uimm16;
+
+		if (op.ra != op.rs)
+		{
+			c->mov(*qw0, PPU_OFF_64(GPR[op.rs]));
+			c->mov(PPU_OFF_64(GPR[op.ra]), *qw0);
+		}
+
+		// only the low word is affected
+		if (imm) c->or_(PPU_OFF_32(GPR[op.ra]), imm);
+		return true;
+	}
+
+	case G_1f:
+	{
+		// OR (including MR), without record bit
+		if (((op.opcode >> 1) & 0x3ff) == OR && !op.rc)
+		{
+			c->mov(*qw0, PPU_OFF_64(GPR[op.rs]));
+			if (op.rb != op.rs) c->or_(*qw0, PPU_OFF_64(GPR[op.rb]));
+			c->mov(PPU_OFF_64(GPR[op.ra]), *qw0);
+			return true;
+		}
+
+		return false;
+	}
+
+	case LWZ:
+	{
+		LoadAddress(op, op.simm16);
+		c->mov(*dw0, asmjit::host::dword_ptr(*base, *addr));
+		c->bswap(*dw0);
+		c->mov(PPU_OFF_32(GPR[op.rd]), *dw0);
+		c->mov(asmjit::host::dword_ptr(*cpu, OFFSET_32(PPUThread, GPR[op.rd]) + 4), 0);
+		return true;
+	}
+
+	case STW:
+	{
+		LoadAddress(op, op.simm16);
+		c->mov(*dw0, PPU_OFF_32(GPR[op.rs]));
+		c->bswap(*dw0);
+		c->mov(asmjit::host::dword_ptr(*base, *addr), *dw0);
+		return true;
+	}
+
+	case G_3a:
+	{
+		if ((op.opcode & 3) == LD)
+		{
+			LoadAddress(op, op.simm16 & ~3);
+			c->mov(*qw0, asmjit::host::qword_ptr(*base, *addr));
+			c->bswap(*qw0);
+			c->mov(PPU_OFF_64(GPR[op.rd]), *qw0);
+			return true;
+		}
+
+		return false;
+	}
+
+	case G_3e:
+	{
+		if ((op.opcode & 3) == STD)
+		{
+			LoadAddress(op, op.simm16 & ~3);
+			c->mov(*qw0, PPU_OFF_64(GPR[op.rs]));
+			c->bswap(*qw0);
+			c->mov(asmjit::host::qword_ptr(*base, *addr), *qw0);
+			return true;
+		}
+
+		return false;
+	}
+	}
+
+	return false;
+}
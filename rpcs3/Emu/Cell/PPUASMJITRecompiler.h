@@ -0,0 +1,87 @@
+#pragma once
+
+#include "Emu/Cell/Common.h"
+#include "PPUInterpreter2.h"
+
+namespace asmjit
+{
+	struct JitRuntime;
+	struct X86Compiler;
+	struct X86GpVar;
+	struct Label;
+}
+
+class PPUThread;
+
+// Compiled block (returns nonzero if an exception was thrown, PPUThread::pending_exception is set in this case)
+using ppu_jit_func_t = u32(*)(PPUThread* ppu);
+
+// PPU ASMJIT Recompiler (baseline tier)
+// Translates basic blocks on first execution: simple instructions are compiled to native code,
+// other instructions are compiled to direct calls of interpreter functions from the PPU Decoder Cache.
+// It's selected explicitly (not the default decoder), and hot blocks are not handed over to the LLVM recompiler.
+class ppu_recompiler final
+{
+	const std::shared_ptr<asmjit::JitRuntime> m_jit;
+
+	// Compiled blocks are valid while their page is decoded (and write-protected) by the PPU Decoder Cache
+	const std::shared_ptr<ppu_decoder_cache_t> m_decoder_cache;
+
+	std::mutex m_mutex;
+
+	// Compiled blocks indexed by guest address (null if not compiled)
+	ppu_jit_func_t* const m_blocks;
+
+	// Set if the table memory for the page is available
+	std::array<atomic_t<u8>, 0x100000000ull / 4096> m_pages{};
+
+public:
+	ppu_recompiler();
+
+	~ppu_recompiler();
+
+	// Get compiled block at the specified address
+	ppu_jit_func_t get_block(u32 addr)
+	{
+		if (m_pages[addr / 4096] && m_decoder_cache->pages[addr / 4096] & ppu_decoder_cache_t::page_decoded)
+		{
+			if (const auto func = m_blocks[addr / 4])
+			{
+				return func;
+			}
+		}
+
+		return compile(addr);
+	}
+
+private:
+	ppu_jit_func_t compile(u32 addr);
+
+	// emitter:
+	asmjit::X86Compiler* c;
+
+	// input:
+	asmjit::X86GpVar* cpu;
+
+	// temporary:
+	asmjit::X86GpVar* base; // vm::base(0)
+	asmjit::X86GpVar* addr;
+	asmjit::X86GpVar* dw0;
+	asmjit::X86GpVar* qw0;
+
+	// labels:
+	asmjit::Label* branch; // PC was modified (add 4 and return 0)
+	asmjit::Label* end; // block end (return *addr)
+
+	// current instruction address
+	u32 m_pos;
+
+	// Call interpreter function (leaves the block if an exception was thrown or PC was modified)
+	void InterpreterCall(ppu_opcode_t op, ppu_inter_func_t func);
+
+	// Load effective address (rA|0) + d into *addr
+	void LoadAddress(ppu_opcode_t op, s32 d);
+
+	// Generate native code for simple instructions (returns false if the instruction is not supported)
+	bool CompileNative(ppu_opcode_t op);
+};
@@ -2,6 +2,7 @@
 #ifdef LLVM_AVAILABLE
 #include "Emu/System.h"
 #include "Emu/state.h"
+#include "Emu/perf.h"
 #include "Emu/Cell/PPUDisAsm.h"
 #include "Emu/Cell/PPULLVMRecompiler.h"
 #include "Emu/Memory/Memory.h"
@@ -68,6 +69,7 @@ void Compiler::optimise_module(llvm::Module *module)
 	fpm.add(createNoAAPass());
 	fpm.add(createBasicAliasAnalysisPass());
 	fpm.add(createNoTargetTransformInfoPass());
+	fpm.add(createSROAPass());
 	fpm.add(createEarlyCSEPass());
 	fpm.add(createTailCallEliminationPass());
 	fpm.add(createReassociatePass());
@@ -90,10 +92,11 @@ void Compiler::optimise_module(llvm::Module *module)
 }
 
 
-Compiler::Compiler(LLVMContext *context, llvm::IRBuilder<> *builder, std::unordered_map<std::string, void*> &function_ptrs)
+Compiler::Compiler(LLVMContext *context, llvm::IRBuilder<> *builder, std::unordered_map<std::string, void*> &function_ptrs, RecompilationEngine *recompilation_engine)
 	: m_llvm_context(context),
 	m_ir_builder(builder),
-	m_executable_map(function_ptrs) {
+	m_executable_map(function_ptrs),
+	m_recompilation_engine(recompilation_engine) {
 
 	std::vector<Type *> arg_types;
 	arg_types.push_back(m_ir_builder->getInt8PtrTy());
@@ -133,6 +136,11 @@ void ppu_recompiler_llvm::Compiler::translate_to_llvm_ir(llvm::Module *module, c
 	m_ir_builder->SetInsertPoint(GetBasicBlockFromAddress(0));
 	m_ir_builder->CreateBr(GetBasicBlockFromAddress(start_address));
 
+	// Keep guest registers in local variables, SROA turns them into SSA values
+	m_state.promote_registers = true;
+	m_state.promoted_registers.clear();
+	m_state.memory_accesses.clear();
+
 	// Convert each instruction in the CFG to LLVM IR
 	std::vector<PHINode *> exit_instr_list;
 	for (u32 instructionAddress = start_address; instructionAddress < start_address + instruction_count * 4; instructionAddress += 4) {
@@ -185,6 +193,11 @@ void ppu_recompiler_llvm::Compiler::translate_to_llvm_ir(llvm::Module *module, c
 		}
 	}
 
+	SpillPromotedRegisters();
+	m_state.promote_registers = false;
+	m_state.promoted_registers.clear();
+	m_state.memory_accesses.clear();
+
 	std::string        verify;
 	raw_string_ostream verify_ostream(verify);
 	if (verifyFunction(*m_state.function, &verify_ostream)) {
@@ -256,6 +269,16 @@ const Executable RecompilationEngine::GetCompiledExecutableIfAvailable(u32 addre
 	return FunctionCache[address / 4].first;
 }
 
+Executable * RecompilationEngine::GetCallSlot(u32 address)
+{
+	// Excluded functions must stay reachable only through GetCompiledExecutableIfAvailable
+	if (rpcs3::state.config.core.llvm.exclusion_range.value())
+		return nullptr;
+	if (!isAddressCommited(address / 4))
+		commitAddress(address / 4);
+	return &FunctionCache[address / 4].first;
+}
+
 void RecompilationEngine::NotifyBlockStart(u32 address) {
 	{
 		std::lock_guard<std::mutex> lock(m_pending_address_start_lock);
@@ -296,6 +319,20 @@ void RecompilationEngine::on_task() {
 			m_current_execution_traces.swap(m_pending_address_start);
 		}
 
+		std::vector<u32> discarded_addresses;
+
+		{
+			std::lock_guard<std::mutex> lock(m_compiled_ranges_lock);
+			discarded_addresses.swap(m_discarded_addresses);
+		}
+
+		// Discarded functions are analysed and compiled again when they're hot
+		for (u32 address : discarded_addresses) {
+			auto It = m_block_table.find(address);
+			if (It != m_block_table.end())
+				It->second = BlockEntry(address);
+		}
+
 		if (!m_current_execution_traces.empty()) {
 			for (u32 address : m_current_execution_traces)
 				work_done_this_iteration |= IncreaseHitCounterAndBuild(address);
@@ -311,7 +348,14 @@ void RecompilationEngine::on_task() {
 		}
 	}
 
-	s_the_instance = nullptr; // Can cause deadlock if this is the last instance. Need to fix this.
+	std::shared_ptr<RecompilationEngine> instance;
+
+	{
+		std::lock_guard<std::mutex> lock(s_mutex);
+		instance.swap(s_the_instance);
+	}
+
+	instance = nullptr; // Can cause deadlock if this is the last instance. Need to fix this.
 }
 
 bool RecompilationEngine::IncreaseHitCounterAndBuild(u32 address) {
@@ -376,6 +420,8 @@ static void wrapped_trap(PPUThread &CPU, u32) noexcept {
 }
 
 std::pair<Executable, llvm::ExecutionEngine *> RecompilationEngine::compile(const std::string & name, u32 start_address, u32 instruction_count) {
+	perf::scope perf_scope(perf::counter::jit_compile, start_address);
+
 	std::unique_ptr<llvm::Module> module = Compiler::create_module(m_llvm_context);
 
 	std::unordered_map<std::string, void*> function_ptrs;
@@ -400,7 +446,7 @@ std::pair<Executable, llvm::ExecutionEngine *> RecompilationEngine::compile(cons
 	MACRO_PPU_INST_G_3A_EXPANDERS(REGISTER_FUNCTION_PTR)
 	MACRO_PPU_INST_G_3E_EXPANDERS(REGISTER_FUNCTION_PTR)
 
-	Compiler(&m_llvm_context, &m_ir_builder, function_ptrs)
+	Compiler(&m_llvm_context, &m_ir_builder, function_ptrs, this)
 		.translate_to_llvm_ir(module.get(), name, start_address, instruction_count);
 
 	llvm::Module *module_ptr = module.get();
@@ -534,13 +580,73 @@ void RecompilationEngine::CompileBlock(BlockEntry & block_entry) {
 			commitAddress(block_entry.address / 4);
 
 		m_executable_storage.push_back(std::unique_ptr<llvm::ExecutionEngine>(compileResult.second));
+
+		const u32 start = block_entry.address;
+		const u32 end = start + block_entry.instructionCount * 4;
+
+		// Register the range before its pages are write-protected, so a write at any moment is handled by Discard()
+		{
+			std::lock_guard<std::mutex> ranges_lock(m_compiled_ranges_lock);
+			m_compiled_ranges[start] = end;
+			m_max_range_size = std::max(m_max_range_size, end - start);
+		}
+
+		bool is_protected = true;
+
+		for (u32 page = start & ~0xfff; page < end; page += 4096) {
+			// The page may be already protected by another decoder
+			if (!vm::page_protect(page, 4096, vm::page_writable, vm::page_executable, vm::page_writable) && !vm::page_protect(page, 4096, vm::page_executable)) {
+				is_protected = false;
+				break;
+			}
+		}
+
+		std::lock_guard<std::mutex> ranges_lock(m_compiled_ranges_lock);
+
+		// The code was written or unmapped meanwhile: leave it to the interpreter until it's compiled again
+		if (!is_protected || !m_compiled_ranges.count(start)) {
+			Log() << "Discarded before linking: " << block_entry.ToString() << "\n";
+			m_compiled_ranges.erase(start);
+			return;
+		}
+
 		Log() << "Associating " << (void*)(uint64_t)block_entry.address << " with ID " << m_currentId << "\n";
-		FunctionCache[block_entry.address / 4] = std::make_pair(compileResult.first, m_currentId);
+		// Store the id first, the executable pointer also links direct callers
+		FunctionCache[block_entry.address / 4].second = m_currentId;
+		_mm_sfence();
+		FunctionCache[block_entry.address / 4].first = compileResult.first;
 		m_currentId++;
 		block_entry.is_compiled = true;
 	}
 }
 
+void RecompilationEngine::Discard(u32 addr, u32 size) {
+	std::lock_guard<std::mutex> lock(m_compiled_ranges_lock);
+
+	// Functions starting up to m_max_range_size bytes before the range may overlap it
+	auto it = m_compiled_ranges.lower_bound(addr > m_max_range_size ? addr - m_max_range_size : 0);
+
+	while (it != m_compiled_ranges.end() && it->first < u64{ addr } + size) {
+		if (it->second <= addr) {
+			++it;
+			continue;
+		}
+
+		// Callers load the slot on every call, so they fall back to the dispatcher from now on
+		FunctionCache[it->first / 4].first = nullptr;
+		m_discarded_addresses.push_back(it->first);
+		it = m_compiled_ranges.erase(it);
+	}
+}
+
+void RecompilationEngine::DiscardCode(u32 addr, u32 size) {
+	std::lock_guard<std::mutex> lock(s_mutex);
+
+	if (s_the_instance) {
+		s_the_instance->Discard(addr, size);
+	}
+}
+
 std::shared_ptr<RecompilationEngine> RecompilationEngine::GetInstance() {
 	std::lock_guard<std::mutex> lock(s_mutex);
 
@@ -5,6 +5,7 @@
 #define PPU_LLVM_RECOMPILER 1
 
 #include <list>
+#include <map>
 #include "Emu/Cell/PPUDecoder.h"
 #include "Emu/Cell/PPUThread.h"
 #include "Emu/Cell/PPUInterpreter.h"
@@ -49,7 +50,7 @@ namespace ppu_recompiler_llvm {
 	/// Parses PPU opcodes and translate them into llvm ir.
 	class Compiler : protected PPUOpcodes, protected PPCDecoder {
 	public:
-		Compiler(llvm::LLVMContext *context, llvm::IRBuilder<> *builder, std::unordered_map<std::string, void*> &function_ptrs);
+		Compiler(llvm::LLVMContext *context, llvm::IRBuilder<> *builder, std::unordered_map<std::string, void*> &function_ptrs, RecompilationEngine *recompilation_engine = nullptr);
 
 		Compiler(const Compiler&) = delete; // Delete copy/move constructors and copy/move operators
 
@@ -493,6 +494,22 @@ namespace ppu_recompiler_llvm {
 			/// This is set to false at the start of compilation of an instruction.
 			/// If a branch instruction is encountered, this is set to true by the decode function.
 			bool hit_branch_instruction;
+
+			/// A guest register kept in a local variable
+			struct PromotedRegister {
+				llvm::AllocaInst * local = nullptr;
+				u32 size = 0;
+				bool is_modified = false;
+			};
+
+			/// If true, guest registers are kept in local variables (set by translate_to_llvm_ir)
+			bool promote_registers = false;
+
+			/// Promoted guest registers by offset in PPUThread
+			std::map<u32, PromotedRegister> promoted_registers;
+
+			/// Guest memory accesses, which may fault (the PPU state is written back before them)
+			std::vector<llvm::Instruction *> memory_accesses;
 		};
 
 		/// The function that will be called to execute unknown functions
@@ -504,6 +521,9 @@ namespace ppu_recompiler_llvm {
 		/// Maps function name to executable memory pointer
 		std::unordered_map<std::string, void*> &m_executable_map;
 
+		/// Provides call slots of compiled functions (calls are not linked if null)
+		RecompilationEngine * m_recompilation_engine;
+
 		/// LLVM context
 		llvm::LLVMContext * m_llvm_context;
 
@@ -549,6 +569,14 @@ namespace ppu_recompiler_llvm {
 		/// Set a nibble
 		llvm::Value * SetNibble(llvm::Value * val, u32 n, llvm::Value * b0, llvm::Value * b1, llvm::Value * b2, llvm::Value * b3, bool doClear = true);
 
+		/// Get an i8 pointer to the guest register at the specified offset in PPUThread.
+		/// If register promotion is enabled, this is the local copy of the register.
+		llvm::Value * GetRegisterPtr(u32 offset, u32 size, bool is_write);
+
+		/// Write promoted registers back to PPUThread before calls taking the PPU state, guest memory accesses
+		/// and returns, and reload them after the calls
+		void SpillPromotedRegisters();
+
 		/// Load PC
 		llvm::Value * GetPc();
 
@@ -660,11 +688,14 @@ namespace ppu_recompiler_llvm {
 		/// Create IR for a branch instruction
 		void CreateBranch(llvm::Value * cmp_i1, llvm::Value * target_i32, bool lk, bool target_is_lr = false);
 
-		/// Read from memory
-		llvm::Value * ReadMemory(llvm::Value * addr_i64, u32 bits, u32 alignment = 0, bool bswap = true, bool could_be_mmio = true);
+		/// Read from memory (MMIO is emulated by the access violation handler, so no address check is generated)
+		llvm::Value * ReadMemory(llvm::Value * addr_i64, u32 bits, u32 alignment = 0, bool bswap = true);
 
-		/// Write to memory
-		void WriteMemory(llvm::Value * addr_i64, llvm::Value * val_ix, u32 alignment = 0, bool bswap = true, bool could_be_mmio = true);
+		/// Write to memory (MMIO is emulated by the access violation handler, so no address check is generated)
+		void WriteMemory(llvm::Value * addr_i64, llvm::Value * val_ix, u32 alignment = 0, bool bswap = true);
+
+		/// Record an instruction accessing guest memory (promoted registers are written back before it)
+		void AddMemoryAccess(llvm::Instruction * inst);
 
 		/// Convert a C++ type to an LLVM type
 		template<class T>
@@ -755,6 +786,20 @@ namespace ppu_recompiler_llvm {
 		/// Notify the recompilation engine about a newly detected block start.
 		void NotifyBlockStart(u32 address);
 
+		/**
+		 * Get the slot holding the executable of the function at the specified address (null while it isn't compiled).
+		 * Compiled code calls through the slot, so callers are linked as soon as the callee is compiled
+		 * and unlinked when the slot is cleared. Must be called from the recompilation thread.
+		 * Returns nullptr if calls must go through the dispatcher.
+		 **/
+		Executable * GetCallSlot(u32 address);
+
+		/**
+		 * Clear the slots of compiled functions overlapping the specified range, so it's recompiled on next execution.
+		 * Called by vm with the reservation lock held (before the code is written or unmapped).
+		 **/
+		static void DiscardCode(u32 addr, u32 size);
+
 		/// Log
 		llvm::raw_fd_ostream & Log();
 
@@ -838,6 +883,21 @@ namespace ppu_recompiler_llvm {
 		bool isAddressCommited(u32) const;
 		void commitAddress(u32);
 
+		/// Lock for accessing m_compiled_ranges and m_discarded_addresses (may be locked with the vm reservation lock held)
+		std::mutex m_compiled_ranges_lock;
+
+		/// Code range of every linked function (start address -> end address). Its pages are write-protected.
+		std::map<u32, u32> m_compiled_ranges;
+
+		/// Start addresses of discarded functions, their block entries are reset by the recompilation thread
+		std::vector<u32> m_discarded_addresses;
+
+		/// Size of the largest range in m_compiled_ranges
+		u32 m_max_range_size = 0;
+
+		/// Clear the slots of functions overlapping the range
+		void Discard(u32 addr, u32 size);
+
 		/// vector storing all exec engine
 		std::vector<std::unique_ptr<llvm::ExecutionEngine> > m_executable_storage;
 
@@ -3595,7 +3595,7 @@ void Compiler::LSWI(u32 rd, u32 ra, u32 nb) {
 
 	nb = nb ? nb : 32;
 	for (u32 i = 0; i < nb; i += 4) {
-		auto val_i32 = ReadMemory(addr_i64, 32, 0, true, false);
+		auto val_i32 = ReadMemory(addr_i64, 32);
 
 		if (i + 4 <= nb) {
 			addr_i64 = m_ir_builder->CreateAdd(addr_i64, m_ir_builder->getInt64(4));
@@ -3665,8 +3665,8 @@ void Compiler::STVLX(u32 vs, u32 ra, u32 rb) {
 	auto vs_i8_ptr = m_ir_builder->CreateBitCast(vs_i128_ptr, m_ir_builder->getInt8PtrTy());
 
 	Type * types[3] = { m_ir_builder->getInt8PtrTy(), m_ir_builder->getInt8PtrTy(), m_ir_builder->getInt64Ty() };
-	m_ir_builder->CreateCall5(Intrinsic::getDeclaration(m_module, Intrinsic::memcpy, types),
-		addr_i8_ptr, vs_i8_ptr, size_i64, m_ir_builder->getInt32(1), m_ir_builder->getInt1(false));
+	AddMemoryAccess(m_ir_builder->CreateCall5(Intrinsic::getDeclaration(m_module, Intrinsic::memcpy, types),
+		addr_i8_ptr, vs_i8_ptr, size_i64, m_ir_builder->getInt32(1), m_ir_builder->getInt1(false)));
 }
 
 void Compiler::STDBRX(u32 rs, u32 ra, u32 rb) {
@@ -3726,8 +3726,8 @@ void Compiler::STVRX(u32 vs, u32 ra, u32 rb) {
 	vs_i8_ptr = m_ir_builder->CreateGEP(vs_i8_ptr, index_i64);
 
 	Type * types[3] = { m_ir_builder->getInt8PtrTy(), m_ir_builder->getInt8PtrTy(), m_ir_builder->getInt64Ty() };
-	m_ir_builder->CreateCall5(Intrinsic::getDeclaration(m_module, Intrinsic::memcpy, types),
-		addr_i8_ptr, vs_i8_ptr, size_i64, m_ir_builder->getInt32(1), m_ir_builder->getInt1(false));
+	AddMemoryAccess(m_ir_builder->CreateCall5(Intrinsic::getDeclaration(m_module, Intrinsic::memcpy, types),
+		addr_i8_ptr, vs_i8_ptr, size_i64, m_ir_builder->getInt32(1), m_ir_builder->getInt1(false)));
 }
 
 void Compiler::STFSUX(u32 frs, u32 ra, u32 rb) {
@@ -3748,7 +3748,7 @@ void Compiler::STSWI(u32 rd, u32 ra, u32 nb) {
 		auto val_i32 = GetGpr(rd, 32);
 
 		if (i + 4 <= nb) {
-			WriteMemory(addr_i64, val_i32, 0, true, false);
+			WriteMemory(addr_i64, val_i32);
 			addr_i64 = m_ir_builder->CreateAdd(addr_i64, m_ir_builder->getInt64(4));
 			rd = (rd + 1) % 32;
 		}
@@ -3996,8 +3996,8 @@ void Compiler::DCBZ(u32 ra, u32 rb) {
 	auto addr_i8_ptr = m_ir_builder->CreateIntToPtr(addr_i64, m_ir_builder->getInt8PtrTy());
 
 	std::vector<Type *> types = { (Type *)m_ir_builder->getInt8PtrTy(), (Type *)m_ir_builder->getInt32Ty() };
-	m_ir_builder->CreateCall5(Intrinsic::getDeclaration(m_module, Intrinsic::memset, types),
-		addr_i8_ptr, m_ir_builder->getInt8(0), m_ir_builder->getInt32(128), m_ir_builder->getInt32(128), m_ir_builder->getInt1(true));
+	AddMemoryAccess(m_ir_builder->CreateCall5(Intrinsic::getDeclaration(m_module, Intrinsic::memset, types),
+		addr_i8_ptr, m_ir_builder->getInt8(0), m_ir_builder->getInt32(128), m_ir_builder->getInt32(128), m_ir_builder->getInt1(true)));
 }
 
 void Compiler::LWZ(u32 rd, u32 ra, s32 d) {
@@ -5098,6 +5098,71 @@ Value * Compiler::SetNibble(Value * val, u32 n, Value * b0, Value * b1, Value *
 	return val;
 }
 
+Value * Compiler::GetRegisterPtr(u32 offset, u32 size, bool is_write) {
+	if (!m_state.promote_registers) {
+		return m_ir_builder->CreateConstGEP1_32(m_state.args[CompileTaskState::Args::State], offset);
+	}
+
+	auto &reg = m_state.promoted_registers[offset];
+	if (!reg.local) {
+		// Create the local copy in the entry block and initialise it with the value at function entry
+		IRBuilder<> entry_builder(GetBasicBlockFromAddress(0)->getTerminator());
+		auto reg_type = entry_builder.getIntNTy(size * 8);
+		auto state_ptr = entry_builder.CreateBitCast(entry_builder.CreateConstGEP1_32(m_state.args[CompileTaskState::Args::State], offset), reg_type->getPointerTo());
+		reg.local = entry_builder.CreateAlloca(reg_type);
+		reg.local->setAlignment(size);
+		reg.size = size;
+		entry_builder.CreateAlignedStore(entry_builder.CreateAlignedLoad(state_ptr, size), reg.local, size);
+	}
+
+	reg.is_modified |= is_write;
+	return m_ir_builder->CreateBitCast(reg.local, m_ir_builder->getInt8PtrTy());
+}
+
+void Compiler::SpillPromotedRegisters() {
+	// Find calls which may access the PPU state, and exits. Guest memory accesses may fault and
+	// leave the thread, so the state must be up to date before them too (but they don't modify registers).
+	std::vector<Instruction *> sync_points = m_state.memory_accesses;
+	for (BasicBlock &block_i : *m_state.function) {
+		for (Instruction &inst_i : block_i) {
+			if (isa<ReturnInst>(inst_i)) {
+				sync_points.push_back(&inst_i);
+			}
+			else if (auto call = dyn_cast<CallInst>(&inst_i)) {
+				for (unsigned i = 0; i < call->getNumArgOperands(); i++) {
+					if (call->getArgOperand(i) == m_state.args[CompileTaskState::Args::State]) {
+						sync_points.push_back(call);
+						break;
+					}
+				}
+			}
+		}
+	}
+
+	for (size_t i = 0; i < sync_points.size(); i++) {
+		Instruction *inst_i = sync_points[i];
+		IRBuilder<> builder(inst_i);
+		for (auto &reg_i : m_state.promoted_registers) {
+			if (!reg_i.second.is_modified)
+				continue;
+			auto reg_type = builder.getIntNTy(reg_i.second.size * 8);
+			auto state_ptr = builder.CreateBitCast(builder.CreateConstGEP1_32(m_state.args[CompileTaskState::Args::State], reg_i.first), reg_type->getPointerTo());
+			builder.CreateAlignedStore(builder.CreateAlignedLoad(reg_i.second.local, reg_i.second.size), state_ptr, reg_i.second.size);
+		}
+
+		if (i < m_state.memory_accesses.size() || isa<ReturnInst>(inst_i))
+			continue;
+
+		// The callee may have modified registers
+		builder.SetInsertPoint(inst_i->getParent(), std::next(BasicBlock::iterator(inst_i)));
+		for (auto &reg_i : m_state.promoted_registers) {
+			auto reg_type = builder.getIntNTy(reg_i.second.size * 8);
+			auto state_ptr = builder.CreateBitCast(builder.CreateConstGEP1_32(m_state.args[CompileTaskState::Args::State], reg_i.first), reg_type->getPointerTo());
+			builder.CreateAlignedStore(builder.CreateAlignedLoad(state_ptr, reg_i.second.size), reg_i.second.local, reg_i.second.size);
+		}
+	}
+}
+
 Value * Compiler::GetPc() {
 	auto pc_i8_ptr = m_ir_builder->CreateConstGEP1_32(m_state.args[CompileTaskState::Args::State], OFFSET_32(PPUThread, PC));
 	auto pc_i32_ptr = m_ir_builder->CreateBitCast(pc_i8_ptr, m_ir_builder->getInt32Ty()->getPointerTo());
@@ -5112,20 +5177,20 @@ void Compiler::SetPc(Value * val_ix) {
 }
 
 Value * Compiler::GetGpr(u32 r, u32 num_bits) {
-	auto r_i8_ptr = m_ir_builder->CreateConstGEP1_32(m_state.args[CompileTaskState::Args::State], OFFSET_32(PPUThread, GPR[r]));
+	auto r_i8_ptr = GetRegisterPtr(OFFSET_32(PPUThread, GPR[r]), 8, false);
 	auto r_ix_ptr = m_ir_builder->CreateBitCast(r_i8_ptr, m_ir_builder->getIntNTy(num_bits)->getPointerTo());
 	return m_ir_builder->CreateAlignedLoad(r_ix_ptr, 8);
 }
 
 void Compiler::SetGpr(u32 r, Value * val_x64) {
-	auto r_i8_ptr = m_ir_builder->CreateConstGEP1_32(m_state.args[CompileTaskState::Args::State], OFFSET_32(PPUThread, GPR[r]));
+	auto r_i8_ptr = GetRegisterPtr(OFFSET_32(PPUThread, GPR[r]), 8, true);
 	auto r_i64_ptr = m_ir_builder->CreateBitCast(r_i8_ptr, m_ir_builder->getInt64Ty()->getPointerTo());
 	auto val_i64 = m_ir_builder->CreateBitCast(val_x64, m_ir_builder->getInt64Ty());
 	m_ir_builder->CreateAlignedStore(val_i64, r_i64_ptr, 8);
 }
 
 Value * Compiler::GetCr() {
-	auto cr_i8_ptr = m_ir_builder->CreateConstGEP1_32(m_state.args[CompileTaskState::Args::State], OFFSET_32(PPUThread, CR));
+	auto cr_i8_ptr = GetRegisterPtr(OFFSET_32(PPUThread, CR), 4, false);
 	auto cr_i32_ptr = m_ir_builder->CreateBitCast(cr_i8_ptr, m_ir_builder->getInt32Ty()->getPointerTo());
 	return m_ir_builder->CreateAlignedLoad(cr_i32_ptr, 4);
 }
@@ -5136,7 +5201,7 @@ Value * Compiler::GetCrField(u32 n) {
 
 void Compiler::SetCr(Value * val_x32) {
 	auto val_i32 = m_ir_builder->CreateBitCast(val_x32, m_ir_builder->getInt32Ty());
-	auto cr_i8_ptr = m_ir_builder->CreateConstGEP1_32(m_state.args[CompileTaskState::Args::State], OFFSET_32(PPUThread, CR));
+	auto cr_i8_ptr = GetRegisterPtr(OFFSET_32(PPUThread, CR), 4, true);
 	auto cr_i32_ptr = m_ir_builder->CreateBitCast(cr_i8_ptr, m_ir_builder->getInt32Ty()->getPointerTo());
 	m_ir_builder->CreateAlignedStore(val_i32, cr_i32_ptr, 4);
 }
@@ -5178,33 +5243,33 @@ void Compiler::SetCr6AfterVectorCompare(u32 vr) {
 }
 
 Value * Compiler::GetLr() {
-	auto lr_i8_ptr = m_ir_builder->CreateConstGEP1_32(m_state.args[CompileTaskState::Args::State], OFFSET_32(PPUThread, LR));
+	auto lr_i8_ptr = GetRegisterPtr(OFFSET_32(PPUThread, LR), 8, false);
 	auto lr_i64_ptr = m_ir_builder->CreateBitCast(lr_i8_ptr, m_ir_builder->getInt64Ty()->getPointerTo());
 	return m_ir_builder->CreateAlignedLoad(lr_i64_ptr, 8);
 }
 
 void Compiler::SetLr(Value * val_x64) {
 	auto val_i64 = m_ir_builder->CreateBitCast(val_x64, m_ir_builder->getInt64Ty());
-	auto lr_i8_ptr = m_ir_builder->CreateConstGEP1_32(m_state.args[CompileTaskState::Args::State], OFFSET_32(PPUThread, LR));
+	auto lr_i8_ptr = GetRegisterPtr(OFFSET_32(PPUThread, LR), 8, true);
 	auto lr_i64_ptr = m_ir_builder->CreateBitCast(lr_i8_ptr, m_ir_builder->getInt64Ty()->getPointerTo());
 	m_ir_builder->CreateAlignedStore(val_i64, lr_i64_ptr, 8);
 }
 
 Value * Compiler::GetCtr() {
-	auto ctr_i8_ptr = m_ir_builder->CreateConstGEP1_32(m_state.args[CompileTaskState::Args::State], OFFSET_32(PPUThread, CTR));
+	auto ctr_i8_ptr = GetRegisterPtr(OFFSET_32(PPUThread, CTR), 8, false);
 	auto ctr_i64_ptr = m_ir_builder->CreateBitCast(ctr_i8_ptr, m_ir_builder->getInt64Ty()->getPointerTo());
 	return m_ir_builder->CreateAlignedLoad(ctr_i64_ptr, 8);
 }
 
 void Compiler::SetCtr(Value * val_x64) {
 	auto val_i64 = m_ir_builder->CreateBitCast(val_x64, m_ir_builder->getInt64Ty());
-	auto ctr_i8_ptr = m_ir_builder->CreateConstGEP1_32(m_state.args[CompileTaskState::Args::State], OFFSET_32(PPUThread, CTR));
+	auto ctr_i8_ptr = GetRegisterPtr(OFFSET_32(PPUThread, CTR), 8, true);
 	auto ctr_i64_ptr = m_ir_builder->CreateBitCast(ctr_i8_ptr, m_ir_builder->getInt64Ty()->getPointerTo());
 	m_ir_builder->CreateAlignedStore(val_i64, ctr_i64_ptr, 8);
 }
 
 Value * Compiler::GetXer() {
-	auto xer_i8_ptr = m_ir_builder->CreateConstGEP1_32(m_state.args[CompileTaskState::Args::State], OFFSET_32(PPUThread, XER));
+	auto xer_i8_ptr = GetRegisterPtr(OFFSET_32(PPUThread, XER), 8, false);
 	auto xer_i64_ptr = m_ir_builder->CreateBitCast(xer_i8_ptr, m_ir_builder->getInt64Ty()->getPointerTo());
 	return m_ir_builder->CreateAlignedLoad(xer_i64_ptr, 8);
 }
@@ -5219,7 +5284,7 @@ Value * Compiler::GetXerSo() {
 
 void Compiler::SetXer(Value * val_x64) {
 	auto val_i64 = m_ir_builder->CreateBitCast(val_x64, m_ir_builder->getInt64Ty());
-	auto xer_i8_ptr = m_ir_builder->CreateConstGEP1_32(m_state.args[CompileTaskState::Args::State], OFFSET_32(PPUThread, XER));
+	auto xer_i8_ptr = GetRegisterPtr(OFFSET_32(PPUThread, XER), 8, true);
 	auto xer_i64_ptr = m_ir_builder->CreateBitCast(xer_i8_ptr, m_ir_builder->getInt64Ty()->getPointerTo());
 	m_ir_builder->CreateAlignedStore(val_i64, xer_i64_ptr, 8);
 }
@@ -5265,7 +5330,7 @@ void Compiler::SetFpscr(Value * val_x32) {
 }
 
 Value * Compiler::GetFpr(u32 r, u32 bits, bool as_int) {
-	auto r_i8_ptr = m_ir_builder->CreateConstGEP1_32(m_state.args[CompileTaskState::Args::State], OFFSET_32(PPUThread, FPR[r]));
+	auto r_i8_ptr = GetRegisterPtr(OFFSET_32(PPUThread, FPR[r]), 8, false);
 	if (!as_int) {
 		auto r_f64_ptr = m_ir_builder->CreateBitCast(r_i8_ptr, m_ir_builder->getDoubleTy()->getPointerTo());
 		auto r_f64 = m_ir_builder->CreateAlignedLoad(r_f64_ptr, 8);
@@ -5289,7 +5354,7 @@ Value * Compiler::GetFpr(u32 r, u32 bits, bool as_int) {
 }
 
 void Compiler::SetFpr(u32 r, Value * val) {
-	auto r_i8_ptr = m_ir_builder->CreateConstGEP1_32(m_state.args[CompileTaskState::Args::State], OFFSET_32(PPUThread, FPR[r]));
+	auto r_i8_ptr = GetRegisterPtr(OFFSET_32(PPUThread, FPR[r]), 8, true);
 	auto r_f64_ptr = m_ir_builder->CreateBitCast(r_i8_ptr, m_ir_builder->getDoubleTy()->getPointerTo());
 
 	Value* val_f64;
@@ -5321,34 +5386,34 @@ void Compiler::SetVscr(Value * val_x32) {
 }
 
 Value * Compiler::GetVr(u32 vr) {
-	auto vr_i8_ptr = m_ir_builder->CreateConstGEP1_32(m_state.args[CompileTaskState::Args::State], OFFSET_32(PPUThread, VPR[vr]));
+	auto vr_i8_ptr = GetRegisterPtr(OFFSET_32(PPUThread, VPR[vr]), 16, false);
 	auto vr_i128_ptr = m_ir_builder->CreateBitCast(vr_i8_ptr, m_ir_builder->getIntNTy(128)->getPointerTo());
 	return m_ir_builder->CreateAlignedLoad(vr_i128_ptr, 16);
 }
 
 Value * Compiler::GetVrAsIntVec(u32 vr, u32 vec_elt_num_bits) {
-	auto vr_i8_ptr = m_ir_builder->CreateConstGEP1_32(m_state.args[CompileTaskState::Args::State], OFFSET_32(PPUThread, VPR[vr]));
+	auto vr_i8_ptr = GetRegisterPtr(OFFSET_32(PPUThread, VPR[vr]), 16, false);
 	auto vr_i128_ptr = m_ir_builder->CreateBitCast(vr_i8_ptr, m_ir_builder->getIntNTy(128)->getPointerTo());
 	auto vr_vec_ptr = m_ir_builder->CreateBitCast(vr_i128_ptr, VectorType::get(m_ir_builder->getIntNTy(vec_elt_num_bits), 128 / vec_elt_num_bits)->getPointerTo());
 	return m_ir_builder->CreateAlignedLoad(vr_vec_ptr, 16);
 }
 
 Value * Compiler::GetVrAsFloatVec(u32 vr) {
-	auto vr_i8_ptr = m_ir_builder->CreateConstGEP1_32(m_state.args[CompileTaskState::Args::State], OFFSET_32(PPUThread, VPR[vr]));
+	auto vr_i8_ptr = GetRegisterPtr(OFFSET_32(PPUThread, VPR[vr]), 16, false);
 	auto vr_i128_ptr = m_ir_builder->CreateBitCast(vr_i8_ptr, m_ir_builder->getIntNTy(128)->getPointerTo());
 	auto vr_v4f32_ptr = m_ir_builder->CreateBitCast(vr_i128_ptr, VectorType::get(m_ir_builder->getFloatTy(), 4)->getPointerTo());
 	return m_ir_builder->CreateAlignedLoad(vr_v4f32_ptr, 16);
 }
 
 Value * Compiler::GetVrAsDoubleVec(u32 vr) {
-	auto vr_i8_ptr = m_ir_builder->CreateConstGEP1_32(m_state.args[CompileTaskState::Args::State], OFFSET_32(PPUThread, VPR[vr]));
+	auto vr_i8_ptr = GetRegisterPtr(OFFSET_32(PPUThread, VPR[vr]), 16, false);
 	auto vr_i128_ptr = m_ir_builder->CreateBitCast(vr_i8_ptr, m_ir_builder->getIntNTy(128)->getPointerTo());
 	auto vr_v2f64_ptr = m_ir_builder->CreateBitCast(vr_i128_ptr, VectorType::get(m_ir_builder->getDoubleTy(), 2)->getPointerTo());
 	return m_ir_builder->CreateAlignedLoad(vr_v2f64_ptr, 16);
 }
 
 void Compiler::SetVr(u32 vr, Value * val_x128) {
-	auto vr_i8_ptr = m_ir_builder->CreateConstGEP1_32(m_state.args[CompileTaskState::Args::State], OFFSET_32(PPUThread, VPR[vr]));
+	auto vr_i8_ptr = GetRegisterPtr(OFFSET_32(PPUThread, VPR[vr]), 16, true);
 	auto vr_i128_ptr = m_ir_builder->CreateBitCast(vr_i8_ptr, m_ir_builder->getIntNTy(128)->getPointerTo());
 	auto val_i128 = m_ir_builder->CreateBitCast(val_x128, m_ir_builder->getIntNTy(128));
 	m_ir_builder->CreateAlignedStore(val_i128, vr_i128_ptr, 16);
@@ -5416,11 +5481,31 @@ void Compiler::CreateBranch(llvm::Value * cmp_i1, llvm::Value * target_i32, bool
 			}
 
 			SetPc(target_i32);
-//			Function *fn = m_module->getFunction(fmt::format("function_0x%08X", target_address));
 			llvm::Value *execStatus;
-//			if (fn)
-//				execStatus = m_ir_builder->CreateCall2(fn, m_state.args[CompileTaskState::Args::State], m_ir_builder->getInt64(0));
-//			else
+			if (Executable *slot = m_recompilation_engine ? m_recompilation_engine->GetCallSlot(target_address) : nullptr) {
+				// Call the compiled callee through its call slot, the dispatcher is only used while the slot is empty
+				auto slot_ptr = m_ir_builder->CreateIntToPtr(m_ir_builder->getInt64((u64)slot), m_compiled_function_type->getPointerTo()->getPointerTo());
+				auto callee = (Value *)m_ir_builder->CreateLoad(slot_ptr, true);
+				auto is_linked_i1 = m_ir_builder->CreateICmpNE(callee, ConstantPointerNull::get(m_compiled_function_type->getPointerTo()));
+				callee = m_ir_builder->CreateSelect(is_linked_i1, callee, m_execute_unknown_function);
+				auto call = m_ir_builder->CreateCall2(callee, m_state.args[CompileTaskState::Args::State], m_ir_builder->getInt64(0));
+				call->setCallingConv(CallingConv::X86_64_Win64);
+
+				// A compiled block may end before the callee returns, continue it in the dispatcher
+				llvm::BasicBlock *current_bb = m_ir_builder->GetInsertBlock();
+				llvm::BasicBlock *resume_bb = GetBasicBlockFromAddress(m_state.current_instruction_address, "callee_resume");
+				llvm::BasicBlock *done_bb = GetBasicBlockFromAddress(m_state.current_instruction_address, "callee_done");
+				m_ir_builder->CreateCondBr(m_ir_builder->CreateICmpEQ(call, m_ir_builder->getInt32(ExecutionStatus::ExecutionStatusBlockEnded)), resume_bb, done_bb);
+				m_ir_builder->SetInsertPoint(resume_bb);
+				auto resume_status = m_ir_builder->CreateCall2(m_execute_unknown_block, m_state.args[CompileTaskState::Args::State], m_ir_builder->getInt64(0));
+				m_ir_builder->CreateBr(done_bb);
+				m_ir_builder->SetInsertPoint(done_bb);
+				auto status_phi = m_ir_builder->CreatePHI(m_ir_builder->getInt32Ty(), 2);
+				status_phi->addIncoming(call, current_bb);
+				status_phi->addIncoming(resume_status, resume_bb);
+				execStatus = status_phi;
+			}
+			else
 				execStatus = Call<u32>("execute_unknown_function", m_state.args[CompileTaskState::Args::State], m_ir_builder->getInt64(0));
 
 			llvm::BasicBlock *cputhreadexitblock = GetBasicBlockFromAddress(m_state.current_instruction_address, "early_exit");
@@ -5488,11 +5573,12 @@ void Compiler::CreateBranch(llvm::Value * cmp_i1, llvm::Value * target_i32, bool
 }
 
 // FIXME: Find out why alignement is needed
-Value * Compiler::ReadMemory(Value * addr_i64, u32 bits, u32 alignment, bool bswap, bool could_be_mmio) {
+Value * Compiler::ReadMemory(Value * addr_i64, u32 bits, u32 alignment, bool bswap) {
 	addr_i64 = m_ir_builder->CreateAnd(addr_i64, 0xFFFFFFFF);
 	auto eaddr_i64 = m_ir_builder->CreateAdd(addr_i64, m_ir_builder->getInt64((u64)vm::base(0)));
 	auto eaddr_ix_ptr = m_ir_builder->CreateIntToPtr(eaddr_i64, m_ir_builder->getIntNTy(bits)->getPointerTo());
 	auto val_ix = (Value *)m_ir_builder->CreateLoad(eaddr_ix_ptr);
+	AddMemoryAccess(cast<Instruction>(val_ix));
 	if (bits > 8 && bswap) {
 		val_ix = m_ir_builder->CreateCall(Intrinsic::getDeclaration(m_module, Intrinsic::bswap, m_ir_builder->getIntNTy(bits)), val_ix);
 	}
@@ -5500,7 +5586,7 @@ Value * Compiler::ReadMemory(Value * addr_i64, u32 bits, u32 alignment, bool bsw
 	return val_ix;
 }
 
-void Compiler::WriteMemory(Value * addr_i64, Value * val_ix, u32 alignment, bool bswap, bool could_be_mmio) {
+void Compiler::WriteMemory(Value * addr_i64, Value * val_ix, u32 alignment, bool bswap) {
 	if (val_ix->getType()->getIntegerBitWidth() > 8 && bswap) {
 		val_ix = m_ir_builder->CreateCall(Intrinsic::getDeclaration(m_module, Intrinsic::bswap, val_ix->getType()), val_ix);
 	}
@@ -5508,7 +5594,13 @@ void Compiler::WriteMemory(Value * addr_i64, Value * val_ix, u32 alignment, bool
 	addr_i64 = m_ir_builder->CreateAnd(addr_i64, 0xFFFFFFFF);
 	auto eaddr_i64 = m_ir_builder->CreateAdd(addr_i64, m_ir_builder->getInt64((u64)vm::base(0)));
 	auto eaddr_ix_ptr = m_ir_builder->CreateIntToPtr(eaddr_i64, val_ix->getType()->getPointerTo());
-	m_ir_builder->CreateAlignedStore(val_ix, eaddr_ix_ptr, alignment);
+	AddMemoryAccess(m_ir_builder->CreateAlignedStore(val_ix, eaddr_ix_ptr, alignment));
+}
+
+void Compiler::AddMemoryAccess(Instruction * inst) {
+	if (m_state.promote_registers) {
+		m_state.memory_accesses.push_back(inst);
+	}
 }
 
 void Compiler::CompilationError(const std::string & error) {
@@ -8,6 +8,7 @@
 #include "Emu/Cell/PPUInterpreter.h"
 #include "Emu/Cell/PPUInterpreter2.h"
 #include "Emu/Cell/PPULLVMRecompiler.h"
+#include "Emu/Cell/PPUASMJITRecompiler.h"
 //#include "Emu/Cell/PPURecompiler.h"
 #include "Utilities/VirtualMemory.h"
 
@@ -24,26 +25,73 @@ extern u32 ppu_get_tls(u32 thread);
 extern void ppu_free_tls(u32 thread);
 
 //thread_local const std::weak_ptr<ppu_decoder_cache_t> g_tls_ppu_decoder_cache = fxm::get<ppu_decoder_cache_t>();
-thread_local const ppu_decoder_cache_t* g_tls_ppu_decoder_cache = nullptr; // temporarily, because thread_local is not fully available
+thread_local ppu_decoder_cache_t* g_tls_ppu_decoder_cache = nullptr; // temporarily, because thread_local is not fully available
+
+// Used by vm with the reservation lock held and by the access violation handler, where fxm can't be accessed
+static std::atomic<ppu_decoder_cache_t*> g_ppu_decoder_cache{};
 
 ppu_decoder_cache_t::ppu_decoder_cache_t()
 	: pointer(static_cast<decltype(pointer)>(memory_helper::reserve_memory(0x200000000)))
 {
+	g_ppu_decoder_cache = this;
 }
 
 ppu_decoder_cache_t::~ppu_decoder_cache_t()
 {
+	ppu_decoder_cache_t* _this = this;
+	g_ppu_decoder_cache.compare_exchange_strong(_this, nullptr);
 	memory_helper::free_reserved_memory(pointer, 0x200000000);
 }
 
 void ppu_decoder_cache_t::initialize(u32 addr, u32 size)
 {
-	memory_helper::commit_page_memory(pointer + addr / 4, size * 2);
+	for (u64 i = addr / 4096; i < (u64{ addr } + size + 4095) / 4096; i++)
+	{
+		const u32 page = static_cast<u32>(i * 4096);
+
+		// restore write access if the page is write-protected by a decoder
+		vm::invalidate_code(page);
+
+		if (pages[i] & page_committed)
+		{
+			discard(page, 4096);
+			continue;
+		}
+
+		memory_helper::commit_page_memory(pointer + page / 4, 4096 * 2);
+
+		pages[i] |= page_committed;
+	}
+}
+
+bool ppu_decoder_cache_t::decode_page(u32 addr)
+{
+	const u32 page = addr & ~0xfff;
+
+	if (!vm::check_addr(page, 4096))
+	{
+		return false;
+	}
+
+	if (!(pages[page / 4096] & page_committed))
+	{
+		initialize(page, 4096);
+	}
+
+	// set the flag before the page is write-protected, so the write fault in any moment is handled by discard()
+	pages[page / 4096] |= page_decoded;
+
+	// write-protect the page (it may be already protected by another thread)
+	if (!vm::page_protect(page, 4096, vm::page_writable, vm::page_executable, vm::page_writable) && !vm::page_protect(page, 4096, vm::page_executable))
+	{
+		pages[page / 4096] &= ~page_decoded;
+		return false;
+	}
 
 	PPUInterpreter2* inter;
 	PPUDecoder dec(inter = new PPUInterpreter2);
 
-	for (u32 pos = addr; pos < addr + size; pos += 4)
+	for (u32 pos = page; pos < page + 4096; pos += 4)
 	{
 		inter->func = ppu_interpreter::NULL_OP;
 
@@ -53,6 +101,65 @@ void ppu_decoder_cache_t::initialize(u32 addr, u32 size)
 		// store function address
 		pointer[pos / 4] = inter->func;
 	}
+
+	// the page was written during decoding: entries are discarded and the page is decoded again on next execution
+	if (!(pages[page / 4096] & page_decoded))
+	{
+		std::fill_n(pointer + page / 4, 1024, nullptr);
+	}
+
+	return true;
+}
+
+void ppu_decoder_cache_t::discard(u32 addr, u32 size)
+{
+	for (u64 i = addr / 4096; i < (u64{ addr } + size + 4095) / 4096; i++)
+	{
+		// clear the flag first, so decode_page() notices the discard
+		if (pages[i]._and_not(page_decoded) & page_decoded)
+		{
+			std::fill_n(pointer + i * 1024, 1024, nullptr);
+		}
+	}
+}
+
+ppu_inter_func_t ppu_decoder_cache_t::decode(u32 opcode)
+{
+	PPUInterpreter2* inter;
+	PPUDecoder dec(inter = new PPUInterpreter2);
+
+	inter->func = ppu_interpreter::NULL_OP;
+	dec.Decode(opcode);
+	return inter->func;
+}
+
+bool ppu_commit_decoder_table(const void* ptr)
+{
+	if (const auto decoder_cache = g_ppu_decoder_cache.load())
+	{
+		const u64 offset = reinterpret_cast<u64>(ptr) - reinterpret_cast<u64>(decoder_cache->pointer);
+
+		if (offset < 0x200000000)
+		{
+			// entries of the page are null: it's decoded by decode_page() on execution, which also sets page_committed
+			memory_helper::commit_page_memory(decoder_cache->pointer + (offset & ~0x1fff) / sizeof(ppu_inter_func_t), 4096 * 2);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void ppu_discard_code(u32 addr, u32 size)
+{
+	if (const auto decoder_cache = g_ppu_decoder_cache.load())
+	{
+		decoder_cache->discard(addr, size);
+	}
+
+#ifdef PPU_LLVM_RECOMPILER
+	ppu_recompiler_llvm::RecompilationEngine::DiscardCode(addr, size);
+#endif
 }
 
 PPUThread::PPUThread(const std::string& name)
@@ -162,6 +269,13 @@ void PPUThread::do_run()
 		break;
 	}
 
+	case ppu_decoder_type::recompiler_asmjit:
+	{
+		// shared by all threads, blocks are executed by cpu_task()
+		fxm::get_always<ppu_recompiler>();
+		break;
+	}
+
 	//case 3: m_dec.reset(new PPURecompiler(*this)); break;
 
 	default:
@@ -282,7 +396,9 @@ void PPUThread::cpu_task()
 		g_tls_ppu_decoder_cache = decoder_cache.get(); // unsafe (TODO)
 	}
 	
-	const auto exec_map = g_tls_ppu_decoder_cache->pointer;
+	const auto decoder_cache = g_tls_ppu_decoder_cache;
+
+	const auto exec_map = decoder_cache->pointer;
 
 	if (m_dec)
 	{
@@ -297,13 +413,50 @@ void PPUThread::cpu_task()
 			PC += 4;
 		}
 	}
+	else if (const auto recompiler = rpcs3::state.config.core.ppu_decoder.value() == ppu_decoder_type::recompiler_asmjit ? fxm::get<ppu_recompiler>() : nullptr)
+	{
+		while (true)
+		{
+			if (m_state && check_status()) break;
+
+			// execute compiled block (it sets PC to the next address)
+			if (recompiler->get_block(PC)(this))
+			{
+				std::exception_ptr exception = std::move(pending_exception);
+				pending_exception = nullptr;
+				std::rethrow_exception(exception);
+			}
+		}
+	}
 	else
 	{
 		while (true)
 		{
-			// get cached interpreter function address
+			// get cached interpreter function address (table memory which is not committed yet is committed by the access violation handler)
 			const auto func = exec_map[PC / 4];
 
+			// decode the page on first execution or after invalidation
+			if (!func)
+			{
+				if (decoder_cache->decode_page(PC))
+				{
+					continue;
+				}
+
+				if (!vm::check_addr(PC, 4))
+				{
+					throw EXCEPTION("Invalid PC (0x%08x)", PC);
+				}
+
+				// the page can't be cached, decode every instruction
+				if (m_state && check_status()) break;
+
+				const u32 opcode = vm::ps3::read32(PC);
+				ppu_decoder_cache_t::decode(opcode)(*this, { opcode });
+				PC += 4;
+				continue;
+			}
+
 			// check status
 			if (!m_state)
 			{
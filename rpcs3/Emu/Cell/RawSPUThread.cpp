@@ -11,6 +11,7 @@ thread_local spu_mfc_arg_t raw_spu_mfc[8] = {};
 RawSPUThread::RawSPUThread(const std::string& name, u32 index)
 	: SPUThread(CPU_THREAD_RAW_SPU, name, index, RAW_SPU_BASE_ADDR + RAW_SPU_OFFSET * index)
 {
+	// only LS is allocated: the problem state area is left unmapped, so every access faults and is emulated by the access violation handler
 	CHECK_ASSERTION(vm::falloc(offset, 0x40000) == offset);
 }
 
@@ -1,5 +1,6 @@
 #include "stdafx.h"
 #include "Emu/System.h"
+#include "Emu/perf.h"
 
 #include "SPUDisAsm.h"
 #include "SPUThread.h"
@@ -47,6 +48,8 @@ void spu_recompiler::compile(spu_function_t& f)
 		throw EXCEPTION("Invalid SPU function (addr=0x%05x, size=0x%x)", f.addr, f.size);
 	}
 
+	perf::scope perf_scope(perf::counter::jit_compile, f.addr);
+
 	using namespace asmjit;
 
 	SPUDisAsm dis_asm(CPUDisAsm_InterpreterMode);
@@ -257,7 +260,7 @@ inline asmjit::X86Mem spu_recompiler::XmmConst(__m128i data)
 	return XmmConst(v128::fromV(data));
 }
 
-void spu_recompiler::InterpreterCall(spu_opcode_t op)
+void spu_recompiler::InterpreterCall(spu_opcode_t op, spu_inter_func_t func)
 {
 	auto gate = [](SPUThread* _spu, u32 opcode, spu_inter_func_t _func) noexcept -> u32
 	{
@@ -294,7 +297,7 @@ void spu_recompiler::InterpreterCall(spu_opcode_t op)
 	asmjit::X86CallNode* call = c->call(asmjit::imm_ptr(asmjit_cast<void*, u32(SPUThread*, u32, spu_inter_func_t)>(gate)), asmjit::kFuncConvHost, asmjit::FuncBuilder3<u32, void*, u32, void*>());
 	call->setArg(0, *cpu);
 	call->setArg(1, asmjit::imm_u(op.opcode));
-	call->setArg(2, asmjit::imm_ptr(asmjit_cast<void*>(spu_interpreter::fast::g_spu_opcode_table[op.opcode])));
+	call->setArg(2, asmjit::imm_ptr(asmjit_cast<void*>(func ? func : spu_interpreter::fast::g_spu_opcode_table[op.opcode])));
 	call->setRet(0, *addr);
 
 	// return immediately if an error occured
@@ -381,6 +384,12 @@ void spu_recompiler::FunctionCall()
 
 void spu_recompiler::STOP(spu_opcode_t op)
 {
+	if (spu_is_hle_trap(op.opcode))
+	{
+		// HLE hook: call the HLE dispatcher directly
+		return InterpreterCall(op, &spu_interpreter::HLE);
+	}
+
 	InterpreterCall(op); // TODO
 }
 
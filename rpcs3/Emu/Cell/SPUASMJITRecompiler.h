@@ -1,6 +1,7 @@
 #pragma once
 
 #include "SPURecompiler.h"
+#include "SPUInterpreter.h"
 
 namespace asmjit
 {
@@ -76,7 +77,7 @@ private:
 	asmjit::X86Mem XmmConst(__m128i data);
 
 private:
-	void InterpreterCall(spu_opcode_t op);
+	void InterpreterCall(spu_opcode_t op, spu_inter_func_t func = nullptr);
 	void FunctionCall();
 
 	void STOP(spu_opcode_t op);
@@ -44,8 +44,18 @@ void spu_interpreter::set_interrupt_status(SPUThread& spu, spu_opcode_t op)
 }
 
 
+void spu_interpreter::HLE(SPUThread& spu, spu_opcode_t op)
+{
+	spu.call_hle_function(op.opcode & 0x3fff);
+}
+
 void spu_interpreter::STOP(SPUThread& spu, spu_opcode_t op)
 {
+	if (spu_is_hle_trap(op.opcode))
+	{
+		return HLE(spu, op);
+	}
+
 	spu.stop_and_signal(op.opcode & 0x3fff);
 }
 
@@ -6,6 +6,38 @@ class SPUThread;
 
 using spu_inter_func_t = void(*)(SPUThread& spu, spu_opcode_t opcode);
 
+// Interpreter functions of decoded LS instructions, indexed by guest address
+struct spu_decoder_cache_t
+{
+	spu_inter_func_t* const pointer;
+
+	// State of every 4 KiB page in the table (see flags below)
+	std::array<atomic_t<u8>, 0x100000000ull / 4096> pages{};
+
+	// Invalidation count of every page (to detect pages mixing code and data)
+	std::array<atomic_t<u8>, 0x100000000ull / 4096> writes{};
+
+	enum : u8
+	{
+		page_committed = (1 << 0), // table memory is available, null entries are decoded on demand
+		page_decoded   = (1 << 1), // table entries are valid and the guest page is write-protected (and marked executable)
+		page_volatile  = (1 << 2), // page is written too often, its instructions are not cached
+	};
+
+	spu_decoder_cache_t();
+
+	~spu_decoder_cache_t();
+
+	// Discard decoded entries in the specified range (called for new Local Storage)
+	void initialize(u32 addr, u32 size);
+
+	// Decode the page containing addr and write-protect it (returns false if the page can't be cached)
+	bool decode_page(u32 addr, const spu_opcode_table_t<spu_inter_func_t>& table);
+
+	// Discard decoded entries in the specified range without restoring write access (called by vm with the reservation lock held)
+	void discard(u32 addr, u32 size);
+};
+
 namespace spu_interpreter
 {
 	namespace fast
@@ -21,6 +53,9 @@ namespace spu_interpreter
 	void default_function(SPUThread& spu, spu_opcode_t op);
 	void set_interrupt_status(SPUThread& spu, spu_opcode_t op);
 
+	// HLE hook (STOP with a reserved signal code, decoded separately)
+	void HLE(SPUThread& spu, spu_opcode_t op);
+
 	void STOP(SPUThread& spu, spu_opcode_t op);
 	void LNOP(SPUThread& spu, spu_opcode_t op);
 	void SYNC(SPUThread& spu, spu_opcode_t op);
@@ -2,6 +2,7 @@
 #include "Emu/Memory/Memory.h"
 #include "Emu/System.h"
 #include "Emu/state.h"
+#include "Emu/perf.h"
 
 #include "Emu/IdManager.h"
 #include "Emu/Cell/PPUThread.h"
@@ -15,6 +16,7 @@
 #include "Emu/Cell/SPUThread.h"
 #include "Emu/Cell/SPUInterpreter.h"
 #include "Emu/Cell/SPURecompiler.h"
+#include "Utilities/VirtualMemory.h"
 
 #include <cfenv>
 
@@ -25,6 +27,136 @@ const spu_opcode_table_t<void(SPUDisAsm::*)(spu_opcode_t)> SPUDisAsm::opcodes{ D
 
 thread_local bool spu_channel_t::notification_required;
 
+// Used by vm with the reservation lock held, where fxm can't be accessed
+static std::atomic<spu_decoder_cache_t*> g_spu_decoder_cache{};
+
+spu_decoder_cache_t::spu_decoder_cache_t()
+	: pointer(static_cast<decltype(pointer)>(memory_helper::reserve_memory(0x200000000)))
+{
+	g_spu_decoder_cache = this;
+}
+
+spu_decoder_cache_t::~spu_decoder_cache_t()
+{
+	spu_decoder_cache_t* _this = this;
+	g_spu_decoder_cache.compare_exchange_strong(_this, nullptr);
+	memory_helper::free_reserved_memory(pointer, 0x200000000);
+}
+
+void spu_decoder_cache_t::initialize(u32 addr, u32 size)
+{
+	for (u64 i = addr / 4096; i < (u64{ addr } + size + 4095) / 4096; i++)
+	{
+		const u32 page = static_cast<u32>(i * 4096);
+
+		// restore write access if the page is write-protected by a decoder
+		vm::invalidate_code(page);
+
+		writes[i] = 0;
+		pages[i] &= ~page_volatile;
+
+		if (pages[i] & page_committed)
+		{
+			discard(page, 4096);
+			continue;
+		}
+
+		memory_helper::commit_page_memory(pointer + page / 4, 4096 * 2);
+
+		pages[i] |= page_committed;
+	}
+}
+
+bool spu_decoder_cache_t::decode_page(u32 addr, const spu_opcode_table_t<spu_inter_func_t>& table)
+{
+	const u32 page = addr & ~0xfff;
+
+	if (pages[page / 4096] & page_volatile)
+	{
+		return false;
+	}
+
+	// set the flag before the page is write-protected, so the write fault in any moment is handled by discard()
+	pages[page / 4096] |= page_decoded;
+
+	// write-protect the page (it may be already protected by the PPU decoder)
+	if (!vm::page_protect(page, 4096, vm::page_writable, vm::page_executable, vm::page_writable) && !vm::page_protect(page, 4096, vm::page_executable))
+	{
+		pages[page / 4096] &= ~page_decoded;
+		return false;
+	}
+
+	for (u32 pos = page; pos < page + 4096; pos += 4)
+	{
+		const u32 opcode = vm::ps3::read32(pos);
+
+		// HLE hooks are dispatched directly (STOP with the upper bits clear and a reserved signal code)
+		pointer[pos / 4] = spu_is_hle_trap(opcode) ? &spu_interpreter::HLE : table[opcode];
+	}
+
+	// the page was written during decoding: entries are discarded and the page is decoded again on next execution
+	if (!(pages[page / 4096] & page_decoded))
+	{
+		std::fill_n(pointer + page / 4, 1024, nullptr);
+	}
+
+	return true;
+}
+
+void spu_decoder_cache_t::discard(u32 addr, u32 size)
+{
+	for (u64 i = addr / 4096; i < (u64{ addr } + size + 4095) / 4096; i++)
+	{
+		// clear the flag first, so decode_page() notices the discard
+		if (pages[i]._and_not(page_decoded) & page_decoded)
+		{
+			std::fill_n(pointer + i * 1024, 1024, nullptr);
+
+			// stop caching pages which are written repeatedly (code mixed with data)
+			if (++writes[i] >= 16)
+			{
+				pages[i] |= page_volatile;
+			}
+		}
+	}
+}
+
+std::atomic<spu_hle_func_t> g_spu_hle_functions[SPU_HLE_MAX_FUNCTIONS]{};
+
+void SPUThread::RegisterHleFunction(u32 addr, spu_hle_func_t function)
+{
+	static std::mutex mutex;
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	// HLE functions are static, so the index of each function is allocated once and never released
+	u32 index = 0;
+
+	// entries are only written under the mutex, other threads read them in call_hle_function()
+	while (index < SPU_HLE_MAX_FUNCTIONS && g_spu_hle_functions[index].load(std::memory_order_relaxed) && g_spu_hle_functions[index].load(std::memory_order_relaxed) != function)
+	{
+		index++;
+	}
+
+	if (index >= SPU_HLE_MAX_FUNCTIONS)
+	{
+		throw EXCEPTION("Too many HLE functions (addr=0x%05x)", addr);
+	}
+
+	// the function must be visible before the trap is written to LS
+	g_spu_hle_functions[index].store(function, std::memory_order_release);
+
+	_ref<u32>(addr) = SPU_HLE_TRAP | index; // STOP
+}
+
+void spu_discard_code(u32 addr, u32 size)
+{
+	if (const auto decoder_cache = g_spu_decoder_cache.load())
+	{
+		decoder_cache->discard(addr, size);
+	}
+}
+
 void spu_int_ctrl_t::set(u64 ints)
 {
 	// leave only enabled interrupts
@@ -64,6 +196,12 @@ SPUThread::SPUThread(const std::string& name, u32 index)
 	, offset(vm::alloc(0x40000, vm::main))
 {
 	CHECK_ASSERTION(offset);
+
+	// discard instructions decoded from the previous allocation at this address
+	if (const auto decoder_cache = fxm::get<spu_decoder_cache_t>())
+	{
+		decoder_cache->initialize(offset, 0x40000);
+	}
 }
 
 SPUThread::~SPUThread()
@@ -112,6 +250,49 @@ void SPUThread::cpu_task()
 		// LS base address
 		const auto base = vm::_ptr<const u32>(offset);
 
+		if (const auto decoder_cache = fxm::get<spu_decoder_cache_t>())
+		{
+			if (!(decoder_cache->pages[offset / 4096] & spu_decoder_cache_t::page_committed))
+			{
+				decoder_cache->initialize(offset, 0x40000);
+			}
+
+			// cached interpreter functions of LS instructions
+			const auto exec_map = decoder_cache->pointer + offset / 4;
+
+			while (true)
+			{
+				if (!m_state)
+				{
+					if (const auto func = exec_map[pc / 4])
+					{
+						func(*this, { base[pc / 4] });
+
+						pc += 4;
+
+						continue;
+					}
+
+					// decode the page on first execution or after invalidation
+					if (!decoder_cache->decode_page(offset + pc, table))
+					{
+						const u32 opcode = base[pc / 4];
+
+						table[opcode](*this, { opcode });
+
+						pc += 4;
+					}
+
+					continue;
+				}
+
+				if (check_status())
+				{
+					return;
+				}
+			}
+		}
+
 		while (true)
 		{
 			if (!m_state)
@@ -301,6 +482,8 @@ void SPUThread::do_dma_transfer(u32 cmd, spu_mfc_arg_t args)
 		}
 	}
 
+	perf::add(perf::counter::spu_dma, cmd & ~(MFC_BARRIER_MASK | MFC_FENCE_MASK), args.size);
+
 	switch (cmd & ~(MFC_BARRIER_MASK | MFC_FENCE_MASK))
 	{
 	case MFC_PUT_CMD:
@@ -415,6 +598,9 @@ void SPUThread::process_mfc_cmd(u32 cmd)
 
 		const u32 raddr = VM_CAST(ch_mfc_args.ea);
 
+		// restore write access to LS before the reservation is locked (the copy must not fault while it's locked)
+		vm::invalidate_code(offset + ch_mfc_args.lsa);
+
 		vm::reservation_acquire(vm::base(offset + ch_mfc_args.lsa), raddr, 128);
 
 		if (last_raddr)
@@ -599,7 +785,7 @@ u32 SPUThread::get_ch_value(u32 ch)
 {
 	LOG_TRACE(SPU, "get_ch_value(ch=%d [%s])", ch, ch < 128 ? spu_ch_name[ch] : "???");
 
-	auto read_channel = [this](spu_channel_t& channel) -> u32
+	auto read_channel = [this, ch](spu_channel_t& channel) -> u32
 	{
 		std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
 
@@ -625,6 +811,7 @@ u32 SPUThread::get_ch_value(u32 ch)
 				continue;
 			}
 
+			perf::scope perf_scope(perf::counter::spu_channel_stall, ch);
 			cv.wait(lock);
 		}
 	};
@@ -666,6 +853,7 @@ u32 SPUThread::get_ch_value(u32 ch)
 				continue;
 			}
 
+			perf::scope perf_scope(perf::counter::spu_channel_stall, ch);
 			cv.wait(lock);
 		}
 	}
@@ -722,6 +910,8 @@ u32 SPUThread::get_ch_value(u32 ch)
 
 		if (ch_event_mask & SPU_EVENT_LR)
 		{
+			perf::scope perf_scope(perf::counter::spu_channel_stall, ch);
+
 			// register waiter if polling reservation status is required
 			vm::wait_op(*this, last_raddr, 128, WRAP_EXPR(get_events(true) || is_stopped()));
 		}
@@ -734,6 +924,7 @@ u32 SPUThread::get_ch_value(u32 ch)
 			{
 				CHECK_EMU_STATUS;
 
+				perf::scope perf_scope(perf::counter::spu_channel_stall, ch);
 				cv.wait(lock);
 			}
 		}
@@ -783,6 +974,7 @@ void SPUThread::set_ch_value(u32 ch, u32 value)
 					continue;
 				}
 
+				perf::scope perf_scope(perf::counter::spu_channel_stall, ch);
 				cv.wait(lock);
 			}
 
@@ -987,6 +1179,7 @@ void SPUThread::set_ch_value(u32 ch, u32 value)
 				continue;
 			}
 
+			perf::scope perf_scope(perf::counter::spu_channel_stall, ch);
 			cv.wait(lock);
 		}
 
@@ -1154,7 +1347,15 @@ void SPUThread::stop_and_signal(u32 code)
 	{
 	case 0x001:
 	{
-		std::this_thread::sleep_for(std::chrono::milliseconds(1)); // hack
+		// yield: wait for at most 1ms, set_events() wakes the thread earlier
+		std::unique_lock<std::mutex> lock(mutex);
+
+		if (!get_events(true) && !is_stopped())
+		{
+			cv.wait_for(lock, std::chrono::milliseconds(1));
+		}
+
+		ch_event_stat &= ~SPU_EVENT_WAITING;
 		return;
 	}
 
@@ -1164,23 +1365,6 @@ void SPUThread::stop_and_signal(u32 code)
 		return;
 	}
 
-	case 0x003:
-	{
-		const auto found = m_addr_to_hle_function_map.find(pc);
-
-		if (found == m_addr_to_hle_function_map.end())
-		{
-			throw EXCEPTION("HLE function not registered (PC=0x%05x)", pc);
-		}
-
-		if (const auto return_to_caller = found->second(*this))
-		{
-			pc = (gpr[0]._u32[3] & 0x3fffc) - 4;
-		}
-
-		return;
-	}
-
 	case 0x110:
 	{
 		/* ===== sys_spu_thread_receive_event ===== */
@@ -1236,14 +1420,19 @@ void SPUThread::stop_and_signal(u32 code)
 			return ch_in_mbox.set_values(1, CELL_EINVAL); // TODO: check error value
 		}
 
-		// check thread group status
-		while (group->state >= SPU_THREAD_GROUP_STATUS_WAITING && group->state <= SPU_THREAD_GROUP_STATUS_SUSPENDED)
+		// check thread group status (woken up by the group resume or by other thread receiving its event)
+		if (group->state >= SPU_THREAD_GROUP_STATUS_WAITING && group->state <= SPU_THREAD_GROUP_STATUS_SUSPENDED)
 		{
-			CHECK_EMU_STATUS;
+			sleep_queue_entry_t waiter(*this, group->sq);
 
-			if (is_stopped()) throw CPUThreadStop{};
+			while (group->state >= SPU_THREAD_GROUP_STATUS_WAITING && group->state <= SPU_THREAD_GROUP_STATUS_SUSPENDED)
+			{
+				CHECK_EMU_STATUS;
 
-			group->cv.wait_for(lv2_lock, std::chrono::milliseconds(1));
+				if (is_stopped()) throw CPUThreadStop{};
+
+				cv.wait(lv2_lock);
+			}
 		}
 
 		// change group status
@@ -1305,7 +1494,7 @@ void SPUThread::stop_and_signal(u32 code)
 			if (thread) thread->awake(); // untrigger status check
 		}
 
-		group->cv.notify_all();
+		group->notify_all(lv2_lock);
 
 		return;
 	}
@@ -1345,7 +1534,7 @@ void SPUThread::stop_and_signal(u32 code)
 		group->state = SPU_THREAD_GROUP_STATUS_INITIALIZED;
 		group->exit_status = value;
 		group->join_state |= SPU_TGJSF_GROUP_EXIT;
-		group->cv.notify_one();
+		group->notify_all(lv2_lock);
 
 		return stop();
 	}
@@ -1371,7 +1560,7 @@ void SPUThread::stop_and_signal(u32 code)
 		}
 
 		status |= SPU_STATUS_STOPPED_BY_STOP;
-		group->cv.notify_one();
+		group->notify_all(lv2_lock);
 
 		return stop();
 	}
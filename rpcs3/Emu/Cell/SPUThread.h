@@ -526,6 +526,27 @@ public:
 	}
 };
 
+class SPUThread;
+
+// HLE function executed instead of hooked SPU code (returns true to return to the caller)
+using spu_hle_func_t = bool(*)(SPUThread& spu);
+
+// HLE hooks are written to LS as STOP instructions with reserved signal codes, the low bits select the function
+enum : u32
+{
+	SPU_HLE_TRAP = 0x3f00,
+	SPU_HLE_MAX_FUNCTIONS = 0x100,
+};
+
+// Check whether the instruction is an HLE hook (used by every SPU decoder, so all of them agree on hooked STOP codes)
+inline bool spu_is_hle_trap(u32 opcode)
+{
+	return (opcode & ~(SPU_HLE_MAX_FUNCTIONS - 1)) == SPU_HLE_TRAP;
+}
+
+// Registered HLE functions, indexed by the low bits of the trap code (published with release ordering)
+extern std::atomic<spu_hle_func_t> g_spu_hle_functions[SPU_HLE_MAX_FUNCTIONS];
+
 class SPUThread : public CPUThread
 {
 	friend class SPURecompilerDecoder;
@@ -535,8 +556,6 @@ public:
 	std::array<v128, 128> gpr; // General-Purpose Registers
 	SPU_FPSCR fpscr;
 
-	std::unordered_map<u32, std::function<bool(SPUThread& SPU)>> m_addr_to_hle_function_map;
-
 	spu_mfc_arg_t ch_mfc_args;
 
 	std::vector<std::pair<u32, spu_mfc_arg_t>> mfc_queue; // Only used for stalled list transfers
@@ -630,29 +649,23 @@ public:
 		return *_ptr<T>(lsa);
 	}
 
-	void RegisterHleFunction(u32 addr, std::function<bool(SPUThread & SPU)> function)
-	{
-		m_addr_to_hle_function_map[addr] = function;
-		_ref<u32>(addr) = 0x00000003; // STOP 3
-	}
+	// Hook the instruction at the specified LS address (the hook is removed when LS is overwritten)
+	void RegisterHleFunction(u32 addr, spu_hle_func_t function);
 
-	void UnregisterHleFunction(u32 addr)
+	// Execute the HLE function selected by the trap code (STOP signal code)
+	void call_hle_function(u32 code)
 	{
-		m_addr_to_hle_function_map.erase(addr);
-	}
+		const auto func = g_spu_hle_functions[code % SPU_HLE_MAX_FUNCTIONS].load(std::memory_order_acquire);
 
-	void UnregisterHleFunctions(u32 start_addr, u32 end_addr)
-	{
-		for (auto iter = m_addr_to_hle_function_map.begin(); iter != m_addr_to_hle_function_map.end();)
+		// not a hook
+		if (!func || m_type == CPU_THREAD_RAW_SPU)
 		{
-			if (iter->first >= start_addr && iter->first <= end_addr)
-			{
-				m_addr_to_hle_function_map.erase(iter++);
-			}
-			else
-			{
-				iter++;
-			}
+			return stop_and_signal(code);
+		}
+
+		if (func(*this))
+		{
+			pc = (gpr[0]._u32[3] & 0x3fffc) - 4;
 		}
 	}
 
@@ -1,6 +1,228 @@
 #include "stdafx.h"
 #include "HDD.h"
 
+// Bitmaps of opened images by path (released with the last vfsHDD instance)
+static std::mutex g_hdd_maps_mutex;
+static std::unordered_map<std::string, std::weak_ptr<vfsHDDBlockMap>> g_hdd_maps;
+
+void vfsHDDBlockMap::SetDirty(u64 word)
+{
+	m_dirty_begin = std::min(m_dirty_begin, word);
+	m_dirty_end = std::max(m_dirty_end, word + 1);
+}
+
+std::shared_ptr<vfsHDDBlockMap> vfsHDDBlockMap::Get(const std::string& path, const fs::file& f, vfsHDD_Hdr& hdr)
+{
+	std::lock_guard<std::mutex> lock(g_hdd_maps_mutex);
+
+	// the header may have been changed by another instance (upgraded)
+	if (f.seek(0) == -1 || f.read(&hdr, sizeof(vfsHDD_Hdr)) != sizeof(vfsHDD_Hdr) || hdr.magic != g_hdd_magic || hdr.block_size <= sizeof(vfsHDD_Entry) || !hdr.block_count)
+	{
+		LOG_ERROR(HLE, "Invalid HDD image '%s'", path);
+		return nullptr;
+	}
+
+	auto& weak_map = g_hdd_maps[path];
+
+	if (auto map = weak_map.lock())
+	{
+		return map;
+	}
+
+	// size of the image without the bitmap area (all blocks whose headers are scanned if the bitmap must be built)
+	u64 block_count = hdr.bitmap_block;
+
+	if (hdr.version == 0x0001)
+	{
+		LOG_NOTICE(HLE, "Upgrading HDD image '%s' (version 0x%x -> 0x%x)", path, hdr.version, g_hdd_version);
+
+		block_count = hdr.block_count;
+		Reserve(hdr);
+	}
+	else if (hdr.version != g_hdd_version || !hdr.bitmap_block || hdr.bitmap_block >= hdr.block_count)
+	{
+		LOG_ERROR(HLE, "Unsupported HDD image '%s' (version 0x%x)", path, hdr.version);
+		return nullptr;
+	}
+
+	auto map = std::make_shared<vfsHDDBlockMap>(hdr);
+
+	if (hdr.version != g_hdd_version || !map->Load(f))
+	{
+		if (hdr.version == g_hdd_version)
+		{
+			LOG_ERROR(HLE, "HDD image '%s': failed to read the allocation bitmap, rebuilding it", path);
+		}
+
+		// fill the bitmap using the block headers
+		map->Init();
+		map->Scan(f, block_count);
+
+		u8 null = 0;
+
+		CHECK_ASSERTION(f.seek(hdr.block_count * hdr.block_size - sizeof(null)) != -1);
+
+		f.write(null);
+		map->Flush(f);
+
+		if (hdr.version != g_hdd_version)
+		{
+			hdr.version = g_hdd_version;
+
+			CHECK_ASSERTION(f.seek(0) != -1);
+
+			f.write(&hdr, sizeof(vfsHDD_Hdr));
+		}
+	}
+
+	weak_map = map;
+	return map;
+}
+
+void vfsHDDBlockMap::Reserve(vfsHDD_Hdr& hdr)
+{
+	const u64 base = hdr.block_count;
+	const u64 bits_per_block = hdr.block_size * 8ull;
+
+	// the bitmap covers its own blocks as well
+	u64 count = 0;
+
+	while (true)
+	{
+		const u64 required = (base + count + bits_per_block - 1) / bits_per_block;
+
+		if (required == count)
+		{
+			break;
+		}
+
+		count = required;
+	}
+
+	hdr.bitmap_block = base;
+	hdr.block_count = base + count;
+}
+
+void vfsHDDBlockMap::Init()
+{
+	m_bits.assign((m_hdd_info.block_count + 63) / 64, 0);
+
+	// header block
+	m_bits[0] = 1;
+
+	for (u64 i = m_hdd_info.bitmap_block; i < m_hdd_info.block_count; i++)
+	{
+		m_bits[i / 64] |= 1ull << (i % 64);
+	}
+
+	m_dirty_begin = 0;
+	m_dirty_end = m_bits.size();
+	m_next = 0;
+}
+
+bool vfsHDDBlockMap::Load(const fs::file& f)
+{
+	m_bits.resize((m_hdd_info.block_count + 63) / 64);
+	m_dirty_begin = -1;
+	m_dirty_end = 0;
+	m_next = 0;
+
+	return f.seek(m_hdd_info.bitmap_block * m_hdd_info.block_size) != -1 && f.read(m_bits);
+}
+
+void vfsHDDBlockMap::Scan(const fs::file& f, u64 block_count)
+{
+	vfsHDD_Block block_info;
+
+	for (u64 i = 0; i < block_count; i++)
+	{
+		CHECK_ASSERTION(f.seek(i * m_hdd_info.block_size) != -1);
+
+		if (f.read(block_info) && block_info.is_used)
+		{
+			m_bits[i / 64] |= 1ull << (i % 64);
+			SetDirty(i / 64);
+		}
+	}
+}
+
+u64 vfsHDDBlockMap::Alloc(u64 hint)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	const u64 count = m_hdd_info.block_count;
+
+	if (!hint || hint >= count)
+	{
+		hint = m_next < count ? m_next : 0;
+	}
+
+	// find the first free block in [i, end) (block 0 is always used)
+	const auto find = [&](u64 i, u64 end) -> u64
+	{
+		while (i < end)
+		{
+			const u64 free = ~m_bits[i / 64] >> (i % 64);
+
+			if (!free)
+			{
+				i = (i / 64 + 1) * 64;
+				continue;
+			}
+
+			i += cnttz64(free);
+			return i < end ? i : 0;
+		}
+
+		return 0;
+	};
+
+	u64 block = find(hint, count);
+
+	if (!block)
+	{
+		block = find(0, hint);
+	}
+
+	if (block)
+	{
+		m_bits[block / 64] |= 1ull << (block % 64);
+		SetDirty(block / 64);
+		m_next = block + 1;
+	}
+
+	return block;
+}
+
+void vfsHDDBlockMap::Free(u64 block)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (!block || block >= m_hdd_info.block_count)
+	{
+		return;
+	}
+
+	m_bits[block / 64] &= ~(1ull << (block % 64));
+	SetDirty(block / 64);
+}
+
+void vfsHDDBlockMap::Flush(const fs::file& f)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (m_dirty_begin >= m_dirty_end)
+	{
+		return;
+	}
+
+	CHECK_ASSERTION(f.seek(m_hdd_info.bitmap_block * m_hdd_info.block_size + m_dirty_begin * sizeof(u64)) != -1);
+	CHECK_ASSERTION(f.write(m_bits.data() + m_dirty_begin, (m_dirty_end - m_dirty_begin) * sizeof(u64)) == (m_dirty_end - m_dirty_begin) * sizeof(u64));
+
+	m_dirty_begin = -1;
+	m_dirty_end = 0;
+}
+
 void vfsHDDManager::CreateBlock(vfsHDD_Block& block)
 {
 	block.is_used = true;
@@ -31,6 +253,7 @@ void vfsHDDManager::CreateHDD(const std::string& path, u64 size, u64 block_size)
 	hdr.version = g_hdd_version;
 	hdr.block_count = (size + block_size) / block_size;
 	hdr.block_size = block_size;
+	vfsHDDBlockMap::Reserve(hdr);
 	f.write(&hdr, sizeof(vfsHDD_Hdr));
 
 	{
@@ -45,6 +268,11 @@ void vfsHDDManager::CreateHDD(const std::string& path, u64 size, u64 block_size)
 		f.write(".", 1);
 	}
 
+	vfsHDDBlockMap map(hdr);
+	map.Init();
+	CHECK_ASSERTION(map.Alloc() == cur_dir_block);
+	map.Flush(f);
+
 	u8 null = 0;
 
 	CHECK_ASSERTION(f.seek(hdr.block_count * hdr.block_size - sizeof(null)) != -1);
@@ -60,300 +288,223 @@ void vfsHDDManager::AppendEntry(vfsHDD_Entry entry)
 {
 }
 
-bool vfsHDDFile::goto_block(u64 n)
+void vfsHDDFile::WriteBlock(u64 block, const vfsHDD_Block& data)
 {
-	vfsHDD_Block block_info;
+	CHECK_ASSERTION(m_hdd.Seek(block * m_hdd_info.block_size) != -1);
+	
+	m_hdd.Write(&data, sizeof(vfsHDD_Block));
+}
+
+void vfsHDDFile::ReadBlock(u64 block, vfsHDD_Block& data)
+{
+	CHECK_ASSERTION(m_hdd.Seek(block * m_hdd_info.block_size) != -1);
+	
+	m_hdd.Read(&data, sizeof(vfsHDD_Block));
+}
 
-	if (m_info.data_block >= m_hdd_info.block_count)
+void vfsHDDFile::CacheBlock(u64 index, bool load)
+{
+	if (m_cache_index == index)
 	{
-		return false;
+		return;
 	}
 
-	CHECK_ASSERTION(m_hdd.Seek(m_info.data_block * m_hdd_info.block_size) != -1);
-
-	block_info.next_block = m_info.data_block;
-
-	for (u64 i = 0; i < n; ++i)
+	if (m_cache_dirty)
 	{
-		if (!block_info.next_block || !block_info.is_used || block_info.next_block >= m_hdd_info.block_count)
-		{
-			return false;
-		}
-
-		CHECK_ASSERTION(m_hdd.Seek(block_info.next_block * m_hdd_info.block_size) != -1);
+		CHECK_ASSERTION(m_hdd.Seek(m_blocks[m_cache_index] * m_hdd_info.block_size) != -1);
 
-		m_hdd.Read(&block_info, sizeof(vfsHDD_Block));
+		m_hdd.Write(m_cache.data(), m_cache.size());
+		m_cache_dirty = false;
 	}
 
-	return true;
-}
-
-void vfsHDDFile::RemoveBlocks(u64 start_block)
-{
-	vfsHDD_Block block_info;
-	block_info.next_block = start_block;
+	m_cache.resize(m_hdd_info.block_size);
+	m_cache_index = index;
 
-	while (block_info.next_block && block_info.is_used)
+	if (load)
 	{
-		u64 offset = block_info.next_block * m_hdd_info.block_size;
+		CHECK_ASSERTION(m_hdd.Seek(m_blocks[index] * m_hdd_info.block_size) != -1);
 
-		ReadBlock(offset, block_info);
-		WriteBlock(offset, g_null_block);
+		m_hdd.Read(m_cache.data(), m_cache.size());
+		return;
 	}
-}
 
-void vfsHDDFile::WriteBlock(u64 block, const vfsHDD_Block& data)
-{
-	CHECK_ASSERTION(m_hdd.Seek(block * m_hdd_info.block_size) != -1);
-	
-	m_hdd.Write(&data, sizeof(vfsHDD_Block));
-}
+	vfsHDD_Block block_info = g_used_block;
+	block_info.next_block = index + 1 < m_blocks.size() ? m_blocks[index + 1] : 0;
 
-void vfsHDDFile::ReadBlock(u64 block, vfsHDD_Block& data)
-{
-	CHECK_ASSERTION(m_hdd.Seek(block * m_hdd_info.block_size) != -1);
-	
-	m_hdd.Read(&data, sizeof(vfsHDD_Block));
+	std::memcpy(m_cache.data(), &block_info, sizeof(vfsHDD_Block));
+	std::memset(m_cache.data() + sizeof(vfsHDD_Block), 0, GetDataSize());
+	m_cache_dirty = true;
 }
 
-void vfsHDDFile::WriteEntry(u64 block, const vfsHDD_Entry& data)
+bool vfsHDDFile::AppendBlock()
 {
-	CHECK_ASSERTION(m_hdd.Seek(block * m_hdd_info.block_size) != -1);
-	
-	m_hdd.Write(&data, sizeof(vfsHDD_Entry));
-}
+	if (!m_map)
+	{
+		return false;
+	}
 
-void vfsHDDFile::ReadEntry(u64 block, vfsHDD_Entry& data)
-{
-	CHECK_ASSERTION(m_hdd.Seek(block * m_hdd_info.block_size) != -1);
-	
-	m_hdd.Read(&data, sizeof(vfsHDD_Entry));
-}
+	// allocate blocks contiguously if possible, so the file is read and written sequentially
+	const u64 new_block = m_map->Alloc(m_blocks.empty() ? 0 : m_blocks.back() + 1);
 
-void vfsHDDFile::ReadEntry(u64 block, vfsHDD_Entry& data, std::string& name)
-{
-	CHECK_ASSERTION(m_hdd.Seek(block * m_hdd_info.block_size) != -1);
-	
-	m_hdd.Read(&data, sizeof(vfsHDD_Entry));
-	name.resize(GetMaxNameLen());
-	m_hdd.Read(&name.front(), GetMaxNameLen());
-}
+	if (!new_block)
+	{
+		return false;
+	}
 
-void vfsHDDFile::ReadEntry(u64 block, std::string& name)
-{
-	CHECK_ASSERTION(m_hdd.Seek(block * m_hdd_info.block_size + sizeof(vfsHDD_Entry)) != -1);
-	
-	name.resize(GetMaxNameLen());
-	m_hdd.Read(&name.front(), GetMaxNameLen());
-}
+	if (m_blocks.empty())
+	{
+		m_info.data_block = new_block;
+		m_info_dirty = true;
+	}
+	else if (m_cache_index == m_blocks.size() - 1)
+	{
+		// link the last block (cached)
+		reinterpret_cast<vfsHDD_Block*>(m_cache.data())->next_block = new_block;
+		m_cache_dirty = true;
+	}
+	else
+	{
+		vfsHDD_Block block_info = g_used_block;
+		block_info.next_block = new_block;
+		WriteBlock(m_blocks.back(), block_info);
+	}
 
-void vfsHDDFile::WriteEntry(u64 block, const vfsHDD_Entry& data, const std::string& name)
-{
-	CHECK_ASSERTION(m_hdd.Seek(block * m_hdd_info.block_size) != -1);
-	
-	m_hdd.Write(&data, sizeof(vfsHDD_Entry));
-	m_hdd.Write(name.c_str(), std::min<size_t>(GetMaxNameLen() - 1, name.length() + 1));
+	m_blocks.push_back(new_block);
+	CacheBlock(m_blocks.size() - 1, false);
+	return true;
 }
 
 void vfsHDDFile::Open(u64 info_block)
 {
+	Flush();
+
 	m_info_block = info_block;
-	ReadEntry(m_info_block, m_info);
-	m_position = 0;
-	m_cur_block = m_info.data_block;
-}
 
-u64 vfsHDDFile::FindFreeBlock()
-{
-	vfsHDD_Block block_info;
+	CHECK_ASSERTION(m_hdd.Seek(m_info_block * m_hdd_info.block_size) != -1);
 
-	for (u64 i = 0; i < m_hdd_info.block_count; ++i)
-	{
-		ReadBlock(i, block_info);
+	m_hdd.Read(&m_info, sizeof(vfsHDD_Entry));
+	m_pos = 0;
+	m_cache_index = -1;
+	m_blocks.clear();
 
-		if (!block_info.is_used)
-		{
-			return i;
-		}
-	}
+	// build the block index
+	vfsHDD_Block block_info = g_used_block;
+	block_info.next_block = m_info.data_block;
 
-	return 0;
+	while (block_info.is_used && block_info.next_block && block_info.next_block < m_hdd_info.block_count && m_blocks.size() < m_hdd_info.block_count)
+	{
+		m_blocks.push_back(block_info.next_block);
+		ReadBlock(block_info.next_block, block_info);
+	}
 }
 
 bool vfsHDDFile::Seek(u64 pos)
 {
-	if (!goto_block(pos / m_hdd_info.block_size))
+	if (pos > m_info.size)
 	{
 		return false;
 	}
 
-	m_position = pos % m_hdd_info.block_size;
+	m_pos = pos;
 	return true;
 }
 
 void vfsHDDFile::SaveInfo()
 {
-	CHECK_ASSERTION(m_hdd.Seek(m_info_block * m_hdd_info.block_size) != -1);
+	// the block header (link to the next directory entry) may have been changed by another instance since Open
+	CHECK_ASSERTION(m_hdd.Seek(m_info_block * m_hdd_info.block_size + sizeof(vfsHDD_Block)) != -1);
 
-	CHECK_ASSERTION(m_hdd.Seek(m_info_block * m_hdd_info.block_size) != -1);
+	m_hdd.Write(reinterpret_cast<const u8*>(&m_info) + sizeof(vfsHDD_Block), sizeof(vfsHDD_Entry) - sizeof(vfsHDD_Block));
+	m_info_dirty = false;
+}
+
+void vfsHDDFile::Flush()
+{
+	if (m_cache_dirty)
+	{
+		CHECK_ASSERTION(m_hdd.Seek(m_blocks[m_cache_index] * m_hdd_info.block_size) != -1);
 
-	m_hdd.Write(&m_info, sizeof(vfsHDD_Entry));
+		m_hdd.Write(m_cache.data(), m_cache.size());
+		m_cache_dirty = false;
+	}
+
+	if (m_info_dirty)
+	{
+		SaveInfo();
+	}
 }
 
 u64 vfsHDDFile::Read(void* dst, u64 size)
 {
-	if (!size)
+	if (m_pos >= m_info.size)
+	{
 		return 0;
+	}
 
-	//vfsDeviceLocker lock(m_hdd);
+	size = std::min<u64>(size, m_info.size - m_pos);
 
-	const u32 block_size = m_hdd_info.block_size - sizeof(vfsHDD_Block);
-	u64 rsize = std::min<u64>(block_size - m_position, size);
+	const u32 data_size = GetDataSize();
 
-	vfsHDD_Block cur_block_info;
-	
-	CHECK_ASSERTION(m_hdd.Seek(m_cur_block * m_hdd_info.block_size) != -1);
+	u64 offset = 0;
 
-	m_hdd.Read(&cur_block_info, sizeof(vfsHDD_Block));
-	
-	CHECK_ASSERTION(m_hdd.Seek(m_cur_block * m_hdd_info.block_size + sizeof(vfsHDD_Block) + m_position) != -1);
-
-	m_hdd.Read(dst, rsize);
-	size -= rsize;
-	m_position += rsize;
-	if (!size)
+	while (offset < size)
 	{
-		return rsize;
-	}
+		const u64 index = m_pos / data_size;
+		const u32 pos = m_pos % data_size;
+		const u64 rsize = std::min<u64>(data_size - pos, size - offset);
 
-	u64 offset = rsize;
-
-	for (; size; size -= rsize, offset += rsize)
-	{
-		if (!cur_block_info.is_used || !cur_block_info.next_block || cur_block_info.next_block >= m_hdd_info.block_count)
+		if (index >= m_blocks.size())
 		{
-			return offset;
+			break;
 		}
 
-		m_cur_block = cur_block_info.next_block;
-		rsize = std::min<u64>(block_size, size);
+		CacheBlock(index, true);
 
-		CHECK_ASSERTION(m_hdd.Seek(cur_block_info.next_block * m_hdd_info.block_size) != -1);
-
-		m_hdd.Read(&cur_block_info, sizeof(vfsHDD_Block));
-
-		if (m_hdd.Read((u8*)dst + offset, rsize) != rsize)
-		{
-			return offset;
-		}
+		std::memcpy((u8*)dst + offset, m_cache.data() + sizeof(vfsHDD_Block) + pos, rsize);
+		offset += rsize;
+		m_pos += rsize;
 	}
 
-	m_position = rsize;
-
 	return offset;
 }
 
 u64 vfsHDDFile::Write(const void* src, u64 size)
 {
-	if (!size)
-		return 0;
-
-	//vfsDeviceLocker lock(m_hdd);
+	const u32 data_size = GetDataSize();
 
-	const u32 block_size = m_hdd_info.block_size - sizeof(vfsHDD_Block);
+	u64 offset = 0;
 
-	if (!m_cur_block)
+	while (offset < size)
 	{
-		if (!m_info.data_block)
-		{
-			u64 new_block = FindFreeBlock();
+		const u64 index = m_pos / data_size;
+		const u32 pos = m_pos % data_size;
+		const u64 wsize = std::min<u64>(data_size - pos, size - offset);
 
-			if (!new_block)
+		if (index >= m_blocks.size())
+		{
+			if (!AppendBlock())
 			{
-				return 0;
+				break;
 			}
-
-			WriteBlock(new_block, g_used_block);
-			m_info.data_block = new_block;
-			m_info.size = 0;
-			SaveInfo();
 		}
-
-		m_cur_block = m_info.data_block;
-		m_position = 0;
-	}
-
-	u64 wsize = std::min<u64>(block_size - m_position, size);
-
-	vfsHDD_Block block_info;
-	ReadBlock(m_cur_block, block_info);
-
-	if (wsize)
-	{
-		CHECK_ASSERTION(m_hdd.Seek(m_cur_block * m_hdd_info.block_size + sizeof(vfsHDD_Block) + m_position) != -1);
-
-		m_hdd.Write(src, wsize);
-		size -= wsize;
-		m_info.size += wsize;
-		m_position += wsize;
-		SaveInfo();
-
-		if (!size)
-			return wsize;
-	}
-
-	u64 last_block = m_cur_block;
-	block_info.is_used = true;
-	u64 offset = wsize;
-
-	for (; size; size -= wsize, offset += wsize, m_info.size += wsize)
-	{
-		u64 new_block = FindFreeBlock();
-
-		if (!new_block)
+		else
 		{
-			m_position = 0;
-			SaveInfo();
-			return offset;
+			// the block is not read if it's completely overwritten
+			CacheBlock(index, pos || wsize < data_size);
 		}
 
-		m_cur_block = new_block;
-		wsize = std::min<u64>(block_size, size);
+		std::memcpy(m_cache.data() + sizeof(vfsHDD_Block) + pos, (const u8*)src + offset, wsize);
+		m_cache_dirty = true;
+		offset += wsize;
+		m_pos += wsize;
 
-		block_info.next_block = m_cur_block;
-		
-		CHECK_ASSERTION(m_hdd.Seek(last_block * m_hdd_info.block_size) != -1);
-
-		if (m_hdd.Write(&block_info, sizeof(vfsHDD_Block)) != sizeof(vfsHDD_Block))
-		{
-			m_position = 0;
-			SaveInfo();
-			return offset;
-		}
-
-		block_info.next_block = 0;
-
-		CHECK_ASSERTION(m_hdd.Seek(m_cur_block * m_hdd_info.block_size) != -1);
-
-		if (m_hdd.Write(&block_info, sizeof(vfsHDD_Block)) != sizeof(vfsHDD_Block))
-		{
-			m_position = 0;
-			SaveInfo();
-			return offset;
-		}
-
-		if ((m_position = m_hdd.Write((u8*)src + offset, wsize)) != wsize)
+		if (m_pos > m_info.size)
 		{
-			m_info.size += wsize;
-			SaveInfo();
-			return offset;
+			m_info.size = m_pos;
+			m_info_dirty = true;
 		}
-
-		last_block = m_cur_block;
 	}
 
-	SaveInfo();
-	m_position = wsize;
 	return offset;
 }
 
@@ -373,24 +524,39 @@ vfsDirBase* vfsDeviceHDD::GetNewDirStream()
 
 vfsHDD::vfsHDD(vfsDevice* device, const std::string& hdd_path)
 	: m_hdd_file(device)
-	, m_file(m_hdd_file, m_hdd_info)
+	, m_file(m_hdd_file, m_hdd_info, m_map)
 	, m_hdd_path(hdd_path)
 	, vfsFileBase(device)
 {
 	m_hdd_file.Open(hdd_path, fom::read | fom::write);
-	m_hdd_file.Read(&m_hdd_info, sizeof(vfsHDD_Hdr));
-	m_cur_dir_block = m_hdd_info.next_block;
-	if (!m_hdd_info.block_size)
+
+	// the image is refused: no entries are found and nothing can be allocated
+	if (!(m_map = vfsHDDBlockMap::Get(hdd_path, m_hdd_file.GetFile(), m_hdd_info)))
 	{
-		LOG_ERROR(HLE, "Bad block size!");
-		m_hdd_info.block_size = 2048;
+		return;
 	}
 
+	m_cur_dir_block = m_hdd_info.next_block;
+
 	CHECK_ASSERTION(m_hdd_file.Seek(m_cur_dir_block * m_hdd_info.block_size) != -1);
 	
 	m_hdd_file.Read(&m_cur_dir, sizeof(vfsHDD_Entry));
 }
 
+vfsHDD::~vfsHDD()
+{
+	Flush();
+}
+
+void vfsHDD::Flush()
+{
+	if (m_map)
+	{
+		m_file.Flush();
+		m_map->Flush(m_hdd_file.GetFile());
+	}
+}
+
 bool vfsHDD::SearchEntry(const std::string& name, u64& entry_block, u64* parent_block)
 {
 	u64 last_block = 0;
@@ -461,19 +627,7 @@ bool vfsHDD::Rename(const std::string& from, const std::string& to)
 
 u64 vfsHDD::FindFreeBlock()
 {
-	vfsHDD_Block block_info;
-
-	for (u64 i = 0; i < m_hdd_info.block_count; ++i)
-	{
-		ReadBlock(i, block_info);
-
-		if (!block_info.is_used)
-		{
-			return i;
-		}
-	}
-
-	return 0;
+	return m_map ? m_map->Alloc() : 0;
 }
 
 void vfsHDD::WriteBlock(u64 block, const vfsHDD_Block& data)
@@ -610,6 +764,7 @@ bool vfsHDD::Create(vfsHDD_EntryType type, const std::string& name)
 		WriteBlock(block, tmp);
 	}
 
+	m_map->Flush(m_hdd_file.GetFile());
 	return true;
 }
 
@@ -697,6 +852,12 @@ bool vfsHDD::Open(const std::string& path, u32 mode)
 	return vfsFileBase::Open(path, mode);
 }
 
+void vfsHDD::Close()
+{
+	Flush();
+	vfsFileBase::Close();
+}
+
 bool vfsHDD::HasEntry(const std::string& name)
 {
 	u64 file_block;
@@ -718,6 +879,7 @@ void vfsHDD::RemoveBlocksDir(u64 start_block)
 	{
 		ReadEntry(block, entry, name);
 		WriteBlock(block, g_null_block);
+		m_map->Free(block);
 
 		if (entry.type == vfsHDD_Entry_Dir && name != "." && name != "..")
 		{
@@ -742,6 +904,7 @@ void vfsHDD::RemoveBlocksFile(u64 start_block)
 	{
 		ReadBlock(block, block_data);
 		WriteBlock(block, g_null_block);
+		m_map->Free(block);
 
 		block = block_data.next_block;
 	}
@@ -774,6 +937,8 @@ bool vfsHDD::RemoveEntry(const std::string& name)
 		WriteEntry(parent_entry, entry);
 	}
 	WriteBlock(entry_block, g_null_block);
+	m_map->Free(entry_block);
+	m_map->Flush(m_hdd_file.GetFile());
 	return true;
 }
 
@@ -3,7 +3,7 @@
 #include "Emu/FS/vfsLocalFile.h"
 
 static const u64 g_hdd_magic = *(u64*)"PS3eHDD\0";
-static const u16 g_hdd_version = 0x0001;
+static const u16 g_hdd_version = 0x0002; // version 1 images are upgraded on open
 
 struct vfsHDD_Block
 {
@@ -20,6 +20,7 @@ struct vfsHDD_Hdr : public vfsHDD_Block
 	u16 version;
 	u64 block_count;
 	u32 block_size;
+	u64 bitmap_block; // first block of the allocation bitmap (version 2)
 };
 
 enum vfsHDD_EntryType : u8
@@ -40,6 +41,56 @@ struct vfsHDD_Entry : public vfsHDD_Block
 	u64 atime;
 };
 
+// Allocation bitmap (one bit per block, kept in memory and written back on Flush)
+// It's shared by all vfsHDD instances opened on the same image, so they don't allocate the same blocks.
+class vfsHDDBlockMap
+{
+	const vfsHDD_Hdr m_hdd_info;
+	mutable std::mutex m_mutex;
+	std::vector<u64> m_bits;
+	u64 m_dirty_begin = -1; // first modified word
+	u64 m_dirty_end = 0;
+	u64 m_next = 0; // allocation hint used when the caller has no preference
+
+	void SetDirty(u64 word);
+
+public:
+	vfsHDDBlockMap(const vfsHDD_Hdr& hdd_info)
+		: m_hdd_info(hdd_info)
+	{
+	}
+
+	// Get the bitmap of the image (loaded on first use, version 1 images are upgraded).
+	// The header is read again and returned in hdr. Returns nullptr if the image is not supported.
+	static std::shared_ptr<vfsHDDBlockMap> Get(const std::string& path, const fs::file& f, vfsHDD_Hdr& hdr);
+
+	// Append the bitmap area to the image (sets bitmap_block and increases block_count)
+	static void Reserve(vfsHDD_Hdr& hdr);
+
+	// Mark all blocks as free except the header and the bitmap area
+	void Init();
+
+	// Read the bitmap from the image
+	bool Load(const fs::file& f);
+
+	// Mark blocks in use according to their headers (used to upgrade version 1 images)
+	void Scan(const fs::file& f, u64 block_count);
+
+	bool IsUsed(u64 block) const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		return (m_bits[block / 64] >> (block % 64)) & 1;
+	}
+
+	// Allocate a free block, preferring the first one at or after hint (returns 0 if the image is full)
+	u64 Alloc(u64 hint = 0);
+
+	void Free(u64 block);
+
+	void Flush(const fs::file& f);
+};
+
 class vfsHDDManager
 {
 public:
@@ -57,40 +108,42 @@ public:
 
 class vfsHDDFile
 {
-	u64 m_info_block;
-	vfsHDD_Entry m_info;
+	u64 m_info_block = 0;
+	vfsHDD_Entry m_info{};
 	const vfsHDD_Hdr& m_hdd_info;
 	vfsLocalFile& m_hdd;
-	u32 m_position;
-	u64 m_cur_block;
+	const std::shared_ptr<vfsHDDBlockMap>& m_map;
+	u64 m_pos = 0;
 
-	bool goto_block(u64 n);
+	// Data blocks of the file in order (the chain is walked once on Open)
+	std::vector<u64> m_blocks;
 
-	void RemoveBlocks(u64 start_block);
+	// Write-back cache of a single block (with its header)
+	std::vector<u8> m_cache;
+	u64 m_cache_index = -1; // index in m_blocks
+	bool m_cache_dirty = false;
+	bool m_info_dirty = false;
 
 	void WriteBlock(u64 block, const vfsHDD_Block& data);
 
 	void ReadBlock(u64 block, vfsHDD_Block& data);
 
-	void WriteEntry(u64 block, const vfsHDD_Entry& data);
-
-	void ReadEntry(u64 block, vfsHDD_Entry& data);
-
-	void ReadEntry(u64 block, vfsHDD_Entry& data, std::string& name);
-
-	void ReadEntry(u64 block, std::string& name);
+	// Load the block into the cache (if load is false, it's initialized with an empty data area instead of being read)
+	void CacheBlock(u64 index, bool load);
 
-	void WriteEntry(u64 block, const vfsHDD_Entry& data, const std::string& name);
+	// Allocate a new block at the end of the file and cache it
+	bool AppendBlock();
 
-	force_inline u32 GetMaxNameLen() const
+	force_inline u32 GetDataSize() const
 	{
-		return m_hdd_info.block_size - sizeof(vfsHDD_Entry);
+		return m_hdd_info.block_size - sizeof(vfsHDD_Block);
 	}
 
 public:
-	vfsHDDFile(vfsLocalFile& hdd, const vfsHDD_Hdr& hdd_info)
+	vfsHDDFile(vfsLocalFile& hdd, const vfsHDD_Hdr& hdd_info, const std::shared_ptr<vfsHDDBlockMap>& map)
 		: m_hdd(hdd)
 		, m_hdd_info(hdd_info)
+		, m_map(map)
 	{
 	}
 
@@ -100,8 +153,6 @@ public:
 
 	void Open(u64 info_block);
 
-	u64 FindFreeBlock();
-
 	u64 GetSize() const
 	{
 		return m_info.size;
@@ -111,18 +162,21 @@ public:
 
 	u64 Tell() const
 	{
-		return m_cur_block * m_hdd_info.block_size + m_position; // ???
+		return m_pos;
 	}
 
 	void SaveInfo();
 
+	// Write back the cached block and the file entry
+	void Flush();
+
 	u64 Read(void* dst, u64 size);
 
 	u64 Write(const void* src, u64 size);
 
 	bool Eof() const
 	{
-		return m_info.size <= (m_cur_block * m_hdd_info.block_size + m_position);
+		return m_info.size <= m_pos;
 	}
 };
 
@@ -142,13 +196,18 @@ class vfsHDD : public vfsFileBase
 	vfsHDD_Hdr m_hdd_info;
 	vfsLocalFile m_hdd_file;
 	const std::string& m_hdd_path;
-	vfsHDD_Entry m_cur_dir;
-	u64 m_cur_dir_block;
+	vfsHDD_Entry m_cur_dir{};
+	u64 m_cur_dir_block = 0;
+	std::shared_ptr<vfsHDDBlockMap> m_map; // null if the image is not supported
 	vfsHDDFile m_file;
 
+	void Flush();
+
 public:
 	vfsHDD(vfsDevice* device, const std::string& hdd_path);
 
+	virtual ~vfsHDD() override;
+
 	force_inline u32 GetMaxNameLen() const
 	{
 		return m_hdd_info.block_size - sizeof(vfsHDD_Entry);
@@ -184,6 +243,8 @@ public:
 
 	virtual bool Open(const std::string& path, u32 mode = fom::read) override;
 
+	virtual void Close() override;
+
 	bool HasEntry(const std::string& name);
 
 	void RemoveBlocksDir(u64 start_block);
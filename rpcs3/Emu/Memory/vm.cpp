@@ -22,6 +22,10 @@
 #endif
 #endif
 
+extern void ppu_discard_code(u32 addr, u32 size);
+extern void spu_discard_code(u32 addr, u32 size);
+extern void rsx_discard_code(u32 addr, u32 size);
+
 namespace vm
 {
 	template<std::size_t Size> struct mapped_ptr_deleter
@@ -157,6 +161,9 @@ namespace vm
 
 	reservation_mutex_t g_reservation_mutex;
 
+	// Discard decoded code and restore write access (the reservation lock must be held)
+	static bool _invalidate_code(u32 addr);
+
 	std::array<waiter_t, 1024> g_waiter_list;
 
 	std::size_t g_waiter_max = 0; // min unused position
@@ -429,6 +436,9 @@ namespace vm
 			throw EXCEPTION("Invalid arguments (addr=0x%x, size=0x%x)", addr, size);
 		}
 
+		// restore write access if the page contains decoded code
+		_invalidate_code(addr);
+
 		const u8 flags = g_pages[addr >> 12];
 
 		if (!(flags & page_writable) || !(flags & page_allocated) || (flags & page_no_reservations))
@@ -539,6 +549,13 @@ namespace vm
 		}
 	}
 
+	void map_op(std::function<void()> proc)
+	{
+		std::lock_guard<reservation_mutex_t> lock(g_reservation_mutex);
+
+		proc();
+	}
+
 	void reservation_op(u32 addr, u32 size, std::function<void()> proc)
 	{
 		std::unique_lock<reservation_mutex_t> lock(g_reservation_mutex);
@@ -550,6 +567,9 @@ namespace vm
 			throw EXCEPTION("Invalid arguments (addr=0x%x, size=0x%x)", addr, size);
 		}
 
+		// restore write access if the page contains decoded code
+		_invalidate_code(addr);
+
 		g_tls_did_break_reservation = false;
 
 		// check and possibly break previous reservation
@@ -624,10 +644,8 @@ namespace vm
 		std::memset(priv_addr, 0, size); // ???
 	}
 
-	bool page_protect(u32 addr, u32 size, u8 flags_test, u8 flags_set, u8 flags_clear)
+	static bool _page_protect(u32 addr, u32 size, u8 flags_test, u8 flags_set, u8 flags_clear)
 	{
-		std::lock_guard<reservation_mutex_t> lock(g_reservation_mutex);
-
 		if (!size || (size | addr) % 4096)
 		{
 			throw EXCEPTION("Invalid arguments (addr=0x%x, size=0x%x)", addr, size);
@@ -680,6 +698,37 @@ namespace vm
 		return true;
 	}
 
+	bool page_protect(u32 addr, u32 size, u8 flags_test, u8 flags_set, u8 flags_clear)
+	{
+		std::lock_guard<reservation_mutex_t> lock(g_reservation_mutex);
+
+		return _page_protect(addr, size, flags_test, flags_set, flags_clear);
+	}
+
+	static bool _invalidate_code(u32 addr)
+	{
+		const u32 page = addr & ~0xfff;
+
+		if (!(g_pages[page / 4096] & page_executable))
+		{
+			return false;
+		}
+
+		// discard decoded code before the page becomes writable
+		ppu_discard_code(page, 4096);
+		spu_discard_code(page, 4096);
+		rsx_discard_code(page, 4096);
+
+		return _page_protect(page, 4096, page_executable, page_writable, page_executable);
+	}
+
+	bool invalidate_code(u32 addr)
+	{
+		std::lock_guard<reservation_mutex_t> lock(g_reservation_mutex);
+
+		return _invalidate_code(addr);
+	}
+
 	void _page_unmap(u32 addr, u32 size)
 	{
 		if (!size || (size | addr) % 4096)
@@ -695,6 +744,11 @@ namespace vm
 			}
 		}
 
+		// discard code decoded from this memory, it may be allocated again
+		ppu_discard_code(addr, size);
+		spu_discard_code(addr, size);
+		rsx_discard_code(addr, size);
+
 		for (u32 i = addr / 4096; i < addr / 4096 + size / 4096; i++)
 		{
 			_reservation_break(i * 4096);
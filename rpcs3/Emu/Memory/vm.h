@@ -127,9 +127,15 @@ namespace vm
 	// Perform atomic operation unconditionally
 	void reservation_op(u32 addr, u32 size, std::function<void()> proc);
 
+	// Run the function while memory can't be mapped or unmapped (it must not call functions which take the reservation lock)
+	void map_op(std::function<void()> proc);
+
 	// Change memory protection of specified memory region
 	bool page_protect(u32 addr, u32 size, u8 flags_test = 0, u8 flags_set = 0, u8 flags_clear = 0);
 
+	// Discard code decoded from the page containing addr and restore write access (returns false if the page is not page_executable)
+	bool invalidate_code(u32 addr);
+
 	// Check if existing memory range is allocated. Checking address before using it is very unsafe.
 	// Return value may be wrong. Even if it's true and correct, actual memory protection may be read-only and no-access.
 	bool check_addr(u32 addr, u32 size = 1);
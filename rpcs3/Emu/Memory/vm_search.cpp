@@ -0,0 +1,434 @@
+#include "stdafx.h"
+#include "vm_search.h"
+
+namespace vm
+{
+	search_pattern search_pattern::from_string(const std::string& str)
+	{
+		search_pattern result;
+		result.bytes.assign(str.begin(), str.end());
+		result.mask.assign(str.size(), 0xff);
+		return result;
+	}
+
+	search_pattern search_pattern::from_hex(const std::string& str)
+	{
+		search_pattern result;
+
+		for (const auto& token : fmt::split(str, { " ", "\t" }))
+		{
+			if (token == "?" || token == "??")
+			{
+				result.bytes.push_back(0);
+				result.mask.push_back(0);
+				continue;
+			}
+
+			char* end;
+			const unsigned long value = std::strtoul(token.c_str(), &end, 16);
+
+			if (token.size() > 2 || *end)
+			{
+				return{};
+			}
+
+			result.bytes.push_back(static_cast<u8>(value));
+			result.mask.push_back(0xff);
+		}
+
+		return result;
+	}
+
+	static std::shared_ptr<block_t> get_block(memory_location_t location)
+	{
+		const auto block = vm::get(location);
+
+		if (!block)
+		{
+			throw EXCEPTION("Invalid memory location (%d)", location);
+		}
+
+		return block;
+	}
+
+	// Get ranges of contiguous allocated pages (address, size). Pages may be unmapped after it returns,
+	// so they must be checked again under vm::map_op() before they're read.
+	static std::vector<std::pair<u32, u32>> get_allocated_ranges(const std::shared_ptr<block_t>& block)
+	{
+		std::vector<std::pair<u32, u32>> result;
+
+		for (u32 page = block->addr; page - block->addr < block->size; page += 4096)
+		{
+			if (!check_addr(page, 4096))
+			{
+				continue;
+			}
+
+			if (!result.empty() && result.back().first + result.back().second == page)
+			{
+				result.back().second += 4096;
+			}
+			else
+			{
+				result.emplace_back(page, 4096);
+			}
+		}
+
+		return result;
+	}
+
+	std::vector<search_result> search(memory_location_t location, const std::vector<search_pattern>& patterns, std::size_t max_results)
+	{
+		// Every pattern is located by its first non-wildcard byte ("anchor")
+		struct anchor_t
+		{
+			u32 pattern;
+			u32 offset;
+			__m128i value;
+		};
+
+		std::vector<anchor_t> anchors;
+
+		for (u32 i = 0; i < patterns.size(); i++)
+		{
+			const auto& pattern = patterns[i];
+
+			if (pattern.mask.size() != pattern.bytes.size() || !pattern.align)
+			{
+				throw EXCEPTION("Invalid pattern (%d)", i);
+			}
+
+			const auto found = std::find(pattern.mask.begin(), pattern.mask.end(), 0xff);
+
+			if (found == pattern.mask.end())
+			{
+				LOG_ERROR(MEMORY, "vm::search(): pattern %d ignored (no bytes to match)", i);
+				continue;
+			}
+
+			const u32 offset = static_cast<u32>(found - pattern.mask.begin());
+
+			anchors.push_back({ i, offset, _mm_set1_epi8(pattern.bytes[offset]) });
+		}
+
+		// Split allocated memory into chunks processed by worker threads (matches may cross the chunk end)
+		struct chunk_t
+		{
+			u32 addr;
+			u32 size;
+			u32 range_end;
+		};
+
+		const auto block = get_block(location);
+
+		std::vector<chunk_t> chunks;
+
+		for (const auto& range : get_allocated_ranges(block))
+		{
+			const u32 chunk_size = 256 * 1024;
+
+			for (u32 offset = 0; offset < range.second; offset += chunk_size)
+			{
+				chunks.push_back({ range.first + offset, std::min(chunk_size, range.second - offset), range.first + range.second });
+			}
+		}
+
+		u32 max_size = 0;
+
+		for (const auto& pattern : patterns)
+		{
+			max_size = std::max<u32>(max_size, static_cast<u32>(pattern.bytes.size()));
+		}
+
+		// Bytes after the chunk end read by the scan (anchor loads and matches crossing the chunk end)
+		const u32 tail_size = max_size + 16;
+
+		// Copy the chunk (and the bytes after it) under the lock, so pages can't be unmapped while they're read.
+		// The lock is only held for the copy, pages unmapped since the chunks were made are not copied.
+		const auto copy_chunk = [&](const chunk_t& chunk, std::vector<u8>& buffer) -> u32
+		{
+			const u32 limit = chunk.addr + std::min(chunk.size + tail_size, chunk.range_end - chunk.addr);
+
+			buffer.resize(chunk.size + tail_size);
+
+			u32 end = chunk.addr;
+
+			map_op([&]()
+			{
+				while (end < limit && check_addr(end & ~0xfff, 4096))
+				{
+					end = std::min((end & ~0xfff) + 4096, limit);
+				}
+
+				std::memcpy(buffer.data(), base_priv(chunk.addr), end - chunk.addr);
+			});
+
+			return end;
+		};
+
+		const auto scan_chunk = [&](const chunk_t& chunk, std::vector<search_result>& results, std::vector<u8>& buffer)
+		{
+			// End of the copied data (pages after it were unmapped or are outside of the range)
+			const u32 range_end = copy_chunk(chunk, buffer);
+			const u32 end = std::min(chunk.addr + chunk.size, range_end);
+			const u8* const memory = buffer.data() - chunk.addr;
+
+			for (u32 pos = chunk.addr; pos < end && results.size() < max_results; pos += 16)
+			{
+				// Find candidates for 16 addresses starting from pos
+				u32 bits = 0;
+
+				for (const auto& anchor : anchors)
+				{
+					const u32 addr = pos + anchor.offset;
+
+					if (addr + 16 <= range_end)
+					{
+						const __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(memory + addr));
+						bits |= _mm_movemask_epi8(_mm_cmpeq_epi8(data, anchor.value));
+						continue;
+					}
+
+					for (u32 i = 0; i < 16 && addr + i < range_end; i++)
+					{
+						bits |= (memory[addr + i] == patterns[anchor.pattern].bytes[anchor.offset]) << i;
+					}
+				}
+
+				if (end - pos < 16)
+				{
+					bits &= (1u << (end - pos)) - 1;
+				}
+
+				// Check candidates (in pattern order, so the results of the chunk are sorted)
+				for (; bits && results.size() < max_results; bits &= bits - 1)
+				{
+					const u32 addr = pos + cnttz32(bits);
+
+					for (const auto& anchor : anchors)
+					{
+						const auto& pattern = patterns[anchor.pattern];
+
+						if (addr % pattern.align || pattern.bytes.size() > range_end - addr)
+						{
+							continue;
+						}
+
+						bool match = true;
+
+						for (u32 i = 0; i < pattern.bytes.size(); i++)
+						{
+							if ((memory[addr + i] ^ pattern.bytes[i]) & pattern.mask[i])
+							{
+								match = false;
+								break;
+							}
+						}
+
+						if (match)
+						{
+							results.push_back({ addr, anchor.pattern });
+						}
+					}
+				}
+			}
+		};
+
+		// Results of each chunk, merged in address order
+		std::vector<std::vector<search_result>> chunk_results(chunks.size());
+
+		// Chunks are taken in address order. Once the finished chunks before the first unfinished one
+		// have max_results matches, the remaining chunks can't contribute to the result.
+		std::atomic<u32> next{ 0 };
+		std::mutex done_mutex;
+		std::vector<bool> done(chunks.size());
+		u32 done_count = 0;
+		std::size_t done_results = 0;
+		std::atomic<bool> enough{ max_results == 0 };
+
+		const auto worker = [&]()
+		{
+			std::vector<u8> buffer;
+
+			for (u32 i; !enough && (i = next++) < chunks.size();)
+			{
+				scan_chunk(chunks[i], chunk_results[i], buffer);
+
+				std::lock_guard<std::mutex> lock(done_mutex);
+
+				for (done[i] = true; done_count < chunks.size() && done[done_count]; done_count++)
+				{
+					done_results += chunk_results[done_count].size();
+				}
+
+				if (done_results >= max_results)
+				{
+					enough = true;
+				}
+			}
+		};
+
+		const u32 threads = std::max<u32>(1, std::min<u32>(std::thread::hardware_concurrency(), static_cast<u32>(chunks.size())));
+
+		std::vector<std::future<void>> tasks;
+
+		for (u32 i = 1; i < threads; i++)
+		{
+			tasks.emplace_back(std::async(std::launch::async, worker));
+		}
+
+		worker();
+
+		for (auto& task : tasks)
+		{
+			task.get();
+		}
+
+		std::vector<search_result> result;
+
+		for (const auto& results : chunk_results)
+		{
+			if (result.size() >= max_results)
+			{
+				break;
+			}
+
+			result.insert(result.end(), results.begin(), results.begin() + std::min(results.size(), max_results - result.size()));
+		}
+
+		return result;
+	}
+
+	memory_snapshot::memory_snapshot(memory_location_t location)
+	{
+		const auto block = get_block(location);
+
+		m_addr = block->addr;
+		m_data.resize(block->size);
+		m_pages.resize(block->size / 4096);
+
+		// Pages are copied while they can't be unmapped (the lock is taken for each group of pages)
+		for (u32 group = 0; group < m_pages.size(); group += 256)
+		{
+			map_op([&]()
+			{
+				for (u32 page = group; page < m_pages.size() && page < group + 256; page++)
+				{
+					if (check_addr(m_addr + page * 4096, 4096))
+					{
+						std::memcpy(m_data.data() + page * 4096, base_priv(m_addr + page * 4096), 4096);
+						m_pages[page] = true;
+					}
+				}
+			});
+		}
+	}
+
+	std::vector<u32> memory_snapshot::diff(u32 size, compare cmp, bool big_endian, const std::vector<u32>* filter) const
+	{
+		if (size != 1 && size != 2 && size != 4 && size != 8)
+		{
+			throw EXCEPTION("Invalid size (%d)", size);
+		}
+
+		const auto load = [&](const u8* ptr) -> u64
+		{
+			switch (size)
+			{
+			case 1: return *ptr;
+			case 2: { u16 value; std::memcpy(&value, ptr, 2); return big_endian ? se_storage<u16>::swap(value) : value; }
+			case 4: { u32 value; std::memcpy(&value, ptr, 4); return big_endian ? se_storage<u32>::swap(value) : value; }
+			default: { u64 value; std::memcpy(&value, ptr, 8); return big_endian ? se_storage<u64>::swap(value) : value; }
+			}
+		};
+
+		const auto test = [&](u32 addr) -> bool
+		{
+			const u64 old_value = load(m_data.data() + (addr - m_addr));
+			const u64 new_value = load(static_cast<const u8*>(base_priv(addr)));
+
+			switch (cmp)
+			{
+			case compare::changed: return new_value != old_value;
+			case compare::unchanged: return new_value == old_value;
+			case compare::increased: return new_value > old_value;
+			case compare::decreased: return new_value < old_value;
+			}
+
+			return false;
+		};
+
+		// Check that the value is inside of the pages which are still allocated
+		const auto is_valid = [&](u32 addr) -> bool
+		{
+			const u32 offset = addr - m_addr;
+
+			return offset % size == 0 && offset < m_data.size() && m_pages[offset / 4096] && check_addr(addr & ~0xfff, 4096);
+		};
+
+		std::vector<u32> result;
+
+		// Pages are read while they can't be unmapped (the lock is taken for each group of addresses or pages)
+		if (filter)
+		{
+			for (std::size_t group = 0; group < filter->size(); group += 4096)
+			{
+				map_op([&]()
+				{
+					for (std::size_t i = group; i < filter->size() && i < group + 4096; i++)
+					{
+						const u32 addr = (*filter)[i];
+
+						if (is_valid(addr) && test(addr))
+						{
+							result.push_back(addr);
+						}
+					}
+				});
+			}
+
+			return result;
+		}
+
+		for (u32 group = 0; group < m_pages.size(); group += 256)
+		{
+			map_op([&]()
+			{
+				for (u32 page = group; page < m_pages.size() && page < group + 256; page++)
+				{
+					const u32 page_addr = m_addr + page * 4096;
+
+					if (!m_pages[page] || !check_addr(page_addr, 4096))
+					{
+						continue;
+					}
+
+					for (u32 offset = 0; offset < 4096; offset += 16)
+					{
+						// Values in 16 equal bytes can't be changed
+						if (cmp != compare::unchanged)
+						{
+							const __m128i old_data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(m_data.data() + page * 4096 + offset));
+							const __m128i new_data = _mm_loadu_si128(static_cast<const __m128i*>(base_priv(page_addr + offset)));
+
+							if (_mm_movemask_epi8(_mm_cmpeq_epi8(old_data, new_data)) == 0xffff)
+							{
+								continue;
+							}
+						}
+
+						for (u32 i = 0; i < 16; i += size)
+						{
+							if (test(page_addr + offset + i))
+							{
+								result.push_back(page_addr + offset + i);
+							}
+						}
+					}
+				}
+			});
+		}
+
+		return result;
+	}
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "vm.h"
+
+namespace vm
+{
+	// Byte pattern for memory search
+	struct search_pattern
+	{
+		std::vector<u8> bytes;
+		std::vector<u8> mask; // 0xff for bytes which must match, 0 for wildcard bytes
+		u32 align = 1; // required alignment of the match address
+
+		// Make pattern matching the string (without null terminator)
+		static search_pattern from_string(const std::string& str);
+
+		// Make pattern from hex bytes separated by spaces, "?" or "??" is a wildcard byte (returns empty pattern on error)
+		static search_pattern from_hex(const std::string& str);
+
+		// Make aligned pattern matching the integer or floating point value stored in the specified byte order
+		template<typename T>
+		static search_pattern from_value(T value, bool big_endian = true)
+		{
+			static_assert(std::is_arithmetic<T>::value, "Invalid value type");
+
+			search_pattern result;
+			result.bytes.resize(sizeof(T));
+			result.mask.assign(sizeof(T), 0xff);
+			result.align = sizeof(T);
+
+			std::memcpy(result.bytes.data(), &value, sizeof(T));
+
+			if (big_endian)
+			{
+				std::reverse(result.bytes.begin(), result.bytes.end());
+			}
+
+			return result;
+		}
+	};
+
+	struct search_result
+	{
+		u32 addr;
+		u32 pattern; // index of the matched pattern
+	};
+
+	// Search allocated memory of the location for all patterns using worker threads
+	// (results are sorted by address, only the first max_results matches are returned)
+	std::vector<search_result> search(memory_location_t location, const std::vector<search_pattern>& patterns, std::size_t max_results = -1);
+
+	// Copy of allocated memory of the location, used to find values changed after it was taken
+	class memory_snapshot final
+	{
+		u32 m_addr;
+		std::vector<u8> m_data;
+		std::vector<bool> m_pages; // pages allocated at the moment the snapshot was taken
+
+	public:
+		enum class compare
+		{
+			changed,
+			unchanged,
+			increased, // compared as unsigned integers
+			decreased,
+		};
+
+		memory_snapshot(memory_location_t location);
+
+		// Find aligned values of the specified size (1, 2, 4 or 8) satisfying the comparison of current memory with the snapshot
+		// (if filter is set, only its addresses are checked, for example the result of the previous diff)
+		std::vector<u32> diff(u32 size, compare cmp, bool big_endian = true, const std::vector<u32>* filter = nullptr) const;
+	};
+}
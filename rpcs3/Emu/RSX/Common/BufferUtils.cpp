@@ -1,4 +1,5 @@
 #include "stdafx.h"
+#include "Emu/perf.h"
 #include "BufferUtils.h"
 #include "../rsx_methods.h"
 
@@ -55,6 +56,8 @@ void write_vertex_array_data_to_buffer(gsl::span<gsl::byte> raw_dst_span, const
 
 	u32 element_size = rsx::get_vertex_type_size_on_host(type, vector_element_count);
 
+	perf::add(perf::counter::rsx_vertex_upload, static_cast<u32>(type), count * element_size);
+
 	switch (type)
 	{
 	case rsx::vertex_base_type::ub:
@@ -3,27 +3,67 @@
 
 using namespace program_hash_util;
 
-size_t vertex_program_hash::operator()(const RSXVertexProgram &program) const
+namespace
 {
-	// 64-bit Fowler/Noll/Vo FNV-1a hash code
-	size_t hash = 0xCBF29CE484222325ULL;
-	const qword *instbuffer = (const qword*)program.data.data();
-	size_t instIndex = 0;
-	bool end = false;
-	for (unsigned i = 0; i < program.data.size() / 4; i++)
+	// 128-bit SIMD hash of RSX instructions (xxHash3-style accumulator, SSE2).
+	// Every instruction is mixed with a position-dependent key, so reordered programs don't collide.
+	class ucode_hasher
 	{
-		const qword inst = instbuffer[instIndex];
-		hash ^= inst.dword[0];
-		hash += (hash << 1) + (hash << 4) + (hash << 5) + (hash << 7) + (hash << 8) + (hash << 40);
-		hash ^= inst.dword[1];
-		hash += (hash << 1) + (hash << 4) + (hash << 5) + (hash << 7) + (hash << 8) + (hash << 40);
-		instIndex++;
+		__m128i m_acc = _mm_set_epi64x(0xC2B2AE3D27D4EB4Full, 0x9E3779B185EBCA87ull);
+		__m128i m_key = _mm_set_epi64x(0x27D4EB2F165667C5ull, 0x165667B19E3779F9ull);
+		u64 m_count = 0;
+
+	public:
+		force_inline void add(const void* inst)
+		{
+			const __m128i data = _mm_loadu_si128(static_cast<const __m128i*>(inst));
+			const __m128i data_key = _mm_xor_si128(data, m_key);
+
+			// low * high 32-bit halves of every 64-bit lane
+			const __m128i product = _mm_mul_epu32(data_key, _mm_shuffle_epi32(data_key, _MM_SHUFFLE(2, 3, 0, 1)));
+
+			m_acc = _mm_add_epi64(m_acc, _mm_add_epi64(product, _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2))));
+			m_key = _mm_add_epi64(m_key, _mm_set_epi64x(0x9E3779B97F4A7C15ull, 0xD6E8FEB86659FD93ull));
+			m_count++;
+		}
+
+		u64 get() const
+		{
+			u64 lanes[2];
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), m_acc);
+
+			u64 hash = lanes[0] ^ ((lanes[1] << 29) | (lanes[1] >> 35)) ^ (m_count * 0x9E3779B185EBCA87ull);
+			hash ^= hash >> 37;
+			hash *= 0x165667919E3779F9ull;
+			hash ^= hash >> 32;
+
+			// 0 is reserved for "not computed"
+			return hash ? hash : 1;
+		}
+	};
+}
+
+u64 vertex_program_utils::get_vertex_program_ucode_hash(const RSXVertexProgram &program)
+{
+	ucode_hasher hasher;
+
+	for (size_t i = 0; i + 4 <= program.data.size(); i += 4)
+	{
+		hasher.add(program.data.data() + i);
 	}
-	return hash;
+
+	return hasher.get();
+}
+
+size_t vertex_program_hash::operator()(const RSXVertexProgram &program) const
+{
+	return program.ucode_hash ? program.ucode_hash : vertex_program_utils::get_vertex_program_ucode_hash(program);
 }
 
 bool vertex_program_compare::operator()(const RSXVertexProgram &binary1, const RSXVertexProgram &binary2) const
 {
+	if (binary1.ucode_hash && binary2.ucode_hash && binary1.ucode_hash != binary2.ucode_hash)
+		return false;
 	if (binary1.output_mask != binary2.output_mask)
 		return false;
 	if (binary1.rsx_vertex_inputs != binary2.rsx_vertex_inputs)
@@ -74,31 +114,29 @@ size_t fragment_program_utils::get_fragment_program_ucode_size(void *ptr)
 	}
 }
 
-size_t fragment_program_hash::operator()(const RSXFragmentProgram& program) const
+u64 fragment_program_utils::get_fragment_program_ucode_hash(const void *ptr)
 {
-	// 64-bit Fowler/Noll/Vo FNV-1a hash code
-	size_t hash = 0xCBF29CE484222325ULL;
-	const qword *instbuffer = (const qword*)program.addr;
+	ucode_hasher hasher;
+	const qword *instBuffer = (const qword*)ptr;
 	size_t instIndex = 0;
 	while (true)
 	{
-		const qword& inst = instbuffer[instIndex];
-		hash ^= inst.dword[0];
-		hash += (hash << 1) + (hash << 4) + (hash << 5) + (hash << 7) + (hash << 8) + (hash << 40);
-		hash ^= inst.dword[1];
-		hash += (hash << 1) + (hash << 4) + (hash << 5) + (hash << 7) + (hash << 8) + (hash << 40);
+		const qword& inst = instBuffer[instIndex];
+		hasher.add(&inst);
 		instIndex++;
-		// Skip constants
-		if (fragment_program_utils::is_constant(inst.word[1]) ||
-			fragment_program_utils::is_constant(inst.word[2]) ||
-			fragment_program_utils::is_constant(inst.word[3]))
+		// Skip constants: they are loaded from the constant buffer, so programs only differing by them share a shader
+		if (is_constant(inst.word[1]) || is_constant(inst.word[2]) || is_constant(inst.word[3]))
 			instIndex++;
 
 		bool end = (inst.word[0] >> 8) & 0x1;
 		if (end)
-			return hash;
+			return hasher.get();
 	}
-	return 0;
+}
+
+size_t fragment_program_hash::operator()(const RSXFragmentProgram& program) const
+{
+	return program.ucode_hash ? program.ucode_hash : fragment_program_utils::get_fragment_program_ucode_hash(program.addr);
 }
 
 bool fragment_program_compare::operator()(const RSXFragmentProgram& binary1, const RSXFragmentProgram& binary2) const
@@ -108,6 +146,8 @@ bool fragment_program_compare::operator()(const RSXFragmentProgram& binary1, con
 		binary1.back_color_diffuse_output != binary2.back_color_diffuse_output || binary1.back_color_specular_output != binary2.back_color_specular_output ||
 		binary1.front_back_color_enabled != binary2.front_back_color_enabled || binary1.alpha_func != binary2.alpha_func)
 		return false;
+	if (binary1.ucode_hash && binary2.ucode_hash && binary1.ucode_hash != binary2.ucode_hash)
+		return false;
 	const qword *instBuffer1 = (const qword*)binary1.addr;
 	const qword *instBuffer2 = (const qword*)binary2.addr;
 	size_t instIndex = 0;
@@ -21,6 +21,14 @@ namespace program_hash_util
 		u32 word[4];
 	};
 
+	struct vertex_program_utils
+	{
+		/**
+		* returns fingerprint of the vertex program instructions (never 0)
+		*/
+		static u64 get_vertex_program_ucode_hash(const RSXVertexProgram &program);
+	};
+
 	struct vertex_program_hash
 	{
 		size_t operator()(const RSXVertexProgram &program) const;
@@ -39,6 +47,11 @@ namespace program_hash_util
 		static bool is_constant(u32 sourceOperand);
 
 		static size_t get_fragment_program_ucode_size(void *ptr);
+
+		/**
+		* returns fingerprint of the fragment program instructions, inline constants excluded (never 0)
+		*/
+		static u64 get_fragment_program_ucode_hash(const void *ptr);
 	};
 
 	struct fragment_program_hash
@@ -112,6 +125,11 @@ private:
 	binary_to_fragment_program m_fragment_shader_cache;
 	std::unordered_map <pipeline_key, pipeline_storage_type, pipeline_key_hash, pipeline_key_compare> m_storage;
 
+	// Programs found by the last getGraphicPipelineState call (elements of unordered_map are never moved)
+	const vertex_program_type* m_last_vertex_program = nullptr;
+	const fragment_program_type* m_last_fragment_program = nullptr;
+	bool m_last_programs_existing = false;
+
 	/// bool here to inform that the program was preexisting.
 	std::tuple<const vertex_program_type&, bool> search_vertex_program(const RSXVertexProgram& rsx_vp)
 	{
@@ -189,9 +207,43 @@ public:
 		bool already_existing_fragment_program = std::get<1>(fp_search);
 		bool already_existing_vertex_program = std::get<1>(vp_search);
 
+		m_last_vertex_program = &vertex_program;
+		m_last_fragment_program = &fragment_program;
+		m_last_programs_existing = already_existing_fragment_program && already_existing_vertex_program;
+
+		return get_pipeline(pipelineProperties, std::forward<Args>(args)...);
+	}
+
+	/**
+	* Same as getGraphicPipelineState, but reuses the programs found by the previous call without any lookup.
+	* The caller is responsible for checking that neither program changed since then.
+	*/
+	template<typename... Args>
+	pipeline_storage_type& getGraphicPipelineStateForLastPrograms(
+		const pipeline_properties& pipelineProperties,
+		Args&& ...args
+		)
+	{
+		if (!m_last_vertex_program || !m_last_fragment_program)
+		{
+			throw EXCEPTION("No program was used yet");
+		}
+
+		m_last_programs_existing = true;
+
+		return get_pipeline(pipelineProperties, std::forward<Args>(args)...);
+	}
+
+private:
+	template<typename... Args>
+	pipeline_storage_type& get_pipeline(const pipeline_properties& pipelineProperties, Args&& ...args)
+	{
+		const vertex_program_type &vertex_program = *m_last_vertex_program;
+		const fragment_program_type &fragment_program = *m_last_fragment_program;
+
 		pipeline_key key = { vertex_program.id, fragment_program.id, pipelineProperties };
 
-		if (already_existing_fragment_program && already_existing_vertex_program)
+		if (m_last_programs_existing)
 		{
 			const auto I = m_storage.find(key);
 			if (I != m_storage.end())
@@ -206,6 +258,7 @@ public:
 		return m_storage[key];
 	}
 
+public:
 	size_t get_fragment_constants_buffer_size(const RSXFragmentProgram &fragmentShader) const
 	{
 		const auto I = m_fragment_shader_cache.find(fragmentShader);
@@ -215,20 +268,44 @@ public:
 		return 0;
 	}
 
+	/**
+	* Fragment constants buffer size for the fragment program used by the last getGraphicPipelineState call (no lookup)
+	*/
+	size_t get_last_fragment_constants_buffer_size() const
+	{
+		return m_last_fragment_program ? m_last_fragment_program->FragmentConstantOffsetCache.size() * 4 * sizeof(float) : 0;
+	}
+
 	void fill_fragment_constans_buffer(gsl::span<f32, gsl::dynamic_range> dst_buffer, const RSXFragmentProgram &fragment_program) const
 	{
 		const auto I = m_fragment_shader_cache.find(fragment_program);
 		if (I == m_fragment_shader_cache.end())
 			return;
+		fill_fragment_constants_buffer(dst_buffer, I->second, fragment_program);
+	}
+
+	/**
+	* Fill fragment constants of the fragment program used by the last getGraphicPipelineState call (no lookup).
+	* Constants are read from the ucode at fragment_program.addr.
+	*/
+	void fill_last_fragment_constants_buffer(gsl::span<f32, gsl::dynamic_range> dst_buffer, const RSXFragmentProgram &fragment_program) const
+	{
+		if (m_last_fragment_program)
+			fill_fragment_constants_buffer(dst_buffer, *m_last_fragment_program, fragment_program);
+	}
+
+private:
+	void fill_fragment_constants_buffer(gsl::span<f32, gsl::dynamic_range> dst_buffer, const fragment_program_type &program, const RSXFragmentProgram &fragment_program) const
+	{
 		__m128i mask = _mm_set_epi8(0xE, 0xF, 0xC, 0xD,
 			0xA, 0xB, 0x8, 0x9,
 			0x6, 0x7, 0x4, 0x5,
 			0x2, 0x3, 0x0, 0x1);
 
-		Expects(dst_buffer.size_bytes() >= gsl::narrow<int>(I->second.FragmentConstantOffsetCache.size()) * 16);
+		Expects(dst_buffer.size_bytes() >= gsl::narrow<int>(program.FragmentConstantOffsetCache.size()) * 16);
 
 		size_t offset = 0;
-		for (size_t offset_in_fragment_program : I->second.FragmentConstantOffsetCache)
+		for (size_t offset_in_fragment_program : program.FragmentConstantOffsetCache)
 		{
 			void *data = (char*)fragment_program.addr + (u32)offset_in_fragment_program;
 			const __m128i &vector = _mm_loadu_si128((__m128i*)data);
@@ -238,6 +315,7 @@ public:
 		}
 	}
 
+public:
 	void clear()
 	{
 		m_storage.clear();
@@ -1,5 +1,6 @@
 #include "stdafx.h"
 #include "Emu/Memory/vm.h"
+#include "Emu/perf.h"
 #include "TextureUtils.h"
 #include "../RSXThread.h"
 #include "../rsx_utils.h"
@@ -34,7 +35,13 @@ struct copy_unmodified_block
 		size_t row_element_count = dst_pitch_in_block;
 		static_assert(sizeof(T) == sizeof(U), "Type size doesn't match.");
 		for (int row = 0; row < row_count * depth; ++row)
-			copy(dst.subspan(row * dst_pitch_in_block, width_in_block), src.subspan(row * src_pitch_in_block, width_in_block));
+		{
+			// Big endian source (be_t) is converted with SIMD byteswap
+			if (std::is_same<T, U>::value)
+				copy(dst.subspan(row * dst_pitch_in_block, width_in_block), src.subspan(row * src_pitch_in_block, width_in_block));
+			else
+				rsx::copy_byteswapped(dst.subspan(row * dst_pitch_in_block, width_in_block).data(), src.subspan(row * src_pitch_in_block, width_in_block).data(), sizeof(T), width_in_block);
+		}
 	}
 };
 
@@ -43,13 +50,18 @@ struct copy_unmodified_block_swizzled
 	template<typename T, typename U>
 	static void copy_mipmap_level(gsl::span<T> dst, gsl::span<const U> src, u16 width_in_block, u16 row_count, u16 depth, u32 dst_pitch_in_block)
 	{
-		std::unique_ptr<U[]> temp_swizzled(new U[width_in_block * row_count]);
+		static_assert(sizeof(T) == sizeof(U), "Type size doesn't match.");
 		for (int d = 0; d < depth; ++d)
 		{
-			rsx::convert_linear_swizzle<U>((void*)src.subspan(d * width_in_block * row_count).data(), temp_swizzled.get(), width_in_block, row_count, true);
-			gsl::span<const U> swizzled_src{ temp_swizzled.get(), gsl::narrow<int>(width_in_block * row_count) };
-			for (int row = 0; row < row_count; ++row)
-				copy(dst.subspan((row + d * row_count) * dst_pitch_in_block, width_in_block), swizzled_src.subspan(row * width_in_block, width_in_block));
+			// Unswizzle straight into destination rows
+			gsl::span<T> dst_slice = dst.subspan(d * row_count * dst_pitch_in_block, (row_count - 1) * dst_pitch_in_block + width_in_block);
+			rsx::convert_linear_swizzle(src.subspan(d * width_in_block * row_count, width_in_block * row_count).data(), dst_slice.data(), sizeof(T), width_in_block, row_count, dst_pitch_in_block, true);
+
+			if (!std::is_same<T, U>::value)
+			{
+				for (int row = 0; row < row_count; ++row)
+					rsx::copy_byteswapped(dst_slice.subspan(row * dst_pitch_in_block).data(), dst_slice.subspan(row * dst_pitch_in_block).data(), sizeof(T), width_in_block);
+			}
 		}
 	}
 };
@@ -178,6 +190,9 @@ void upload_texture_subresource(gsl::span<gsl::byte> dst_buffer, const rsx_subre
 	u16 w = src_layout.width_in_block;
 	u16 h = src_layout.height_in_block;
 	u16 depth = src_layout.depth;
+
+	perf::add(perf::counter::rsx_texture_upload, format, dst_buffer.size());
+
 	switch (format)
 	{
 	case CELL_GCM_TEXTURE_A8R8G8B8:
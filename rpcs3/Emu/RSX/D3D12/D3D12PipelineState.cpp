@@ -38,8 +38,14 @@ void Shader::Compile(const std::string &code, SHADER_TYPE st)
 
 void D3D12GSRender::load_program()
 {
-	m_vertex_program = get_current_vertex_program();
-	m_fragment_program = get_current_fragment_program();
+	// both programs must be updated (no short-circuit evaluation)
+	const bool programs_changed = update_current_vertex_program() | update_current_fragment_program();
+
+	if (programs_changed)
+	{
+		m_vertex_program = current_vertex_program;
+		m_fragment_program = current_fragment_program;
+	}
 
 	D3D12PipelineProperties prop = {};
 	prop.Topology = get_primitive_topology_type(draw_mode);
@@ -236,7 +242,14 @@ void D3D12GSRender::load_program()
 		}
 	}
 
-	m_current_pso = m_pso_cache.getGraphicPipelineState(m_vertex_program, m_fragment_program, prop, m_device.Get(), m_shared_root_signature.Get());
+	if (programs_changed)
+	{
+		m_current_pso = m_pso_cache.getGraphicPipelineState(m_vertex_program, m_fragment_program, prop, m_device.Get(), m_shared_root_signature.Get());
+	}
+	else
+	{
+		m_current_pso = m_pso_cache.getGraphicPipelineStateForLastPrograms(prop, m_device.Get(), m_shared_root_signature.Get());
+	}
 	return;
 }
 
@@ -904,10 +904,15 @@ bool GLGSRender::do_method(u32 cmd, u32 arg)
 bool GLGSRender::load_program()
 {
 #if 1
-	RSXVertexProgram vertex_program = get_current_vertex_program();
-	RSXFragmentProgram fragment_program = get_current_fragment_program();
+	// both programs must be updated (no short-circuit evaluation)
+	const bool programs_changed = update_current_vertex_program() | update_current_fragment_program();
+	const RSXFragmentProgram& fragment_program = current_fragment_program;
+
+	if (programs_changed)
+	{
+		__glcheck m_program = &m_prog_buffer.getGraphicPipelineState(current_vertex_program, fragment_program, nullptr);
+	}
 
-	__glcheck m_program = &m_prog_buffer.getGraphicPipelineState(vertex_program, fragment_program, nullptr);
 	__glcheck m_program->use();
 
 #else
@@ -948,7 +953,7 @@ bool GLGSRender::load_program()
 	(m_program.recreate() += { fp.compile(), vp.compile() }).make();
 #endif
 	size_t max_buffer_sz =(size_t) m_vertex_constants_buffer.size();
-	size_t fragment_constants_sz = m_prog_buffer.get_fragment_constants_buffer_size(fragment_program);
+	size_t fragment_constants_sz = m_prog_buffer.get_last_fragment_constants_buffer_size();
 	if (fragment_constants_sz > max_buffer_sz)
 		max_buffer_sz = fragment_constants_sz;
 
@@ -964,7 +969,7 @@ bool GLGSRender::load_program()
 	m_vertex_constants_buffer.data(m_vertex_constants_buffer.size(), nullptr);
 	m_vertex_constants_buffer.sub_data(0, m_vertex_constants_buffer.size(), client_side_buf.data());
 
-	m_prog_buffer.fill_fragment_constans_buffer({ reinterpret_cast<float*>(client_side_buf.data()), gsl::narrow<int>(fragment_constants_sz) }, fragment_program);
+	m_prog_buffer.fill_last_fragment_constants_buffer({ reinterpret_cast<float*>(client_side_buf.data()), gsl::narrow<int>(fragment_constants_sz) }, fragment_program);
 	m_fragment_constants_buffer.data(fragment_constants_sz, nullptr);
 	m_fragment_constants_buffer.sub_data(0, fragment_constants_sz, client_side_buf.data());
 
@@ -229,6 +229,7 @@ struct RSXFragmentProgram
 	rsx::window_pixel_center pixel_center_mode;
 	rsx::fog_mode fog_equation;
 	u16 height;
+	u64 ucode_hash; // fingerprint of the ucode (0 if not computed)
 
 	texture_dimension get_texture_dimension(u8 id) const
 	{
@@ -2,6 +2,7 @@
 #include "Emu/Memory/Memory.h"
 #include "Emu/System.h"
 #include "Emu/state.h"
+#include "Emu/perf.h"
 #include "Emu/RSX/GSManager.h"
 #include "RSXThread.h"
 
@@ -10,13 +11,28 @@
 #include "Emu/SysCalls/lv2/sys_time.h"
 
 #include "Common/BufferUtils.h"
+#include "Common/ProgramStateCache.h"
 #include "rsx_methods.h"
 
 #define CMD_DEBUG 0
 
-bool user_asked_for_frame_capture = false;
+std::atomic<bool> user_asked_for_frame_capture{ false };
 frame_capture_data frame_debug;
 
+// pages of the current fragment program ucode, write-protected by update_current_fragment_program()
+static std::atomic<u32> g_fragment_ucode_begin{ 0 };
+static std::atomic<u32> g_fragment_ucode_end{ 0 };
+static std::atomic<bool> g_fragment_ucode_written{ false };
+
+// called by vm before a watched page becomes writable again (or is unmapped)
+void rsx_discard_code(u32 addr, u32 size)
+{
+	if (addr < g_fragment_ucode_end && addr + size > g_fragment_ucode_begin)
+	{
+		g_fragment_ucode_written = true;
+	}
+}
+
 namespace rsx
 {
 	std::function<bool(u32 addr, bool is_writing)> g_access_violation_handler;
@@ -204,14 +220,32 @@ namespace rsx
 		case CELL_GCM_COMPMODE_C32_2X2:
 			for (u32 y = 0; y < height; ++y)
 			{
-				for (u32 x = 0; x < width; ++x)
+				const u32* src_row = (const u32*)((const u8*)src + pitch * y);
+				u32* dst_row0 = (u32*)(ptr + (offset_y + y * 2 + 0) * tile->pitch + offset_x);
+				u32* dst_row1 = (u32*)(ptr + (offset_y + y * 2 + 1) * tile->pitch + offset_x);
+				u32 x = 0;
+
+				// every texel is duplicated to 2x2 texels, 4 at once
+				for (; x + 4 <= width; x += 4)
 				{
-					u32 value = *(u32*)((u8*)src + pitch * y + x * sizeof(u32));
+					const __m128i value = _mm_loadu_si128((const __m128i*)(src_row + x));
+					const __m128i lo = _mm_unpacklo_epi32(value, value);
+					const __m128i hi = _mm_unpackhi_epi32(value, value);
+
+					_mm_storeu_si128((__m128i*)(dst_row0 + x * 2 + 0), lo);
+					_mm_storeu_si128((__m128i*)(dst_row0 + x * 2 + 4), hi);
+					_mm_storeu_si128((__m128i*)(dst_row1 + x * 2 + 0), lo);
+					_mm_storeu_si128((__m128i*)(dst_row1 + x * 2 + 4), hi);
+				}
+
+				for (; x < width; ++x)
+				{
+					const u32 value = src_row[x];
 
-					*(u32*)(ptr + (offset_y + y * 2 + 0) * tile->pitch + offset_x + (x * 2 + 0) * sizeof(u32)) = value;
-					*(u32*)(ptr + (offset_y + y * 2 + 0) * tile->pitch + offset_x + (x * 2 + 1) * sizeof(u32)) = value;
-					*(u32*)(ptr + (offset_y + y * 2 + 1) * tile->pitch + offset_x + (x * 2 + 0) * sizeof(u32)) = value;
-					*(u32*)(ptr + (offset_y + y * 2 + 1) * tile->pitch + offset_x + (x * 2 + 1) * sizeof(u32)) = value;
+					dst_row0[x * 2 + 0] = value;
+					dst_row0[x * 2 + 1] = value;
+					dst_row1[x * 2 + 0] = value;
+					dst_row1[x * 2 + 1] = value;
 				}
 			}
 			break;
@@ -256,11 +290,22 @@ namespace rsx
 		case CELL_GCM_COMPMODE_C32_2X2:
 			for (u32 y = 0; y < height; ++y)
 			{
-				for (u32 x = 0; x < width; ++x)
+				const u32* src_row = (const u32*)(ptr + (offset_y + y * 2 + 0) * tile->pitch + offset_x);
+				u32* dst_row = (u32*)((u8*)dst + pitch * y);
+				u32 x = 0;
+
+				// take every other texel of the even rows, 4 at once
+				for (; x + 4 <= width; x += 4)
 				{
-					u32 value = *(u32*)(ptr + (offset_y + y * 2 + 0) * tile->pitch + offset_x + (x * 2 + 0) * sizeof(u32));
+					const __m128 a = _mm_loadu_ps((const float*)(src_row + x * 2 + 0));
+					const __m128 b = _mm_loadu_ps((const float*)(src_row + x * 2 + 4));
 
-					*(u32*)((u8*)dst + pitch * y + x * sizeof(u32)) = value;
+					_mm_storeu_ps((float*)(dst_row + x), _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+				}
+
+				for (; x < width; ++x)
+				{
+					dst_row[x] = src_row[x * 2];
 				}
 			}
 			break;
@@ -278,6 +323,8 @@ namespace rsx
 		m_rtts_dirty = true;
 		memset(m_textures_dirty, -1, sizeof(m_textures_dirty));
 		m_transform_constants_dirty = true;
+		m_vertex_program_dirty = true;
+		m_fragment_program_dirty = true;
 	}
 
 	thread::~thread()
@@ -288,6 +335,7 @@ namespace rsx
 	void thread::capture_frame(const std::string &name)
 	{
 		frame_capture_data::draw_state draw_state = {};
+		frame_capture_data::draw_buffers buffers;
 
 		int clip_w = rsx::method_registers[NV4097_SET_SURFACE_CLIP_HORIZONTAL] >> 16;
 		int clip_h = rsx::method_registers[NV4097_SET_SURFACE_CLIP_VERTICAL] >> 16;
@@ -296,9 +344,9 @@ namespace rsx
 		draw_state.width = clip_w;
 		draw_state.height = clip_h;
 		draw_state.color_format = surface.color_format;
-		draw_state.color_buffer = std::move(copy_render_targets_to_memory());
+		buffers.color_buffer = copy_render_targets_to_memory();
 		draw_state.depth_format = surface.depth_format;
-		draw_state.depth_stencil = std::move(copy_depth_stencil_buffer_to_memory());
+		buffers.depth_stencil = copy_depth_stencil_buffer_to_memory();
 
 		if (draw_command == rsx::draw_command::indexed)
 		{
@@ -310,21 +358,21 @@ namespace rsx
 			draw_state.index_type = rsx::to_index_array_type(rsx::method_registers[NV4097_SET_INDEX_ARRAY_DMA] >> 4);
 			if (draw_state.index_type == rsx::index_array_type::u16)
 			{
-				draw_state.index.resize(2 * draw_state.vertex_count);
-				gsl::span<u16> dst = { (u16*)draw_state.index.data(), gsl::narrow<int>(draw_state.vertex_count) };
+				buffers.index.resize(2 * draw_state.vertex_count);
+				gsl::span<u16> dst = { (u16*)buffers.index.data(), gsl::narrow<int>(draw_state.vertex_count) };
 				write_index_array_data_to_buffer(dst, draw_mode, first_count_commands);
 			}
 			if (draw_state.index_type == rsx::index_array_type::u32)
 			{
-				draw_state.index.resize(4 * draw_state.vertex_count);
-				gsl::span<u16> dst = { (u16*)draw_state.index.data(), gsl::narrow<int>(draw_state.vertex_count) };
+				buffers.index.resize(4 * draw_state.vertex_count);
+				gsl::span<u16> dst = { (u16*)buffers.index.data(), gsl::narrow<int>(draw_state.vertex_count) };
 				write_index_array_data_to_buffer(dst, draw_mode, first_count_commands);
 			}
 		}
 
 		draw_state.programs = get_programs();
 		draw_state.name = name;
-		frame_debug.draw_calls.push_back(draw_state);
+		frame_debug.add_draw_call(std::move(draw_state), std::move(buffers));
 	}
 
 	void thread::begin()
@@ -337,6 +385,16 @@ namespace rsx
 	{
 		transform_constants.clear();
 
+		if (perf::g_mode.load(std::memory_order_relaxed))
+		{
+			u32 vertex_count = 0;
+
+			for (const auto &first_count : first_count_commands)
+				vertex_count += first_count.second;
+
+			perf::add(perf::counter::rsx_draw, 0, vertex_count);
+		}
+
 		if (capture_current_frame)
 		{
 			for (const auto &first_count : first_count_commands)
@@ -438,22 +496,48 @@ namespace rsx
 				LOG_WARNING(RSX, "unaligned command: %s (0x%x from 0x%x)", get_method_name(first_cmd).c_str(), first_cmd, cmd & 0xffff);
 			}
 
-			for (u32 i = 0; i < count; i++)
-			{
-				u32 reg = cmd & CELL_GCM_METHOD_FLAG_NON_INCREMENT ? first_cmd : first_cmd + i;
-				u32 value = args[i];
+			perf::add(perf::counter::rsx_method, first_cmd, count);
 
-				if (rpcs3::config.misc.log.rsx_logging.value())
+			const bool log_methods = rpcs3::config.misc.log.rsx_logging.value();
+
+			if (capture_current_frame || log_methods)
+			{
+				// slow path: every method is logged or captured separately
+				for (u32 i = 0; i < count; i++)
 				{
-					LOG_NOTICE(RSX, "%s(0x%x) = 0x%x", get_method_name(reg).c_str(), reg, value);
+					u32 reg = cmd & CELL_GCM_METHOD_FLAG_NON_INCREMENT ? first_cmd : first_cmd + i;
+					u32 value = args[i];
+
+					if (log_methods)
+					{
+						LOG_NOTICE(RSX, "%s(0x%x) = 0x%x", get_method_name(reg).c_str(), reg, value);
+					}
+
+					method_registers[reg] = value;
+					if (capture_current_frame)
+						frame_debug.command_queue.push_back(std::make_pair(reg, value));
+
+					if (auto method = methods[reg])
+						method(this, value);
 				}
+			}
+			else if (cmd & CELL_GCM_METHOD_FLAG_NON_INCREMENT)
+			{
+				const auto method = methods[first_cmd];
 
-				method_registers[reg] = value;
-				if (capture_current_frame)
-					frame_debug.command_queue.push_back(std::make_pair(reg, value));
+				for (u32 i = 0; i < count; i++)
+				{
+					const u32 value = args[i];
+
+					method_registers[first_cmd] = value;
 
-				if (auto method = methods[reg])
-					method(this, value);
+					if (method)
+						method(this, value);
+				}
+			}
+			else
+			{
+				process_packet(first_cmd, args.get_ptr(), count);
 			}
 
 			ctrl->get = get + (count + 1) * 4;
@@ -465,6 +549,53 @@ namespace rsx
 		return "rsx::thread"s;
 	}
 
+	void thread::process_packet(u32 first_reg, const be_t<u32>* args, u32 count)
+	{
+		// store registers [begin, end) of the packet
+		const auto store = [&](u32 begin, u32 end)
+		{
+			for (u32 i = begin; i < end; i++)
+			{
+				method_registers[first_reg + i] = args[i];
+			}
+		};
+
+		for (u32 i = 0; i < count;)
+		{
+			const u32 reg = first_reg + i;
+
+			// register group processed at once
+			if (const auto packet_method = packet_methods[reg].func)
+			{
+				const u32 size = std::min(packet_methods[reg].end - reg, count - i);
+
+				store(i, i + size);
+				packet_method(this, reg, size);
+				i += size;
+				continue;
+			}
+
+			if (const auto method = methods[reg])
+			{
+				store(i, i + 1);
+				method(this, method_registers[reg]);
+				i++;
+				continue;
+			}
+
+			// store all registers until the next one having a handler
+			u32 end = i + 1;
+
+			while (end < count && !methods[first_reg + end] && !packet_methods[first_reg + end].func)
+			{
+				end++;
+			}
+
+			store(i, end);
+			i = end;
+		}
+	}
+
 	void thread::fill_scale_offset_data(void *buffer, bool is_d3d) const
 	{
 		int clip_w = rsx::method_registers[NV4097_SET_SURFACE_CLIP_HORIZONTAL] >> 16;
@@ -642,28 +773,53 @@ namespace rsx
 		return rsx::get_address(offset_zeta, m_context_dma_z);
 	}
 
-	RSXVertexProgram thread::get_current_vertex_program() const
+	bool thread::update_current_vertex_program()
 	{
-		RSXVertexProgram result = {};
-		u32 transform_program_start = rsx::method_registers[NV4097_SET_TRANSFORM_PROGRAM_START];
-		result.data.reserve((512 - transform_program_start) * 4);
+		RSXVertexProgram& result = current_vertex_program;
+		bool changed = false;
 
-		for (int i = transform_program_start; i < 512; ++i)
+		if (m_vertex_program_dirty)
 		{
-			result.data.resize((i - transform_program_start) * 4 + 4);
-			memcpy(result.data.data() + (i - transform_program_start) * 4, transform_program + i * 4, 4 * sizeof(u32));
+			m_vertex_program_dirty = false;
+
+			const u32 transform_program_start = rsx::method_registers[NV4097_SET_TRANSFORM_PROGRAM_START];
+			u32 transform_program_end = transform_program_start;
 
-			D3 d3;
-			d3.HEX = transform_program[i * 4 + 3];
+			while (transform_program_end < 512)
+			{
+				D3 d3;
+				d3.HEX = transform_program[transform_program_end++ * 4 + 3];
 
-			if (d3.end)
-				break;
+				if (d3.end)
+					break;
+			}
+
+			const u32* begin = transform_program + transform_program_start * 4;
+			const u32* end = transform_program + transform_program_end * 4;
+
+			// the same program is often uploaded again before every draw
+			if (result.data.size() != size_t(end - begin) || !std::equal(begin, end, result.data.begin()))
+			{
+				result.data.assign(begin, end);
+				result.ucode_hash = program_hash_util::vertex_program_utils::get_vertex_program_ucode_hash(result);
+				changed = true;
+			}
+		}
+
+		const u32 output_mask = rsx::method_registers[NV4097_SET_VERTEX_ATTRIB_OUTPUT_MASK];
+
+		if (result.output_mask != output_mask)
+		{
+			result.output_mask = output_mask;
+			changed = true;
 		}
-		result.output_mask = rsx::method_registers[NV4097_SET_VERTEX_ATTRIB_OUTPUT_MASK];
 
 		u32 input_mask = rsx::method_registers[NV4097_SET_VERTEX_ATTRIB_INPUT_MASK];
 		u32 modulo_mask = rsx::method_registers[NV4097_SET_FREQUENCY_DIVIDER_OPERATION];
-		result.rsx_vertex_inputs.clear();
+
+		std::array<rsx_vertex_input, rsx::limits::vertex_count> inputs;
+		size_t input_count = 0;
+
 		for (u8 index = 0; index < rsx::limits::vertex_count; ++index)
 		{
 			bool enabled = !!(input_mask & (1 << index));
@@ -672,7 +828,7 @@ namespace rsx
 
 			if (vertex_arrays_info[index].size > 0)
 			{
-				result.rsx_vertex_inputs.push_back(
+				inputs[input_count++] =
 				{
 					index,
 					vertex_arrays_info[index].size,
@@ -680,12 +836,11 @@ namespace rsx
 					!!((modulo_mask >> index) & 0x1),
 					true,
 					is_int_type(vertex_arrays_info[index].type)
-				}
-				);
+				};
 			}
 			else if (register_vertex_info[index].size > 0)
 			{
-				result.rsx_vertex_inputs.push_back(
+				inputs[input_count++] =
 				{
 					index,
 					register_vertex_info[index].size,
@@ -693,20 +848,43 @@ namespace rsx
 					!!((modulo_mask >> index) & 0x1),
 					false,
 					is_int_type(vertex_arrays_info[index].type)
-				}
-				);
+				};
 			}
 		}
-		return result;
+
+		if (result.rsx_vertex_inputs.size() != input_count || !std::equal(inputs.begin(), inputs.begin() + input_count, result.rsx_vertex_inputs.begin()))
+		{
+			result.rsx_vertex_inputs.assign(inputs.begin(), inputs.begin() + input_count);
+			changed = true;
+		}
+
+		return changed;
 	}
 
+	static bool is_same_fragment_program_state(const RSXFragmentProgram& a, const RSXFragmentProgram& b)
+	{
+		return a.addr == b.addr &&
+			a.offset == b.offset &&
+			a.ctrl == b.ctrl &&
+			a.unnormalized_coords == b.unnormalized_coords &&
+			a.alpha_func == b.alpha_func &&
+			a.front_back_color_enabled == b.front_back_color_enabled &&
+			a.back_color_diffuse_output == b.back_color_diffuse_output &&
+			a.back_color_specular_output == b.back_color_specular_output &&
+			a.texture_dimensions == b.texture_dimensions &&
+			a.origin_mode == b.origin_mode &&
+			a.pixel_center_mode == b.pixel_center_mode &&
+			a.fog_equation == b.fog_equation &&
+			a.height == b.height;
+	}
 
-	RSXFragmentProgram thread::get_current_fragment_program() const
+	bool thread::update_current_fragment_program()
 	{
 		RSXFragmentProgram result = {};
 		u32 shader_program = rsx::method_registers[NV4097_SET_SHADER_PROGRAM];
 		result.offset = shader_program & ~0x3;
-		result.addr = vm::base(rsx::get_address(result.offset, (shader_program & 0x3) - 1));
+		const u32 ucode_addr = rsx::get_address(result.offset, (shader_program & 0x3) - 1);
+		result.addr = vm::base(ucode_addr);
 		result.ctrl = rsx::method_registers[NV4097_SET_SHADER_CONTROL];
 		result.unnormalized_coords = 0;
 		result.front_back_color_enabled = !rsx::method_registers[NV4097_SET_TWO_SIDE_LIGHT_EN];
@@ -742,13 +920,82 @@ namespace rsx
 		}
 		result.set_texture_dimension(texture_dimensions);
 
-		return result;
+		bool ucode_changed = false;
+		result.ucode_hash = current_fragment_program.ucode_hash;
+
+		// the ucode is only read again if the program was set or its pages were written since the last call
+		if (m_fragment_program_dirty || !m_fragment_program_watched || g_fragment_ucode_written.exchange(false))
+		{
+			m_fragment_program_dirty = false;
+
+			const u32 size = (u32)program_hash_util::fragment_program_utils::get_fragment_program_ucode_size(result.addr);
+			const u32 begin = ucode_addr & ~0xfff;
+			const u32 end = (ucode_addr + size + 0xfff) & ~0xfff;
+			const u32 old_begin = g_fragment_ucode_begin.exchange(begin);
+			const u32 old_end = g_fragment_ucode_end.exchange(end);
+
+			// the program moved: stop watching the pages it doesn't use anymore
+			for (u32 page = old_begin; page < old_end; page += 4096)
+			{
+				if (page < begin || page >= end)
+				{
+					vm::invalidate_code(page);
+				}
+			}
+
+			// write-protect the ucode pages before reading it, so that any later write sets g_fragment_ucode_written
+			g_fragment_ucode_written = false;
+			m_fragment_program_watched = true;
+
+			for (u32 page = begin; page < end; page += 4096)
+			{
+				if (!vm::page_protect(page, 4096, vm::page_writable, vm::page_executable, vm::page_writable) && !vm::page_protect(page, 4096, vm::page_executable))
+				{
+					// can't be watched (not mapped): the ucode is compared on every draw
+					m_fragment_program_watched = false;
+				}
+			}
+
+			// full compare of the instructions (inline constants are read on every draw and don't change the program)
+			using program_hash_util::fragment_program_utils;
+			const program_hash_util::qword* inst = (const program_hash_util::qword*)result.addr;
+			m_fragment_ucode_temp.clear();
+
+			for (u32 i = 0;; i++)
+			{
+				m_fragment_ucode_temp.insert(m_fragment_ucode_temp.end(), inst[i].word, inst[i].word + 4);
+
+				if ((inst[i].word[0] >> 8) & 0x1)
+				{
+					break;
+				}
+
+				if (fragment_program_utils::is_constant(inst[i].word[1]) || fragment_program_utils::is_constant(inst[i].word[2]) || fragment_program_utils::is_constant(inst[i].word[3]))
+				{
+					i++;
+				}
+			}
+
+			if (m_fragment_ucode_temp != m_fragment_ucode)
+			{
+				m_fragment_ucode.swap(m_fragment_ucode_temp);
+				result.ucode_hash = program_hash_util::fragment_program_utils::get_fragment_program_ucode_hash(result.addr);
+				ucode_changed = true;
+			}
+		}
+
+		const bool changed = ucode_changed || !is_same_fragment_program_state(result, current_fragment_program);
+
+		current_fragment_program = result;
+		return changed;
 	}
 
 	void thread::reset()
 	{
 		//setup method registers
 		std::memset(method_registers, 0, sizeof(method_registers));
+		m_vertex_program_dirty = true;
+		m_fragment_program_dirty = true;
 
 		method_registers[NV4097_SET_COLOR_MASK] = CELL_GCM_COLOR_MASK_R | CELL_GCM_COLOR_MASK_G | CELL_GCM_COLOR_MASK_B | CELL_GCM_COLOR_MASK_A;
 		method_registers[NV4097_SET_SCISSOR_HORIZONTAL] = (4096 << 16) | 0;
@@ -4,6 +4,7 @@
 #include "RSXTexture.h"
 #include "RSXVertexProgram.h"
 #include "RSXFragmentProgram.h"
+#include "rsx_capture.h"
 
 #include <stack>
 #include "Utilities/Semaphore.h"
@@ -13,32 +14,7 @@
 
 extern u64 get_system_time();
 
-struct frame_capture_data
-{
-	struct draw_state
-	{
-		std::string name;
-		std::pair<std::string, std::string> programs;
-		size_t width = 0, height = 0;
-		rsx::surface_color_format color_format;
-		std::array<std::vector<gsl::byte>, 4> color_buffer;
-		rsx::surface_depth_format depth_format;
-		std::array<std::vector<gsl::byte>, 2> depth_stencil;
-		rsx::index_array_type index_type;
-		std::vector<gsl::byte> index;
-		u32 vertex_count;
-	};
-	std::vector<std::pair<u32, u32> > command_queue;
-	std::vector<draw_state> draw_calls;
-
-	void reset()
-	{
-		command_queue.clear();
-		draw_calls.clear();
-	}
-};
-
-extern bool user_asked_for_frame_capture;
+extern std::atomic<bool> user_asked_for_frame_capture;
 extern frame_capture_data frame_debug;
 
 namespace rsx
@@ -264,7 +240,7 @@ namespace rsx
 
 		u32 transform_program[512 * 4] = {};
 
-		bool capture_current_frame = false;
+		std::atomic<bool> capture_current_frame{ false }; // set from the flip which starts a capture until the capture file is complete
 		void capture_frame(const std::string &name);
 
 	public:
@@ -294,11 +270,34 @@ namespace rsx
 		bool m_rtts_dirty;
 		bool m_transform_constants_dirty;
 		bool m_textures_dirty[16];
+		bool m_vertex_program_dirty; // transform program ucode or start slot written
+		bool m_fragment_program_dirty; // shader program address or control written
 	protected:
+		// Programs built from the current state by update_current_vertex_program()/update_current_fragment_program()
+		RSXVertexProgram current_vertex_program = {};
+		RSXFragmentProgram current_fragment_program = {};
+
+		bool m_fragment_program_watched = false; // ucode pages are write-protected
+		std::vector<u32> m_fragment_ucode; // instructions of current_fragment_program (inline constants excluded)
+		std::vector<u32> m_fragment_ucode_temp;
+
 		std::array<u32, 4> get_color_surface_addresses() const;
 		u32 get_zeta_surface_address() const;
-		RSXVertexProgram get_current_vertex_program() const;
-		RSXFragmentProgram get_current_fragment_program() const;
+
+		/**
+		 * Update current_vertex_program from method registers.
+		 * Transform program ucode is only reloaded when m_vertex_program_dirty is set.
+		 * Returns false if the program is the same as in the previous call.
+		 */
+		bool update_current_vertex_program();
+
+		/**
+		 * Update current_fragment_program from method registers.
+		 * The ucode is only read again when m_fragment_program_dirty is set or its pages were written
+		 * (they are write-protected, see rsx_discard_code()), and is compared with the previous instructions.
+		 * Returns false if the program is the same as in the previous call.
+		 */
+		bool update_current_fragment_program();
 	public:
 		u32 draw_array_count;
 		u32 draw_array_first;
@@ -321,6 +320,9 @@ namespace rsx
 
 		virtual void on_task() override;
 
+		// Store registers written by an incrementing FIFO packet and call their handlers
+		void process_packet(u32 first_reg, const be_t<u32>* args, u32 count);
+
 	public:
 		virtual std::string get_name() const override;
 
@@ -210,4 +210,5 @@ struct RSXVertexProgram
 	std::vector<u32> data;
 	std::vector<rsx_vertex_input> rsx_vertex_inputs;
 	u32 output_mask;
+	u64 ucode_hash; // fingerprint of data (0 if not computed)
 };
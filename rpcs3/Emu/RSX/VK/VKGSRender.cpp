@@ -844,11 +844,15 @@ bool VKGSRender::do_method(u32 cmd, u32 arg)
 
 bool VKGSRender::load_program()
 {
-	RSXVertexProgram vertex_program = get_current_vertex_program();
-	RSXFragmentProgram fragment_program = get_current_fragment_program();
+	// both programs must be updated (no short-circuit evaluation)
+	const bool programs_changed = update_current_vertex_program() | update_current_fragment_program();
+	const RSXFragmentProgram& fragment_program = current_fragment_program;
 
-	//Load current program from buffer
-	m_program = &m_prog_buffer.getGraphicPipelineState(vertex_program, fragment_program, nullptr);
+	//Load current program from buffer (the previous one is kept if nothing changed)
+	if (programs_changed)
+	{
+		m_program = &m_prog_buffer.getGraphicPipelineState(current_vertex_program, fragment_program, nullptr);
+	}
 
 	//TODO: Update constant buffers..
 	//1. Update scale-offset matrix
@@ -896,10 +900,10 @@ bool VKGSRender::load_program()
 	fill_vertex_program_constants_data(buf);
 	m_uniform_buffer->unmap();
 
-	const size_t fragment_constants_sz = m_prog_buffer.get_fragment_constants_buffer_size(fragment_program);
+	const size_t fragment_constants_sz = m_prog_buffer.get_last_fragment_constants_buffer_size();
 	const size_t fragment_constants_offset = m_uniform_buffer_ring_info.alloc<256>(fragment_constants_sz);
 	buf = (u8*)m_uniform_buffer->map(fragment_constants_offset, fragment_constants_sz);
-	m_prog_buffer.fill_fragment_constans_buffer({ reinterpret_cast<float*>(buf), gsl::narrow<int>(fragment_constants_sz) }, fragment_program);
+	m_prog_buffer.fill_last_fragment_constants_buffer({ reinterpret_cast<float*>(buf), gsl::narrow<int>(fragment_constants_sz) }, fragment_program);
 	m_uniform_buffer->unmap();
 
 	m_program->bind_uniform({ m_uniform_buffer->value, scale_offset_offset, 256 }, SCALE_OFFSET_BIND_SLOT, descriptor_sets);
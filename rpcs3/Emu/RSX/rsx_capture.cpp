@@ -0,0 +1,549 @@
+#include "stdafx.h"
+#include "rsx_capture.h"
+
+#include <zlib.h>
+
+namespace
+{
+	const u32 g_capture_magic = 0x50414352; // "RCAP"
+	const u32 g_capture_version = 1;
+
+	// Capture thread waits if more buffer data is pending
+	const u64 g_max_queued_bytes = 256 * 1024 * 1024;
+
+	// Limit of the uncompressed buffer size accepted from capture files (4096x4096 surface, 16 bytes per pixel)
+	const u32 g_max_blob_size = 4096 * 4096 * 16;
+
+	// Buffer slots compared with the previous buffer for deduplication (4 color buffers, depth, stencil, index)
+	const u32 g_slot_count = 7;
+
+	// The capture file consists of the header (magic, version) and chunks (type, size, data)
+	enum class chunk_type : u32
+	{
+		blob = 1, // u32 id, u32 raw size, zlib stream
+		alias = 2, // u32 id, u32 id of the blob with the same data
+		draw = 3, // draw state
+		commands = 4, // command queue (u32 register, u32 value)
+	};
+
+	struct chunk_header
+	{
+		chunk_type type;
+		u32 size;
+	};
+
+	template<typename T>
+	void append(std::vector<gsl::byte>& out, const T& value)
+	{
+		const auto ptr = reinterpret_cast<const gsl::byte*>(&value);
+		out.insert(out.end(), ptr, ptr + sizeof(T));
+	}
+
+	void append(std::vector<gsl::byte>& out, const std::string& str)
+	{
+		append<u32>(out, size32(str));
+		out.insert(out.end(), reinterpret_cast<const gsl::byte*>(str.data()), reinterpret_cast<const gsl::byte*>(str.data() + str.size()));
+	}
+
+	struct chunk_reader
+	{
+		const std::vector<gsl::byte>& data;
+		std::size_t pos;
+
+		template<typename T>
+		bool read(T& value)
+		{
+			if (data.size() - pos < sizeof(T))
+			{
+				return false;
+			}
+
+			std::memcpy(&value, data.data() + pos, sizeof(T));
+			pos += sizeof(T);
+			return true;
+		}
+
+		bool read(std::string& str)
+		{
+			u32 size;
+
+			if (!read(size) || data.size() - pos < size)
+			{
+				return false;
+			}
+
+			str.assign(reinterpret_cast<const char*>(data.data() + pos), size);
+			pos += size;
+			return true;
+		}
+	};
+
+	std::vector<gsl::byte> serialize(const frame_capture_data::draw_state& state)
+	{
+		std::vector<gsl::byte> result;
+		append(result, state.name);
+		append(result, state.programs.first);
+		append(result, state.programs.second);
+		append<u32>(result, static_cast<u32>(state.width));
+		append<u32>(result, static_cast<u32>(state.height));
+		append(result, state.color_format);
+		append(result, state.color_buffer);
+		append(result, state.depth_format);
+		append(result, state.depth_stencil);
+		append(result, state.index_type);
+		append(result, state.index);
+		append(result, state.vertex_count);
+		return result;
+	}
+
+	bool deserialize(const std::vector<gsl::byte>& data, frame_capture_data::draw_state& state)
+	{
+		chunk_reader reader{ data, 0 };
+		u32 width, height;
+
+		if (!reader.read(state.name) || !reader.read(state.programs.first) || !reader.read(state.programs.second) ||
+			!reader.read(width) || !reader.read(height) ||
+			!reader.read(state.color_format) || !reader.read(state.color_buffer) ||
+			!reader.read(state.depth_format) || !reader.read(state.depth_stencil) ||
+			!reader.read(state.index_type) || !reader.read(state.index) || !reader.read(state.vertex_count))
+		{
+			return false;
+		}
+
+		state.width = width;
+		state.height = height;
+		return true;
+	}
+}
+
+struct frame_capture_data::impl
+{
+	struct blob_info
+	{
+		u64 offset; // zlib stream position in the file
+		u32 size; // compressed size (0 if the data is lost)
+		u32 raw_size;
+		bool ready;
+	};
+
+	struct task
+	{
+		chunk_type type;
+		blob_id id;
+		u32 slot;
+		std::vector<gsl::byte> data;
+	};
+
+	fs::file file;
+
+	std::mutex mutex;
+	std::condition_variable cv; // signaled when a task is queued or completed
+	std::vector<blob_info> blobs; // index: blob id - 1
+	std::deque<task> queue;
+	u64 queued_bytes = 0;
+	bool stop = false;
+	std::thread thread;
+
+	// Statistics
+	u32 unique_blobs = 0;
+	u64 raw_bytes = 0;
+
+	// Last buffer of every slot (only accessed by the background thread)
+	std::array<std::vector<gsl::byte>, g_slot_count> last_data;
+	std::array<blob_id, g_slot_count> last_id{};
+
+	// Append chunk to the file (mutex must be locked), return the position of chunk data
+	u64 write_chunk(chunk_type type, const std::vector<gsl::byte>& data)
+	{
+		const chunk_header header{ type, size32(data) };
+		const u64 pos = file.seek(0, fs::seek_end) + sizeof(header);
+
+		if (file.write(&header, sizeof(header)) != sizeof(header) || file.write(data.data(), data.size()) != data.size())
+		{
+			LOG_ERROR(RSX, "Frame capture: failed to write chunk (type=%d, size=0x%x)", static_cast<u32>(type), data.size());
+		}
+
+		return pos;
+	}
+
+	void write_blob(task& t)
+	{
+		auto& last = last_data[t.slot];
+
+		// Store unchanged buffer only once
+		if (last_id[t.slot] && last.size() == t.data.size() && std::memcmp(last.data(), t.data.data(), last.size()) == 0)
+		{
+			std::vector<gsl::byte> alias;
+			append(alias, t.id);
+			append(alias, last_id[t.slot]);
+
+			std::lock_guard<std::mutex> lock(mutex);
+			write_chunk(chunk_type::alias, alias);
+			blobs[t.id - 1] = blobs[last_id[t.slot] - 1];
+			return;
+		}
+
+		const u32 raw_size = size32(t.data);
+
+		std::vector<gsl::byte> data(2 * sizeof(u32) + compressBound(raw_size));
+		std::memcpy(data.data(), &t.id, sizeof(u32));
+		std::memcpy(data.data() + sizeof(u32), &raw_size, sizeof(u32));
+
+		uLongf size = static_cast<uLongf>(data.size() - 2 * sizeof(u32));
+
+		if (compress2(reinterpret_cast<Bytef*>(data.data() + 2 * sizeof(u32)), &size, reinterpret_cast<const Bytef*>(t.data.data()), raw_size, Z_BEST_SPEED) != Z_OK)
+		{
+			LOG_ERROR(RSX, "Frame capture: failed to compress buffer (size=0x%x)", raw_size);
+
+			std::lock_guard<std::mutex> lock(mutex);
+			blobs[t.id - 1] = { 0, 0, 0, true };
+			return;
+		}
+
+		data.resize(2 * sizeof(u32) + size);
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			const u64 pos = write_chunk(chunk_type::blob, data);
+			blobs[t.id - 1] = { pos + 2 * sizeof(u32), static_cast<u32>(size), raw_size, true };
+			unique_blobs++;
+			raw_bytes += raw_size;
+		}
+
+		last = std::move(t.data);
+		last_id[t.slot] = t.id;
+	}
+
+	void run()
+	{
+		while (true)
+		{
+			task t;
+
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+
+				cv.wait(lock, [&] { return !queue.empty() || stop; });
+
+				if (queue.empty())
+				{
+					return;
+				}
+
+				t = std::move(queue.front());
+				queue.pop_front();
+				queued_bytes -= t.data.size();
+			}
+
+			if (t.type == chunk_type::blob)
+			{
+				write_blob(t);
+			}
+			else
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				write_chunk(t.type, t.data);
+			}
+
+			cv.notify_all();
+		}
+	}
+
+	void push(task&& t)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+
+		// Limit the memory used by pending buffers
+		cv.wait(lock, [&] { return queued_bytes < g_max_queued_bytes || queue.empty(); });
+
+		queued_bytes += t.data.size();
+		queue.emplace_back(std::move(t));
+		lock.unlock();
+		cv.notify_all();
+	}
+
+	bool is_writing() const
+	{
+		return thread.joinable();
+	}
+};
+
+frame_capture_data::frame_capture_data() = default;
+
+frame_capture_data::~frame_capture_data()
+{
+	finish();
+}
+
+void frame_capture_data::reset(const std::string& path)
+{
+	finish();
+
+	command_queue.clear();
+	draw_calls.clear();
+
+	const std::string file_path = path.empty() ? fs::get_config_dir() + "frame_capture.rcap" : path;
+
+	m_impl = std::make_unique<impl>();
+
+	if (!m_impl->file.open(file_path, fom::read | fom::rewrite))
+	{
+		LOG_ERROR(RSX, "Frame capture: failed to create '%s' (buffers will not be captured)", file_path);
+		m_impl.reset();
+		return;
+	}
+
+	m_impl->file.write(g_capture_magic);
+	m_impl->file.write(g_capture_version);
+	m_impl->thread = std::thread([impl = m_impl.get()] { impl->run(); });
+}
+
+void frame_capture_data::add_draw_call(draw_state state, draw_buffers&& buffers)
+{
+	if (m_impl && m_impl->is_writing())
+	{
+		const auto add_blob = [&](u32 slot, std::vector<gsl::byte>& data) -> blob_id
+		{
+			if (data.empty())
+			{
+				return 0;
+			}
+
+			blob_id id;
+
+			{
+				std::lock_guard<std::mutex> lock(m_impl->mutex);
+				m_impl->blobs.push_back({});
+				id = size32(m_impl->blobs);
+			}
+
+			m_impl->push({ chunk_type::blob, id, slot, std::move(data) });
+			return id;
+		};
+
+		for (u32 i = 0; i < 4; i++)
+		{
+			state.color_buffer[i] = add_blob(i, buffers.color_buffer[i]);
+		}
+
+		for (u32 i = 0; i < 2; i++)
+		{
+			state.depth_stencil[i] = add_blob(4 + i, buffers.depth_stencil[i]);
+		}
+
+		state.index = add_blob(6, buffers.index);
+
+		m_impl->push({ chunk_type::draw, 0, 0, serialize(state) });
+	}
+	else
+	{
+		state.color_buffer = {};
+		state.depth_stencil = {};
+		state.index = 0;
+	}
+
+	draw_calls.emplace_back(std::move(state));
+}
+
+void frame_capture_data::finish()
+{
+	if (!m_impl || !m_impl->is_writing())
+	{
+		return;
+	}
+
+	std::vector<gsl::byte> commands;
+
+	for (const auto& command : command_queue)
+	{
+		append(commands, command.first);
+		append(commands, command.second);
+	}
+
+	m_impl->push({ chunk_type::commands, 0, 0, std::move(commands) });
+
+	{
+		std::lock_guard<std::mutex> lock(m_impl->mutex);
+		m_impl->stop = true;
+	}
+
+	m_impl->cv.notify_all();
+	m_impl->thread.join();
+
+	LOG_NOTICE(RSX, "Frame capture: %d draw calls, %d buffers (%d unique, %lld MB), file size %lld MB",
+		draw_calls.size(), m_impl->blobs.size(), m_impl->unique_blobs, m_impl->raw_bytes >> 20, m_impl->file.size() >> 20);
+}
+
+bool frame_capture_data::load(const std::string& path)
+{
+	finish();
+
+	command_queue.clear();
+	draw_calls.clear();
+	m_impl.reset();
+
+	auto data = std::make_unique<impl>();
+
+	if (!data->file.open(path))
+	{
+		LOG_ERROR(RSX, "Frame capture: failed to open '%s'", path);
+		return false;
+	}
+
+	u32 magic, version;
+
+	if (!data->file.read(magic) || !data->file.read(version) || magic != g_capture_magic || version != g_capture_version)
+	{
+		LOG_ERROR(RSX, "Frame capture: '%s' is not a supported capture file", path);
+		return false;
+	}
+
+	const u64 file_size = data->file.size();
+	u64 pos = data->file.seek(0, fs::seek_cur);
+
+	// Read chunk headers and small chunks, buffers are read by get_blob()
+	for (chunk_header header; pos < file_size; pos += sizeof(header) + header.size)
+	{
+		data->file.seek(pos);
+
+		if (!data->file.read(header) || file_size - pos - sizeof(header) < header.size)
+		{
+			LOG_WARNING(RSX, "Frame capture: '%s' is truncated at 0x%llx", path, pos);
+			break;
+		}
+
+		if (header.type == chunk_type::blob)
+		{
+			u32 id, raw_size;
+
+			// every buffer id has its own chunk, so valid ids can't exceed the file size
+			if (header.size < 2 * sizeof(u32) || !data->file.read(id) || !data->file.read(raw_size) || !id || id > file_size || raw_size > g_max_blob_size)
+			{
+				LOG_ERROR(RSX, "Frame capture: invalid buffer chunk at 0x%llx", pos);
+				continue;
+			}
+
+			if (data->blobs.size() < id)
+			{
+				data->blobs.resize(id, { 0, 0, 0, true });
+			}
+
+			data->blobs[id - 1] = { pos + sizeof(header) + 2 * sizeof(u32), static_cast<u32>(header.size - 2 * sizeof(u32)), raw_size, true };
+			continue;
+		}
+
+		std::vector<gsl::byte> chunk(header.size);
+
+		if (data->file.read(chunk.data(), chunk.size()) != chunk.size())
+		{
+			LOG_WARNING(RSX, "Frame capture: '%s' is truncated at 0x%llx", path, pos);
+			break;
+		}
+
+		chunk_reader reader{ chunk, 0 };
+
+		switch (header.type)
+		{
+		case chunk_type::alias:
+		{
+			u32 id, target;
+
+			if (!reader.read(id) || !reader.read(target) || !id || id > file_size || !target || target > data->blobs.size())
+			{
+				LOG_ERROR(RSX, "Frame capture: invalid alias chunk at 0x%llx", pos);
+				break;
+			}
+
+			if (data->blobs.size() < id)
+			{
+				data->blobs.resize(id, { 0, 0, 0, true });
+			}
+
+			data->blobs[id - 1] = data->blobs[target - 1];
+			break;
+		}
+
+		case chunk_type::draw:
+		{
+			draw_state state;
+
+			if (!deserialize(chunk, state))
+			{
+				LOG_ERROR(RSX, "Frame capture: invalid draw chunk at 0x%llx", pos);
+				break;
+			}
+
+			draw_calls.emplace_back(std::move(state));
+			break;
+		}
+
+		case chunk_type::commands:
+		{
+			for (std::pair<u32, u32> command; reader.read(command.first) && reader.read(command.second);)
+			{
+				command_queue.emplace_back(command);
+			}
+
+			break;
+		}
+
+		default:
+		{
+			LOG_WARNING(RSX, "Frame capture: unknown chunk type %d at 0x%llx", static_cast<u32>(header.type), pos);
+		}
+		}
+	}
+
+	m_impl = std::move(data);
+
+	LOG_NOTICE(RSX, "Frame capture: loaded '%s' (%d draw calls, %d commands)", path, draw_calls.size(), command_queue.size());
+	return true;
+}
+
+std::vector<gsl::byte> frame_capture_data::get_blob(blob_id id) const
+{
+	if (!id || !m_impl)
+	{
+		return{};
+	}
+
+	std::unique_lock<std::mutex> lock(m_impl->mutex);
+
+	if (id > m_impl->blobs.size())
+	{
+		LOG_ERROR(RSX, "Frame capture: invalid buffer id %d", id);
+		return{};
+	}
+
+	// Wait for the background thread if the capture is being written
+	m_impl->cv.wait(lock, [&] { return m_impl->blobs[id - 1].ready; });
+
+	const auto info = m_impl->blobs[id - 1];
+
+	if (!info.size)
+	{
+		return{};
+	}
+
+	std::vector<gsl::byte> packed(info.size);
+	m_impl->file.seek(info.offset);
+
+	if (m_impl->file.read(packed.data(), info.size) != info.size)
+	{
+		LOG_ERROR(RSX, "Frame capture: failed to read buffer %d", id);
+		return{};
+	}
+
+	lock.unlock();
+
+	std::vector<gsl::byte> result(info.raw_size);
+	uLongf size = info.raw_size;
+
+	if (uncompress(reinterpret_cast<Bytef*>(result.data()), &size, reinterpret_cast<const Bytef*>(packed.data()), info.size) != Z_OK || size != info.raw_size)
+	{
+		LOG_ERROR(RSX, "Frame capture: failed to decompress buffer %d", id);
+		return{};
+	}
+
+	return result;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "GCM.h"
+
+// Frame capture: buffers of captured draw calls are compressed and streamed to the capture file by a background thread,
+// unchanged buffers are stored once, and buffers are only read back from the file when requested
+struct frame_capture_data
+{
+	// Buffer stored in the capture file (0 if not captured)
+	using blob_id = u32;
+
+	struct draw_state
+	{
+		std::string name;
+		std::pair<std::string, std::string> programs;
+		size_t width = 0, height = 0;
+		rsx::surface_color_format color_format;
+		std::array<blob_id, 4> color_buffer;
+		rsx::surface_depth_format depth_format;
+		std::array<blob_id, 2> depth_stencil;
+		rsx::index_array_type index_type;
+		blob_id index;
+		u32 vertex_count;
+	};
+
+	// Buffer data of a draw call
+	struct draw_buffers
+	{
+		std::array<std::vector<gsl::byte>, 4> color_buffer;
+		std::array<std::vector<gsl::byte>, 2> depth_stencil;
+		std::vector<gsl::byte> index;
+	};
+
+	std::vector<std::pair<u32, u32> > command_queue;
+	std::vector<draw_state> draw_calls;
+
+	frame_capture_data();
+	~frame_capture_data();
+
+	// Start a new capture written to the file (default: frame_capture.rcap in config directory)
+	void reset(const std::string& path = {});
+
+	// Add draw call and queue its buffers for writing (blob ids of the state are assigned)
+	void add_draw_call(draw_state state, draw_buffers&& buffers);
+
+	// Write the command queue and wait for the background thread to complete the capture file
+	void finish();
+
+	// Open the capture file written by finish() (buffers are loaded on demand)
+	bool load(const std::string& path);
+
+	// Get buffer data (waits if it's not written yet)
+	std::vector<gsl::byte> get_blob(blob_id id) const;
+
+private:
+	struct impl;
+
+	std::unique_ptr<impl> m_impl;
+};
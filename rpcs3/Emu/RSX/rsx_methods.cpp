@@ -12,6 +12,7 @@ namespace rsx
 {
 	u32 method_registers[0x10000 >> 2];
 	rsx_method_t methods[0x10000 >> 2]{};
+	rsx_packet_method_t packet_methods[0x10000 >> 2]{};
 
 	template<typename Type> struct vertex_data_type_from_element_type;
 	template<> struct vertex_data_type_from_element_type<float> { static const vertex_base_type type = vertex_base_type::f; };
@@ -61,8 +62,8 @@ namespace rsx
 		}
 
 		//fire only when all data passed to rsx cmd buffer
-		template<u32 id, u32 index, int count, typename type>
-		force_inline void set_vertex_data_impl(thread* rsx, u32 arg)
+		template<u32 id, int count, typename type>
+		force_inline void set_vertex_data_impl(thread* rsx, u32 index)
 		{
 			static const size_t element_size = (count * sizeof(type));
 			static const size_t element_size_in_words = element_size / sizeof(u32);
@@ -90,7 +91,7 @@ namespace rsx
 		{
 			force_inline static void impl(thread* rsx, u32 arg)
 			{
-				set_vertex_data_impl<NV4097_SET_VERTEX_DATA4UB_M, index, 4, u8>(rsx, arg);
+				set_vertex_data_impl<NV4097_SET_VERTEX_DATA4UB_M, 4, u8>(rsx, index);
 			}
 		};
 
@@ -99,7 +100,7 @@ namespace rsx
 		{
 			force_inline static void impl(thread* rsx, u32 arg)
 			{
-				set_vertex_data_impl<NV4097_SET_VERTEX_DATA1F_M, index, 1, f32>(rsx, arg);
+				set_vertex_data_impl<NV4097_SET_VERTEX_DATA1F_M, 1, f32>(rsx, index);
 			}
 		};
 
@@ -108,7 +109,7 @@ namespace rsx
 		{
 			force_inline static void impl(thread* rsx, u32 arg)
 			{
-				set_vertex_data_impl<NV4097_SET_VERTEX_DATA2F_M, index, 2, f32>(rsx, arg);
+				set_vertex_data_impl<NV4097_SET_VERTEX_DATA2F_M, 2, f32>(rsx, index);
 			}
 		};
 
@@ -117,7 +118,7 @@ namespace rsx
 		{
 			force_inline static void impl(thread* rsx, u32 arg)
 			{
-				set_vertex_data_impl<NV4097_SET_VERTEX_DATA3F_M, index, 3, f32>(rsx, arg);
+				set_vertex_data_impl<NV4097_SET_VERTEX_DATA3F_M, 3, f32>(rsx, index);
 			}
 		};
 
@@ -126,7 +127,7 @@ namespace rsx
 		{
 			force_inline static void impl(thread* rsx, u32 arg)
 			{
-				set_vertex_data_impl<NV4097_SET_VERTEX_DATA4F_M, index, 4, f32>(rsx, arg);
+				set_vertex_data_impl<NV4097_SET_VERTEX_DATA4F_M, 4, f32>(rsx, index);
 			}
 		};
 
@@ -135,7 +136,7 @@ namespace rsx
 		{
 			force_inline static void impl(thread* rsx, u32 arg)
 			{
-				set_vertex_data_impl<NV4097_SET_VERTEX_DATA2S_M, index, 2, u16>(rsx, arg);
+				set_vertex_data_impl<NV4097_SET_VERTEX_DATA2S_M, 2, u16>(rsx, index);
 			}
 		};
 
@@ -144,10 +145,32 @@ namespace rsx
 		{
 			force_inline static void impl(thread* rsx, u32 arg)
 			{
-				set_vertex_data_impl<NV4097_SET_VERTEX_DATA4S_M, index, 4, u16>(rsx, arg);
+				set_vertex_data_impl<NV4097_SET_VERTEX_DATA4S_M, 4, u16>(rsx, index);
 			}
 		};
 
+		// set all attributes completely written by the packet
+		template<u32 id, int count, typename type>
+		void set_vertex_data_packet(thread* rsx, u32 reg, u32 size)
+		{
+			static const u32 element_size_in_words = count * sizeof(type) / sizeof(u32);
+
+			for (u32 index = (reg - id) / element_size_in_words; index < limits::vertex_count; index++)
+			{
+				const u32 last = id + index * element_size_in_words + element_size_in_words - 1;
+
+				if (last >= reg + size)
+				{
+					break;
+				}
+
+				if (last >= reg)
+				{
+					set_vertex_data_impl<id, count, type>(rsx, index);
+				}
+			}
+		}
+
 		template<u32 index>
 		struct set_vertex_data_array_format
 		{
@@ -201,6 +224,22 @@ namespace rsx
 			}
 		};
 
+		void set_transform_constant_packet(thread* rsx, u32 reg, u32 size)
+		{
+			const u32 load = method_registers[NV4097_SET_TRANSFORM_CONSTANT_LOAD];
+			const u32 first = reg - NV4097_SET_TRANSFORM_CONSTANT;
+
+			for (u32 i = first; i < first + size;)
+			{
+				const u32 words = std::min(4 - i % 4, first + size - i);
+
+				memcpy(rsx->transform_constants[load + i / 4].rgba + i % 4, method_registers + NV4097_SET_TRANSFORM_CONSTANT + i, words * sizeof(f32));
+				i += words;
+			}
+
+			rsx->m_transform_constants_dirty = true;
+		}
+
 		template<u32 index>
 		struct set_transform_program
 		{
@@ -212,9 +251,34 @@ namespace rsx
 				static const size_t size = count * sizeof(u32);
 
 				memcpy(rsx->transform_program + load++ * count, method_registers + NV4097_SET_TRANSFORM_PROGRAM + index * count, size);
+				rsx->m_vertex_program_dirty = true;
 			}
 		};
 
+		// copy all instructions completely written by the packet
+		void set_transform_program_packet(thread* rsx, u32 reg, u32 size)
+		{
+			u32& load = method_registers[NV4097_SET_TRANSFORM_PROGRAM_LOAD];
+
+			const u32 first = reg - NV4097_SET_TRANSFORM_PROGRAM;
+			const u32 begin = first / 4;
+			const u32 end = (first + size) / 4;
+
+			if (begin >= end)
+			{
+				return;
+			}
+
+			if (load + (end - begin) > 512)
+			{
+				throw EXCEPTION("Transform program overflow (load=%d, count=%d)", load, end - begin);
+			}
+
+			memcpy(rsx->transform_program + load * 4, method_registers + NV4097_SET_TRANSFORM_PROGRAM + begin * 4, (end - begin) * 4 * sizeof(u32));
+			load += end - begin;
+			rsx->m_vertex_program_dirty = true;
+		}
+
 		force_inline void set_begin_end(thread* rsx, u32 arg)
 		{
 			if (arg)
@@ -289,6 +353,16 @@ namespace rsx
 			rsx->m_rtts_dirty = true;
 		}
 
+		force_inline void set_vertex_program_dirty_bit(thread* rsx, u32)
+		{
+			rsx->m_vertex_program_dirty = true;
+		}
+
+		force_inline void set_fragment_program_dirty_bit(thread* rsx, u32)
+		{
+			rsx->m_fragment_program_dirty = true;
+		}
+
 		template<u32 index>
 		struct set_texture_dirty_bit
 		{
@@ -643,6 +717,8 @@ namespace rsx
 		}
 		else if (rsx->capture_current_frame)
 		{
+			// the flag is cleared after the capture file is complete, frame_debug can't be loaded before
+			frame_debug.finish();
 			rsx->capture_current_frame = false;
 			Emu.Pause();
 		}
@@ -794,6 +870,21 @@ namespace rsx
 		//do not try process on gpu
 		template<int id, rsx_method_t impl_func = nullptr> static void bind_cpu_only() { bind_cpu_only_impl<id, rsx_method_t, impl_func>(); }
 
+		//process packets writing the registers [id, id + count) at once, on cpu only (methods[] are still used for non-incrementing packets)
+		template<int id, int count, rsx_packet_func_t impl_func>
+		static void bind_packet()
+		{
+			for (u32 i = id; i < id + count; i++)
+			{
+				if (packet_methods[i].func)
+				{
+					bind_redefinition_error(i);
+				}
+
+				packet_methods[i] = { impl_func, id + count };
+			}
+		}
+
 		__rsx_methods_t()
 		{
 			// NV406E
@@ -829,6 +920,18 @@ namespace rsx
 			bind_range<NV4097_SET_VERTEX_DATA4S_M + 1, 2, 16, nv4097::set_vertex_data4s_m>();
 			bind_range<NV4097_SET_TRANSFORM_CONSTANT, 1, 32, nv4097::set_transform_constant>();
 			bind_range<NV4097_SET_TRANSFORM_PROGRAM + 3, 4, 128, nv4097::set_transform_program>();
+			bind_packet<NV4097_SET_VERTEX_DATA4UB_M, 16, nv4097::set_vertex_data_packet<NV4097_SET_VERTEX_DATA4UB_M, 4, u8>>();
+			bind_packet<NV4097_SET_VERTEX_DATA1F_M, 16, nv4097::set_vertex_data_packet<NV4097_SET_VERTEX_DATA1F_M, 1, f32>>();
+			bind_packet<NV4097_SET_VERTEX_DATA2F_M, 32, nv4097::set_vertex_data_packet<NV4097_SET_VERTEX_DATA2F_M, 2, f32>>();
+			bind_packet<NV4097_SET_VERTEX_DATA3F_M, 48, nv4097::set_vertex_data_packet<NV4097_SET_VERTEX_DATA3F_M, 3, f32>>();
+			bind_packet<NV4097_SET_VERTEX_DATA4F_M, 64, nv4097::set_vertex_data_packet<NV4097_SET_VERTEX_DATA4F_M, 4, f32>>();
+			bind_packet<NV4097_SET_VERTEX_DATA2S_M, 16, nv4097::set_vertex_data_packet<NV4097_SET_VERTEX_DATA2S_M, 2, u16>>();
+			bind_packet<NV4097_SET_VERTEX_DATA4S_M, 32, nv4097::set_vertex_data_packet<NV4097_SET_VERTEX_DATA4S_M, 4, u16>>();
+			bind_packet<NV4097_SET_TRANSFORM_CONSTANT, 32, nv4097::set_transform_constant_packet>();
+			bind_packet<NV4097_SET_TRANSFORM_PROGRAM, 512, nv4097::set_transform_program_packet>();
+			bind<NV4097_SET_TRANSFORM_PROGRAM_START, nv4097::set_vertex_program_dirty_bit>();
+			bind<NV4097_SET_SHADER_PROGRAM, nv4097::set_fragment_program_dirty_bit>();
+			bind<NV4097_SET_SHADER_CONTROL, nv4097::set_fragment_program_dirty_bit>();
 			bind_cpu_only<NV4097_GET_REPORT, nv4097::get_report>();
 			bind_cpu_only<NV4097_CLEAR_REPORT_VALUE, nv4097::clear_report_value>();
 			bind<NV4097_SET_SURFACE_CLIP_HORIZONTAL, nv4097::set_surface_dirty_bit>();
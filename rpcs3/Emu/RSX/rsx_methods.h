@@ -64,6 +64,16 @@ namespace rsx
 	};
 
 	using rsx_method_t = void(*)(class thread*, u32);
+	using rsx_packet_func_t = void(*)(class thread*, u32 reg, u32 count);
+
+	// Handler of a register group, called once for all registers of the group written by an incrementing packet
+	struct rsx_packet_method_t
+	{
+		rsx_packet_func_t func;
+		u32 end; // first register after the group
+	};
+
 	extern u32 method_registers[0x10000 >> 2];
 	extern rsx_method_t methods[0x10000 >> 2];
+	extern rsx_packet_method_t packet_methods[0x10000 >> 2];
 }
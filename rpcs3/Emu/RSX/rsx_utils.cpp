@@ -6,8 +6,312 @@ extern "C"
 #include "libswscale/swscale.h"
 }
 
+namespace
+{
+	// Offsets (in texels) of every column and row of a swizzled image: offset(x, y) = x_offsets[x] + y_offsets[y]
+	void get_swizzle_offsets(u32* x_offsets, u32* y_offsets, u16 width, u16 height)
+	{
+		u16 log2width = gsl::narrow<u16>(ceil(log2(width)));
+		u16 log2height = gsl::narrow<u16>(ceil(log2(height)));
+
+		// Max mask possible for square texture
+		u32 x_mask = 0x55555555;
+		u32 y_mask = 0xAAAAAAAA;
+
+		// We have to limit the masks to the lower of the two dimensions to allow for non-square textures
+		u32 limit_mask = (log2width < log2height) ? log2width : log2height;
+		// double the limit mask to account for bits in both x and y
+		limit_mask = 1 << (limit_mask << 1);
+
+		//x_mask, bits above limit are 1's for x-carry
+		x_mask = (x_mask | ~(limit_mask - 1));
+		//y_mask. bits above limit are 0'd, as we use a different method for y-carry over
+		y_mask = (y_mask & (limit_mask - 1));
+
+		u32 offs_x = 0;
+
+		for (u32 x = 0; x < width; ++x)
+		{
+			x_offsets[x] = offs_x;
+			offs_x = (offs_x - x_mask) & x_mask;
+		}
+
+		u32 offs_y = 0;
+		u32 offs_x0 = 0; //total y-carry offset for x
+		u32 y_incr = limit_mask;
+
+		for (u32 y = 0; y < height; ++y)
+		{
+			y_offsets[y] = offs_y + offs_x0;
+			offs_y = (offs_y - y_mask) & y_mask;
+
+			if (offs_y == 0)
+			{
+				offs_x0 += y_incr;
+			}
+		}
+	}
+
+	/**
+	* SIMD kernels for two rows of a swizzled image. When both dimensions are >= 2, texels (x, y), (x + 1, y), (x, y + 1), (x + 1, y + 1)
+	* are stored contiguously for even x and y (2x2 block at x_offsets[x] + y_offsets[y]).
+	* They return the number of processed columns, the remaining ones are copied block by block.
+	*/
+	template<u32 N>
+	struct swizzle_block_rows
+	{
+		static u32 unswizzle(const u8* src, u8* dst0, u8* dst1, const u32* x_offsets, u16 width)
+		{
+			return 0;
+		}
+
+		static u32 swizzle(const u8* src0, const u8* src1, u8* dst, const u32* x_offsets, u16 width)
+		{
+			return 0;
+		}
+	};
+
+	template<>
+	struct swizzle_block_rows<1>
+	{
+		static u32 unswizzle(const u8* src, u8* dst0, u8* dst1, const u32* x_offsets, u16 width)
+		{
+			u32 x = 0;
+
+			for (; x + 8 <= width; x += 8)
+			{
+				// 4 blocks of 2x2 bytes
+				const __m128i ab = _mm_unpacklo_epi32(_mm_cvtsi32_si128(*(const s32*)(src + x_offsets[x + 0])), _mm_cvtsi32_si128(*(const s32*)(src + x_offsets[x + 2])));
+				const __m128i cd = _mm_unpacklo_epi32(_mm_cvtsi32_si128(*(const s32*)(src + x_offsets[x + 4])), _mm_cvtsi32_si128(*(const s32*)(src + x_offsets[x + 6])));
+
+				__m128i v = _mm_unpacklo_epi64(ab, cd);
+				v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(3, 1, 2, 0));
+				v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(3, 1, 2, 0));
+				v = _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 1, 2, 0));
+
+				_mm_storel_epi64((__m128i*)(dst0 + x), v);
+				_mm_storel_epi64((__m128i*)(dst1 + x), _mm_unpackhi_epi64(v, v));
+			}
+
+			return x;
+		}
+
+		static u32 swizzle(const u8* src0, const u8* src1, u8* dst, const u32* x_offsets, u16 width)
+		{
+			u32 x = 0;
+
+			for (; x + 8 <= width; x += 8)
+			{
+				const __m128i v = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)(src0 + x)), _mm_loadl_epi64((const __m128i*)(src1 + x)));
+
+				*(s32*)(dst + x_offsets[x + 0]) = _mm_cvtsi128_si32(v);
+				*(s32*)(dst + x_offsets[x + 2]) = _mm_cvtsi128_si32(_mm_srli_si128(v, 4));
+				*(s32*)(dst + x_offsets[x + 4]) = _mm_cvtsi128_si32(_mm_srli_si128(v, 8));
+				*(s32*)(dst + x_offsets[x + 6]) = _mm_cvtsi128_si32(_mm_srli_si128(v, 12));
+			}
+
+			return x;
+		}
+	};
+
+	template<>
+	struct swizzle_block_rows<2>
+	{
+		static u32 unswizzle(const u8* src, u8* dst0, u8* dst1, const u32* x_offsets, u16 width)
+		{
+			u32 x = 0;
+
+			for (; x + 8 <= width; x += 8)
+			{
+				// 4 blocks of 2x2 texels, block rows are dwords
+				__m128i v0 = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)(src + x_offsets[x + 0] * 2)), _mm_loadl_epi64((const __m128i*)(src + x_offsets[x + 2] * 2)));
+				__m128i v1 = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i*)(src + x_offsets[x + 4] * 2)), _mm_loadl_epi64((const __m128i*)(src + x_offsets[x + 6] * 2)));
+				v0 = _mm_shuffle_epi32(v0, _MM_SHUFFLE(3, 1, 2, 0));
+				v1 = _mm_shuffle_epi32(v1, _MM_SHUFFLE(3, 1, 2, 0));
+
+				_mm_storeu_si128((__m128i*)(dst0 + x * 2), _mm_unpacklo_epi64(v0, v1));
+				_mm_storeu_si128((__m128i*)(dst1 + x * 2), _mm_unpackhi_epi64(v0, v1));
+			}
+
+			return x;
+		}
+
+		static u32 swizzle(const u8* src0, const u8* src1, u8* dst, const u32* x_offsets, u16 width)
+		{
+			u32 x = 0;
+
+			for (; x + 8 <= width; x += 8)
+			{
+				const __m128i r0 = _mm_loadu_si128((const __m128i*)(src0 + x * 2));
+				const __m128i r1 = _mm_loadu_si128((const __m128i*)(src1 + x * 2));
+				const __m128i lo = _mm_unpacklo_epi32(r0, r1);
+				const __m128i hi = _mm_unpackhi_epi32(r0, r1);
+
+				_mm_storel_epi64((__m128i*)(dst + x_offsets[x + 0] * 2), lo);
+				_mm_storel_epi64((__m128i*)(dst + x_offsets[x + 2] * 2), _mm_unpackhi_epi64(lo, lo));
+				_mm_storel_epi64((__m128i*)(dst + x_offsets[x + 4] * 2), hi);
+				_mm_storel_epi64((__m128i*)(dst + x_offsets[x + 6] * 2), _mm_unpackhi_epi64(hi, hi));
+			}
+
+			return x;
+		}
+	};
+
+	template<>
+	struct swizzle_block_rows<4>
+	{
+		static u32 unswizzle(const u8* src, u8* dst0, u8* dst1, const u32* x_offsets, u16 width)
+		{
+			u32 x = 0;
+
+			for (; x + 4 <= width; x += 4)
+			{
+				const __m128i a = _mm_loadu_si128((const __m128i*)(src + x_offsets[x + 0] * 4));
+				const __m128i b = _mm_loadu_si128((const __m128i*)(src + x_offsets[x + 2] * 4));
+
+				_mm_storeu_si128((__m128i*)(dst0 + x * 4), _mm_unpacklo_epi64(a, b));
+				_mm_storeu_si128((__m128i*)(dst1 + x * 4), _mm_unpackhi_epi64(a, b));
+			}
+
+			return x;
+		}
+
+		static u32 swizzle(const u8* src0, const u8* src1, u8* dst, const u32* x_offsets, u16 width)
+		{
+			u32 x = 0;
+
+			for (; x + 4 <= width; x += 4)
+			{
+				const __m128i r0 = _mm_loadu_si128((const __m128i*)(src0 + x * 4));
+				const __m128i r1 = _mm_loadu_si128((const __m128i*)(src1 + x * 4));
+
+				_mm_storeu_si128((__m128i*)(dst + x_offsets[x + 0] * 4), _mm_unpacklo_epi64(r0, r1));
+				_mm_storeu_si128((__m128i*)(dst + x_offsets[x + 2] * 4), _mm_unpackhi_epi64(r0, r1));
+			}
+
+			return x;
+		}
+	};
+
+	template<u32 N>
+	void convert_linear_swizzle_impl(const u8* input, u8* output, const u32* x_offsets, const u32* y_offsets, u16 width, u16 height, u32 pitch, bool input_is_swizzled)
+	{
+		u32 y = 0;
+
+		// two rows at once (2x2 blocks)
+		if (width >= 2 && width % 2 == 0)
+		{
+			for (; y + 2 <= height; y += 2)
+			{
+				if (input_is_swizzled)
+				{
+					const u8* src = input + y_offsets[y] * N;
+					u8* dst0 = output + y * pitch;
+					u8* dst1 = dst0 + pitch;
+
+					for (u32 x = swizzle_block_rows<N>::unswizzle(src, dst0, dst1, x_offsets, width); x < width; x += 2)
+					{
+						const u8* block = src + x_offsets[x] * N;
+						std::memcpy(dst0 + x * N, block, N * 2);
+						std::memcpy(dst1 + x * N, block + N * 2, N * 2);
+					}
+				}
+				else
+				{
+					const u8* src0 = input + y * pitch;
+					const u8* src1 = src0 + pitch;
+					u8* dst = output + y_offsets[y] * N;
+
+					for (u32 x = swizzle_block_rows<N>::swizzle(src0, src1, dst, x_offsets, width); x < width; x += 2)
+					{
+						u8* block = dst + x_offsets[x] * N;
+						std::memcpy(block, src0 + x * N, N * 2);
+						std::memcpy(block + N * 2, src1 + x * N, N * 2);
+					}
+				}
+			}
+		}
+
+		for (; y < height; ++y)
+		{
+			for (u32 x = 0; x < width; ++x)
+			{
+				if (input_is_swizzled)
+					std::memcpy(output + y * pitch + x * N, input + (y_offsets[y] + x_offsets[x]) * N, N);
+				else
+					std::memcpy(output + (y_offsets[y] + x_offsets[x]) * N, input + y * pitch + x * N, N);
+			}
+		}
+	}
+
+	template<u32 N>
+	void copy_byteswapped_impl(u8* dst, const u8* src, u32 count, __m128i mask)
+	{
+		u32 i = 0;
+
+		for (; i + 16 / N <= count; i += 16 / N)
+		{
+			_mm_storeu_si128((__m128i*)(dst + i * N), _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + i * N)), mask));
+		}
+
+		for (; i < count; ++i)
+		{
+			u8 tmp[N];
+
+			for (u32 j = 0; j < N; ++j)
+			{
+				tmp[j] = src[i * N + N - 1 - j];
+			}
+
+			std::memcpy(dst + i * N, tmp, N);
+		}
+	}
+}
+
 namespace rsx
 {
+	void convert_linear_swizzle(const void* input_pixels, void* output_pixels, u32 texel_size, u16 width, u16 height, u32 linear_pitch, bool input_is_swizzled)
+	{
+		if (!width || !height)
+		{
+			return;
+		}
+
+		std::unique_ptr<u32[]> x_offsets(new u32[width]);
+		std::unique_ptr<u32[]> y_offsets(new u32[height]);
+		get_swizzle_offsets(x_offsets.get(), y_offsets.get(), width, height);
+
+		const u8* input = static_cast<const u8*>(input_pixels);
+		u8* output = static_cast<u8*>(output_pixels);
+		const u32 pitch = linear_pitch * texel_size;
+
+		switch (texel_size)
+		{
+		case 1: return convert_linear_swizzle_impl<1>(input, output, x_offsets.get(), y_offsets.get(), width, height, pitch, input_is_swizzled);
+		case 2: return convert_linear_swizzle_impl<2>(input, output, x_offsets.get(), y_offsets.get(), width, height, pitch, input_is_swizzled);
+		case 4: return convert_linear_swizzle_impl<4>(input, output, x_offsets.get(), y_offsets.get(), width, height, pitch, input_is_swizzled);
+		case 8: return convert_linear_swizzle_impl<8>(input, output, x_offsets.get(), y_offsets.get(), width, height, pitch, input_is_swizzled);
+		case 16: return convert_linear_swizzle_impl<16>(input, output, x_offsets.get(), y_offsets.get(), width, height, pitch, input_is_swizzled);
+		}
+
+		throw EXCEPTION("Unsupported texel size (%d)", texel_size);
+	}
+
+	void copy_byteswapped(void* dst, const void* src, u32 element_size, u32 count)
+	{
+		u8* d = static_cast<u8*>(dst);
+		const u8* s = static_cast<const u8*>(src);
+
+		switch (element_size)
+		{
+		case 2: return copy_byteswapped_impl<2>(d, s, count, _mm_set_epi8(14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1));
+		case 4: return copy_byteswapped_impl<4>(d, s, count, _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3));
+		case 8: return copy_byteswapped_impl<8>(d, s, count, _mm_set_epi8(8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7));
+		}
+
+		throw EXCEPTION("Unsupported element size (%d)", element_size);
+	}
+
 	void convert_scale_image(u8 *dst, AVPixelFormat dst_format, int dst_width, int dst_height, int dst_pitch,
 		const u8 *src, AVPixelFormat src_format, int src_width, int src_height, int src_pitch, int src_slice_h, bool bilinear)
 	{
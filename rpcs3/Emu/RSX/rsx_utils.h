@@ -27,79 +27,22 @@ namespace rsx
 	/*   Note: What the ps3 calls swizzling in this case is actually z-ordering / morton ordering of pixels
 	*       - Input can be swizzled or linear, bool flag handles conversion to and from
 	*       - It will handle any width and height that are a power of 2, square or non square
+	*       - Texel size can be 1, 2, 4, 8 or 16 bytes, linear_pitch is the row pitch of the linear image in texels
 	*	 Restriction: It has mixed results if the height or width is not a power of 2
 	*/
+	void convert_linear_swizzle(const void* input_pixels, void* output_pixels, u32 texel_size, u16 width, u16 height, u32 linear_pitch, bool input_is_swizzled);
+
 	template<typename T>
-	void convert_linear_swizzle(void* input_pixels, void* output_pixels, u16 width, u16 height, bool input_is_swizzled)
+	void convert_linear_swizzle(void* input_pixels, void* output_pixels, u16 width, u16 height, bool input_is_swizzled, u32 linear_pitch = 0)
 	{
-		u16 log2width = gsl::narrow<u16>(ceil(log2(width)));
-		u16 log2height = gsl::narrow<u16>(ceil(log2(height)));
-
-		// Max mask possible for square texture
-		u32 x_mask = 0x55555555;
-		u32 y_mask = 0xAAAAAAAA;
-
-		// We have to limit the masks to the lower of the two dimensions to allow for non-square textures
-		u32 limit_mask = (log2width < log2height) ? log2width : log2height;
-		// double the limit mask to account for bits in both x and y
-		limit_mask = 1 << (limit_mask << 1);
-
-		//x_mask, bits above limit are 1's for x-carry
-		x_mask = (x_mask | ~(limit_mask - 1));
-		//y_mask. bits above limit are 0'd, as we use a different method for y-carry over
-		y_mask = (y_mask & (limit_mask - 1));
-
-		u32 offs_y = 0;
-		u32 offs_x = 0;
-		u32 offs_x0 = 0; //total y-carry offset for x
-		u32 y_incr = limit_mask;
-
-		if (!input_is_swizzled)
-		{
-			for (int y = 0; y < height; ++y)
-			{
-				T *src = static_cast<T*>(input_pixels) + y * width;
-				T *dst = static_cast<T*>(output_pixels) + offs_y;
-				offs_x = offs_x0;
-
-				for (int x = 0; x < width; ++x)
-				{
-					dst[offs_x] = src[x];
-					offs_x = (offs_x - x_mask) & x_mask;
-				}
-
-				offs_y = (offs_y - y_mask) & y_mask;
-
-				if (offs_y == 0)
-				{
-					offs_x0 += y_incr;
-				}
-			}
-		}
-		else
-		{
-			for (int y = 0; y < height; ++y)
-			{
-				T *src = static_cast<T*>(input_pixels) + offs_y;
-				T *dst = static_cast<T*>(output_pixels) + y * width;
-				offs_x = offs_x0;
-
-				for (int x = 0; x < width; ++x)
-				{
-					dst[x] = src[offs_x];
-					offs_x = (offs_x - x_mask) & x_mask;
-				}
-
-				offs_y = (offs_y - y_mask) & y_mask;
-
-				if (offs_y == 0)
-				{
-					offs_x0 += y_incr;
-				}
-			}
-		}
+		convert_linear_swizzle(input_pixels, output_pixels, sizeof(T), width, height, linear_pitch ? linear_pitch : width, input_is_swizzled);
 	}
 
+	/**
+	* Copy count elements swapping bytes of each one (element size is 2, 4 or 8 bytes)
+	*/
+	void copy_byteswapped(void* dst, const void* src, u32 element_size, u32 count);
+
 	void convert_scale_image(u8 *dst, AVPixelFormat dst_format, int dst_width, int dst_height, int dst_pitch,
 		const u8 *src, AVPixelFormat src_format, int src_width, int src_height, int src_pitch, int src_slice_h, bool bilinear);
 
@@ -2,6 +2,7 @@
 #include "Emu/Memory/Memory.h"
 #include "Emu/System.h"
 #include "Emu/state.h"
+#include "Emu/perf.h"
 #include "Emu/SysCalls/Modules.h"
 #include "Emu/SysCalls/SysCalls.h"
 #include "Crypto/sha1.h"
@@ -162,6 +163,8 @@ void execute_ppu_func_by_index(PPUThread& ppu, u32 index)
 		// change current syscall/NID value
 		ppu.hle_code = func->id;
 
+		perf::scope perf_scope(perf::counter::hle_call, func->id);
+
 		if (func->lle_func && !(func->flags & MFF_FORCED_HLE))
 		{
 			// call LLE function if available
@@ -11,6 +11,8 @@
 #include "Emu/Event.h"
 #include "Emu/Audio/AudioManager.h"
 #include "Emu/Audio/AudioDumper.h"
+#include "Emu/Audio/AudioMixer.h"
+#include "Emu/Audio/AudioRing.h"
 
 #include "cellAudio.h"
 
@@ -66,26 +68,30 @@ s32 cellAudioInit()
 
 		static const size_t out_buffer_size = 8 * BUFFER_SIZE; // output buffer for 8 channels
 
-		std::unique_ptr<float[]> out_buffer[BUFFER_NUM];
+		// mixing period: 5,(3) ms (or 256/48000 sec)
+		static const auto period = std::chrono::microseconds(AUDIO_SAMPLES * 1000000 / 48000);
 
-		for (u32 i = 0; i < BUFFER_NUM; i++)
-		{
-			out_buffer[i].reset(new float[out_buffer_size] {});
-		}
+		// blocks queued between the mixer and the backend
+		audio_ring_t out_ring(out_buffer_size, std::max<u32>(2, std::min<u32>(rpcs3::config.audio.buffer_count.value(), BUFFER_NUM)));
 
-		squeue_t<float*, BUFFER_NUM - 1> out_queue;
-
-		scope_thread_t iat(PURE_EXPR("Internal Audio Thread"s), [&out_queue]()
+		scope_thread_t iat(PURE_EXPR("Internal Audio Thread"s), [&out_ring]()
 		{
 			const bool use_u16 = rpcs3::config.audio.convert_to_u16.value();
 
 			Emu.GetAudioManager().GetAudioOut().Init();
 
 			bool opened = false;
-			float* buffer;
 
-			while (out_queue.pop(buffer, [](){ return g_audio.state != AUDIO_STATE_INITIALIZED; }))
+			while (g_audio.state == AUDIO_STATE_INITIALIZED && !Emu.IsStopped())
 			{
+				const float* buffer = out_ring.get_read_block();
+
+				if (!buffer)
+				{
+					out_ring.wait(period);
+					continue;
+				}
+
 				if (use_u16)
 				{
 					// convert the data from float to u16 with clipping:
@@ -104,6 +110,8 @@ s32 cellAudioInit()
 							_mm_cvtps_epi32(_mm_mul_ps(_mm_load_ps(buffer + i + 4), scale)));
 					}
 
+					out_ring.commit_read();
+
 					if (!opened)
 					{
 						Emu.GetAudioManager().GetAudioOut().Open(buf_u16, out_buffer_size * sizeof(u16));
@@ -125,6 +133,8 @@ s32 cellAudioInit()
 					{
 						Emu.GetAudioManager().GetAudioOut().AddData(buffer, out_buffer_size * sizeof(float));
 					}
+
+					out_ring.commit_read();
 				}
 			}
 
@@ -135,7 +145,7 @@ s32 cellAudioInit()
 		{
 			if (Emu.IsPaused())
 			{
-				std::this_thread::sleep_for(1ms); // hack
+				std::this_thread::sleep_for(period);
 				continue;
 			}
 
@@ -145,11 +155,11 @@ s32 cellAudioInit()
 
 			// TODO: send beforemix event (in ~2,6 ms before mixing)
 
-			// precise time of sleeping: 5,(3) ms (or 256/48000 sec)
+			// sleep until the start of the next period
 			const u64 expected_time = g_audio.counter * AUDIO_SAMPLES * 1000000 / 48000;
 			if (expected_time >= time_pos)
 			{
-				std::this_thread::sleep_for(1ms); // hack
+				std::this_thread::sleep_for(std::chrono::microseconds(expected_time - time_pos + 1));
 				continue;
 			}
 			
@@ -163,8 +173,6 @@ s32 cellAudioInit()
 
 			g_audio.counter++;
 
-			const u32 out_pos = g_audio.counter % BUFFER_NUM;
-
 			bool first_mix = true;
 
 			// mixing:
@@ -178,9 +186,6 @@ s32 cellAudioInit()
 
 				auto buf = vm::_ptr<f32>(buf_addr);
 
-				static const float k = 1.0f; // may be 1.0f
-				const float& m = port.level;
-
 				auto step_volume = [](AudioPortConfig& port) // part of cellAudioSetPortLevel functionality
 				{
 					const auto param = port.level_set.load();
@@ -198,146 +203,50 @@ s32 cellAudioInit()
 					}
 				};
 
-				if (port.channel == 2)
+				if (port.channel != 2 && port.channel != 8)
 				{
-					if (first_mix)
-					{
-						for (u32 i = 0; i < (sizeof(buf2ch) / sizeof(float)); i += 2)
-						{
-							step_volume(port);
-
-							// reverse byte order
-							const float left = buf[i + 0] * m;
-							const float right = buf[i + 1] * m;
-
-							buf2ch[i + 0] = left;
-							buf2ch[i + 1] = right;
-
-							buf8ch[i * 4 + 0] = left;
-							buf8ch[i * 4 + 1] = right;
-							buf8ch[i * 4 + 2] = 0.0f;
-							buf8ch[i * 4 + 3] = 0.0f;
-							buf8ch[i * 4 + 4] = 0.0f;
-							buf8ch[i * 4 + 5] = 0.0f;
-							buf8ch[i * 4 + 6] = 0.0f;
-							buf8ch[i * 4 + 7] = 0.0f;
-						}
-						first_mix = false;
-					}
-					else
-					{
-						for (u32 i = 0; i < (sizeof(buf2ch) / sizeof(float)); i += 2)
-						{
-							step_volume(port);
+					throw EXCEPTION("Unknown channel count (port=%lld, channel=%d)", &port - g_audio.ports, port.channel);
+				}
 
-							const float left = buf[i + 0] * m;
-							const float right = buf[i + 1] * m;
+				if (first_mix)
+				{
+					memset(buf8ch, 0, sizeof(buf8ch));
+					first_mix = false;
+				}
 
-							buf2ch[i + 0] += left;
-							buf2ch[i + 1] += right;
+				// volume ramp is only evaluated per sample while cellAudioSetPortLevel transition is active
+				float volume[BUFFER_SIZE];
+				const float* ramp = nullptr;
 
-							buf8ch[i * 4 + 0] += left;
-							buf8ch[i * 4 + 1] += right;
-						}
-					}
-				}
-				else if (port.channel == 8)
+				if (port.level_set.load().inc != 0.0f)
 				{
-					if (first_mix)
+					for (u32 i = 0; i < BUFFER_SIZE; i++)
 					{
-						for (u32 i = 0; i < (sizeof(buf2ch) / sizeof(float)); i += 2)
-						{
-							step_volume(port);
-
-							const float left = buf[i * 4 + 0] * m;
-							const float right = buf[i * 4 + 1] * m;
-							const float center = buf[i * 4 + 2] * m;
-							const float low_freq = buf[i * 4 + 3] * m;
-							const float rear_left = buf[i * 4 + 4] * m;
-							const float rear_right = buf[i * 4 + 5] * m;
-							const float side_left = buf[i * 4 + 6] * m;
-							const float side_right = buf[i * 4 + 7] * m;
-
-							const float mid = (center + low_freq) * 0.708f;
-							buf2ch[i + 0] = (left + rear_left + side_left + mid) * k;
-							buf2ch[i + 1] = (right + rear_right + side_right + mid) * k;
-
-							buf8ch[i * 4 + 0] = left;
-							buf8ch[i * 4 + 1] = right;
-							buf8ch[i * 4 + 2] = center;
-							buf8ch[i * 4 + 3] = low_freq;
-							buf8ch[i * 4 + 4] = rear_left;
-							buf8ch[i * 4 + 5] = rear_right;
-							buf8ch[i * 4 + 6] = side_left;
-							buf8ch[i * 4 + 7] = side_right;
-						}
-						first_mix = false;
-					}
-					else
-					{
-						for (u32 i = 0; i < (sizeof(buf2ch) / sizeof(float)); i += 2)
-						{
-							step_volume(port);
-
-							const float left = buf[i * 4 + 0] * m;
-							const float right = buf[i * 4 + 1] * m;
-							const float center = buf[i * 4 + 2] * m;
-							const float low_freq = buf[i * 4 + 3] * m;
-							const float rear_left = buf[i * 4 + 4] * m;
-							const float rear_right = buf[i * 4 + 5] * m;
-							const float side_left = buf[i * 4 + 6] * m;
-							const float side_right = buf[i * 4 + 7] * m;
-
-							const float mid = (center + low_freq) * 0.708f;
-							buf2ch[i + 0] += (left + rear_left + side_left + mid) * k;
-							buf2ch[i + 1] += (right + rear_right + side_right + mid) * k;
-
-							buf8ch[i * 4 + 0] += left;
-							buf8ch[i * 4 + 1] += right;
-							buf8ch[i * 4 + 2] += center;
-							buf8ch[i * 4 + 3] += low_freq;
-							buf8ch[i * 4 + 4] += rear_left;
-							buf8ch[i * 4 + 5] += rear_right;
-							buf8ch[i * 4 + 6] += side_left;
-							buf8ch[i * 4 + 7] += side_right;
-						}
+						step_volume(port);
+						volume[i] = port.level;
 					}
-				}
-				else
-				{
-					throw EXCEPTION("Unknown channel count (port=%lld, channel=%d)", &port - g_audio.ports, port.channel);
+
+					ramp = volume;
 				}
 
+				audio_mixer::mix_to_8ch(buf8ch, buf, port.channel, BUFFER_SIZE, ramp, port.level);
+
 				memset(buf, 0, block_size * sizeof(float));
 			}
 
 
-			if (!first_mix)
+			if (first_mix)
 			{
-				// copy output data (2 ch)
-				//for (u32 i = 0; i < (sizeof(buf2ch) / sizeof(float)); i++)
-				//{
-				//	out_buffer[out_pos][i] = buf2ch[i];
-				//}
-
-				// copy output data (8 ch)
-				for (u32 i = 0; i < (sizeof(buf8ch) / sizeof(float)); i++)
-				{
-					out_buffer[out_pos][i] = buf8ch[i];
-				}
+				memset(buf8ch, 0, sizeof(buf8ch));
 			}
 
 			//const u64 stamp1 = get_system_time();
 
-			if (first_mix)
-			{
-				memset(out_buffer[out_pos].get(), 0, out_buffer_size * sizeof(float));
-			}
-
-			if (!out_queue.push(out_buffer[out_pos].get(), [](){ return g_audio.state != AUDIO_STATE_INITIALIZED; }))
+			// pass output data (8 ch) to the backend, the mixer waits while the ring is full (the block is dropped if the backend is stuck)
+			out_ring.push(buf8ch, period * 16, []()
 			{
-				break;
-			}
+				return g_audio.state != AUDIO_STATE_INITIALIZED || Emu.IsStopped();
+			});
 
 			//const u64 stamp2 = get_system_time();
 
@@ -371,6 +280,8 @@ s32 cellAudioInit()
 						queue->push(lv2_lock, 0, 0, 0, 0); // TODO: check arguments
 					}
 				}
+
+				g_audio.cv.notify_all();
 			}
 			
 
@@ -387,6 +298,8 @@ s32 cellAudioInit()
 				}
 				else if (m_dump.GetCh() == 2)
 				{
+					audio_mixer::downmix_8ch_to_2ch(buf2ch, buf8ch, BUFFER_SIZE);
+
 					if (m_dump.WriteData(&buf2ch, sizeof(buf2ch)) != sizeof(buf2ch)) // write file data (2 ch)
 					{
 						throw EXCEPTION("AudioDumper::WriteData() failed (2 ch)");
@@ -401,6 +314,11 @@ s32 cellAudioInit()
 			//LOG_NOTICE(HLE, "Audio perf: start=%d (access=%d, AddData=%d, events=%d, dump=%d)",
 			//time_pos, stamp1 - stamp0, stamp2 - stamp1, stamp3 - stamp2, get_system_time() - stamp3);
 		}
+
+		if (const u64 dropped = out_ring.dropped.load())
+		{
+			cellAudio.warning("Audio Thread: %lld of %lld blocks dropped (backend stuck or stopped)", dropped, g_audio.counter);
+		}
 	});
 
 	return CELL_OK;
@@ -856,10 +774,7 @@ s32 cellAudioAddData(u32 portNum, vm::ptr<float> src, u32 samples, float volume)
 
 	const auto dst = vm::ptr<float>::make(port.addr + u32(port.tag % port.block) * port.channel * 256 * SIZE_32(float));
 
-	for (u32 i = 0; i < samples * port.channel; i++)
-	{
-		dst[i] += src[i] * volume; // mix all channels
-	}
+	audio_mixer::add_be(dst.get_ptr(), port.channel, src.get_ptr(), port.channel, samples, volume); // mix all channels
 
 	return CELL_OK;
 }
@@ -893,31 +808,9 @@ s32 cellAudioAdd2chData(u32 portNum, vm::ptr<float> src, u32 samples, float volu
 	{
 		cellAudio.error("cellAudioAdd2chData(portNum=%d): port.channel = 2", portNum);
 	}
-	else if (port.channel == 6)
+	else if (port.channel == 6 || port.channel == 8)
 	{
-		for (u32 i = 0; i < samples; i++)
-		{
-			dst[i * 6 + 0] += src[i * 2 + 0] * volume; // mix L ch
-			dst[i * 6 + 1] += src[i * 2 + 1] * volume; // mix R ch
-			//dst[i * 6 + 2] += 0.0f; // center
-			//dst[i * 6 + 3] += 0.0f; // LFE
-			//dst[i * 6 + 4] += 0.0f; // rear L
-			//dst[i * 6 + 5] += 0.0f; // rear R
-		}
-	}
-	else if (port.channel == 8)
-	{
-		for (u32 i = 0; i < samples; i++)
-		{
-			dst[i * 8 + 0] += src[i * 2 + 0] * volume; // mix L ch
-			dst[i * 8 + 1] += src[i * 2 + 1] * volume; // mix R ch
-			//dst[i * 8 + 2] += 0.0f; // center
-			//dst[i * 8 + 3] += 0.0f; // LFE
-			//dst[i * 8 + 4] += 0.0f; // rear L
-			//dst[i * 8 + 5] += 0.0f; // rear R
-			//dst[i * 8 + 6] += 0.0f; // side L
-			//dst[i * 8 + 7] += 0.0f; // side R
-		}
+		audio_mixer::add_be(dst.get_ptr(), port.channel, src.get_ptr(), 2, samples, volume); // mix L and R ch
 	}
 	else
 	{
@@ -951,17 +844,7 @@ s32 cellAudioAdd6chData(u32 portNum, vm::ptr<float> src, float volume)
 	}
 	else if (port.channel == 8)
 	{
-		for (u32 i = 0; i < 256; i++)
-		{
-			dst[i * 8 + 0] += src[i * 6 + 0] * volume; // mix L ch
-			dst[i * 8 + 1] += src[i * 6 + 1] * volume; // mix R ch
-			dst[i * 8 + 2] += src[i * 6 + 2] * volume; // mix center
-			dst[i * 8 + 3] += src[i * 6 + 3] * volume; // mix LFE
-			dst[i * 8 + 4] += src[i * 6 + 4] * volume; // mix rear L
-			dst[i * 8 + 5] += src[i * 6 + 5] * volume; // mix rear R
-			//dst[i * 8 + 6] += 0.0f; // side L
-			//dst[i * 8 + 7] += 0.0f; // side R
-		}
+		audio_mixer::add_be(dst.get_ptr(), 8, src.get_ptr(), 6, 256, volume); // mix L, R, center, LFE, rear L and rear R ch
 	}
 	else
 	{
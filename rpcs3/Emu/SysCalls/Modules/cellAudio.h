@@ -135,6 +135,8 @@ struct AudioConfig final // custom structure
 	u64 start_time;
 	std::vector<u64> keys;
 
+	std::condition_variable cv; // notified (with mutex) after every mixing period
+
 	u32 open_port()
 	{
 		for (u32 i = 0; i < AUDIO_PORT_COUNT; i++)
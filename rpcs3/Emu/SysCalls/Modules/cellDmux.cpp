@@ -91,10 +91,10 @@ ElementaryStream::ElementaryStream(Demuxer* dmux, u32 addr, u32 size, u32 fidMaj
 	, cbArg(cbArg)
 	, spec(spec)
 	, put(align(addr, 128))
+	, pending(0)
 	, put_count(0)
 	, got_count(0)
 	, released(0)
-	, raw_pos(0)
 	, last_dts(CODEC_TS_INVALID)
 	, last_pts(CODEC_TS_INVALID)
 {
@@ -134,26 +134,14 @@ bool ElementaryStream::is_full(u32 space)
 	}
 }
 
-bool ElementaryStream::isfull(u32 space)
-{
-	std::lock_guard<std::mutex> lock(m_mutex);
-	return is_full(space);
-}
-
-void ElementaryStream::push_au(u32 size, u64 dts, u64 pts, u64 userdata, bool rap, u32 specific)
+void ElementaryStream::push_au(u64 dts, u64 pts, u64 userdata, bool rap, u32 specific)
 {
 	u32 addr;
 	{
 		std::lock_guard<std::mutex> lock(m_mutex);
-		assert(!is_full(size));
-
-		if (put + size + 128 > memAddr + memSize)
-		{
-			put = memAddr;
-		}
 
-		std::memcpy(vm::base(put + 128), raw_data.data(), size);
-		raw_data.erase(raw_data.begin(), raw_data.begin() + size);
+		// AU data is already in place (see push())
+		const u32 size = pending;
 
 		auto info = vm::ptr<CellDmuxAuInfoEx>::make(put);
 		info->auAddr = put + 128;
@@ -182,6 +170,7 @@ void ElementaryStream::push_au(u32 size, u64 dts, u64 pts, u64 userdata, bool ra
 		addr = put;
 
 		put = align(put + 128 + size, 128);
+		pending = 0;
 
 		put_count++;
 	}
@@ -191,15 +180,35 @@ void ElementaryStream::push_au(u32 size, u64 dts, u64 pts, u64 userdata, bool ra
 	}
 }
 
-void ElementaryStream::push(DemuxerStream& stream, u32 size)
+bool ElementaryStream::push(DemuxerStream& stream, u32 size)
 {
-	auto const old_size = raw_data.size();
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	const u32 space = pending + size;
+
+	if (space + 128 > memSize)
+	{
+		throw EXCEPTION("AU is too big (size=0x%x, memSize=0x%x)", space, memSize);
+	}
 
-	raw_data.resize(old_size + size);
+	if (is_full(space))
+	{
+		return false;
+	}
+
+	if (put + space + 128 > memAddr + memSize)
+	{
+		// The AU would cross the end of the buffer: move collected data to the beginning (the only copy of ES data)
+		std::memmove(vm::base(memAddr + 128), vm::base(put + 128), pending);
+		put = memAddr;
+	}
 
-	std::memcpy(raw_data.data() + old_size, vm::base(stream.addr), size); // append bytes
+	// Copy directly from the stream to the AU location
+	std::memcpy(vm::base(put + 128 + pending), vm::base(stream.addr), size);
+	pending = space;
 
 	stream.skip(size);
+	return true;
 }
 
 bool ElementaryStream::release()
@@ -270,8 +279,7 @@ void ElementaryStream::reset()
 	put_count = 0;
 	got_count = 0;
 	released = 0;
-	raw_data.clear();
-	raw_pos = 0;
+	pending = 0;
 }
 
 void dmuxQueryAttr(u32 info_addr /* may be 0 */, vm::ptr<CellDmuxAttr> attr)
@@ -321,6 +329,56 @@ void dmuxOpen(u32 dmux_id) // TODO: call from the constructor
 
 		u32 cb_add = 0;
 
+		// ATRAC3plus packet payload which is not yet copied to the ES buffer
+		ElementaryStream* atx_es = nullptr;
+		u32 atx_left = 0;
+
+		// Split ATRAC3plus payload into AUs assembled in the ES buffer (returns false if the buffer is full)
+		const auto push_atx = [&]() -> bool
+		{
+			ElementaryStream& es = *atx_es;
+
+			while (atx_left)
+			{
+				u32 au_size = 8; // ATS header
+
+				if (es.pending_size() >= 8)
+				{
+					const u8* data = es.pending_data();
+
+					if (data[0] != 0x0f || data[1] != 0xd0)
+					{
+						throw EXCEPTION("ATX: 0x0fd0 header not found (ats=0x%llx)", *(be_t<u64>*)data);
+					}
+
+					au_size = ((((u32)data[2] & 0x3) << 8) | (u32)data[3]) * 8 + 16;
+				}
+
+				const u32 size = std::min(au_size - es.pending_size(), atx_left);
+
+				if (!es.push(stream, size))
+				{
+					return false;
+				}
+
+				atx_left -= size;
+
+				if (au_size > 8 && es.pending_size() == au_size)
+				{
+					es.push_au(es.last_dts, es.last_pts, stream.userdata, false /* TODO: set correct value */, 0);
+
+					//cellDmux.notice("ATX AU pushed (au_size=%d)", au_size);
+
+					auto esMsg = vm::ptr<CellDmuxEsMsg>::make(dmux.memAddr + (cb_add ^= 16));
+					esMsg->msgType = CELL_DMUX_ES_MSG_TYPE_AU_FOUND;
+					esMsg->supplementalInfo = stream.userdata;
+					es.cbFunc(CPU, dmux.id, es.id, esMsg, es.cbArg);
+				}
+			}
+
+			return true;
+		};
+
 		while (true)
 		{
 			if (Emu.IsStopped() || dmux.is_closed)
@@ -330,6 +388,17 @@ void dmuxOpen(u32 dmux_id) // TODO: call from the constructor
 			
 			if (!dmux.job.try_peek(task) && dmux.is_running && stream.addr)
 			{
+				if (atx_left)
+				{
+					// continue the packet after AUs have been released
+					if (!push_atx())
+					{
+						std::this_thread::sleep_for(std::chrono::milliseconds(1)); // hack
+					}
+
+					continue;
+				}
+
 				// default task (demuxing) (if there is no other work)
 				be_t<u32> code;
 				be_t<u16> len;
@@ -413,8 +482,6 @@ void dmuxOpen(u32 dmux_id) // TODO: call from the constructor
 				case PRIVATE_STREAM_1:
 				{
 					// audio and user data stream
-					DemuxerStream backup = stream;
-
 					if (!stream.check(6))
 					{
 						throw EXCEPTION("End of stream (PRIVATE_STREAM_1)");
@@ -449,12 +516,6 @@ void dmuxOpen(u32 dmux_id) // TODO: call from the constructor
 					if ((fid_minor & -0x10) == 0 && esATX[ch])
 					{
 						ElementaryStream& es = *esATX[ch];
-						if (es.raw_data.size() > 1024 * 1024)
-						{
-							stream = backup;
-							std::this_thread::sleep_for(std::chrono::milliseconds(1)); // hack
-							continue;
-						}
 
 						if (len < 3 || !stream.check(3))
 						{
@@ -469,34 +530,12 @@ void dmuxOpen(u32 dmux_id) // TODO: call from the constructor
 							es.last_pts = pes.pts;
 						}
 
-						es.push(stream, len);
+						atx_es = &es;
+						atx_left = len;
 
-						while (true)
+						if (!push_atx())
 						{
-							auto const size = es.raw_data.size() - es.raw_pos; // size of available new data
-							auto const data = es.raw_data.data() + es.raw_pos; // pointer to available data
-
-							if (size < 8) break; // skip if cannot read ATS header
-
-							if (data[0] != 0x0f || data[1] != 0xd0)
-							{
-								throw EXCEPTION("ATX: 0x0fd0 header not found (ats=0x%llx)", *(be_t<u64>*)data);
-							}
-
-							u32 frame_size = ((((u32)data[2] & 0x3) << 8) | (u32)data[3]) * 8 + 8;
-
-							if (size < frame_size + 8) break; // skip non-complete AU
-
-							if (es.isfull(frame_size + 8)) break; // skip if cannot push AU
-							
-							es.push_au(frame_size + 8, es.last_dts, es.last_pts, stream.userdata, false /* TODO: set correct value */, 0);
-
-							//cellDmux.notice("ATX AU pushed (ats=0x%llx, frame_size=%d)", *(be_t<u64>*)data, frame_size);
-
-							auto esMsg = vm::ptr<CellDmuxEsMsg>::make(dmux.memAddr + (cb_add ^= 16));
-							esMsg->msgType = CELL_DMUX_ES_MSG_TYPE_AU_FOUND;
-							esMsg->supplementalInfo = stream.userdata;
-							es.cbFunc(CPU, dmux.id, es.id, esMsg, es.cbArg);
+							std::this_thread::sleep_for(std::chrono::milliseconds(1)); // hack
 						}
 					}
 					else
@@ -544,18 +583,12 @@ void dmuxOpen(u32 dmux_id) // TODO: call from the constructor
 					{
 						ElementaryStream& es = *esAVC[ch];
 
-						const u32 old_size = (u32)es.raw_data.size();
-						if (es.isfull(old_size))
-						{
-							stream = backup;
-							std::this_thread::sleep_for(std::chrono::milliseconds(1)); // hack
-							continue;
-						}
+						const u32 old_size = es.pending_size();
 
 						if ((pes.has_ts && old_size) || old_size >= 0x69800)
 						{
 							// push AU if it becomes too big or the next packet contains PTS/DTS
-							es.push_au(old_size, es.last_dts, es.last_pts, stream.userdata, false /* TODO: set correct value */, 0);
+							es.push_au(es.last_dts, es.last_pts, stream.userdata, false /* TODO: set correct value */, 0);
 
 							// callback
 							auto esMsg = vm::ptr<CellDmuxEsMsg>::make(dmux.memAddr + (cb_add ^= 16));
@@ -571,10 +604,16 @@ void dmuxOpen(u32 dmux_id) // TODO: call from the constructor
 							es.last_pts = pes.pts;
 						}
 
-						// reconstruction of MPEG2-PS stream for vdec module
+						// reconstruction of MPEG2-PS stream for vdec module (the packet is copied once, directly to the AU location)
 						const u32 size = len + pes.size + 9;
 						stream = backup;
-						es.push(stream, size);
+
+						if (!es.push(stream, size))
+						{
+							// retry the packet later (the AU above is not pushed again)
+							std::this_thread::sleep_for(std::chrono::milliseconds(1)); // hack
+							continue;
+						}
 					}
 					else
 					{
@@ -622,6 +661,7 @@ void dmuxOpen(u32 dmux_id) // TODO: call from the constructor
 				}
 
 				stream = task.stream;
+				atx_left = 0;
 				//LOG_NOTICE(HLE, "*** stream updated(addr=0x%x, size=0x%x, discont=%d, userdata=0x%llx)",
 					//stream.addr, stream.size, stream.discontinuity, stream.userdata);
 				break;
@@ -640,6 +680,7 @@ void dmuxOpen(u32 dmux_id) // TODO: call from the constructor
 					dmux.cbFunc(CPU, dmux.id, dmuxMsg, dmux.cbArg);
 
 					stream = {};
+					atx_left = 0;
 
 					dmux.is_working = false;
 				}
@@ -699,6 +740,11 @@ void dmuxOpen(u32 dmux_id) // TODO: call from the constructor
 						esALL[i] = nullptr;
 					}
 				}
+				if (atx_es == &es)
+				{
+					atx_es = nullptr;
+					atx_left = 0;
+				}
 				es.dmux = nullptr;
 				idm::remove<ElementaryStream>(task.es.es);
 				break;
@@ -708,18 +754,10 @@ void dmuxOpen(u32 dmux_id) // TODO: call from the constructor
 			{
 				ElementaryStream& es = *task.es.es_ptr;
 
-				const u32 old_size = (u32)es.raw_data.size();
-				if (old_size && (es.fidMajor & -0x10) == 0xe0)
+				if (es.pending_size() && (es.fidMajor & -0x10) == 0xe0)
 				{
 					// TODO (it's only for AVC, some ATX data may be lost)
-					while (es.isfull(old_size))
-					{
-						if (Emu.IsStopped() || dmux.is_closed) break;
-
-						std::this_thread::sleep_for(std::chrono::milliseconds(1)); // hack
-					}
-
-					es.push_au(old_size, es.last_dts, es.last_pts, stream.userdata, false, 0);
+					es.push_au(es.last_dts, es.last_pts, stream.userdata, false, 0);
 
 					// callback
 					auto esMsg = vm::ptr<CellDmuxEsMsg>::make(dmux.memAddr + (cb_add ^= 16));
@@ -728,9 +766,9 @@ void dmuxOpen(u32 dmux_id) // TODO: call from the constructor
 					es.cbFunc(CPU, dmux.id, es.id, esMsg, es.cbArg);
 				}
 				
-				if (es.raw_data.size())
+				if (es.pending_size())
 				{
-					cellDmux.error("dmuxFlushEs: 0x%x bytes lost (es_id=%d)", (u32)es.raw_data.size(), es.id);
+					cellDmux.error("dmuxFlushEs: 0x%x bytes lost (es_id=%d)", es.pending_size(), es.id);
 				}
 
 				// callback
@@ -744,6 +782,11 @@ void dmuxOpen(u32 dmux_id) // TODO: call from the constructor
 			case dmuxResetEs:
 			{
 				task.es.es_ptr->reset();
+
+				if (atx_es == task.es.es_ptr)
+				{
+					atx_left = 0;
+				}
 				break;
 			}
 			
@@ -433,6 +433,7 @@ class ElementaryStream
 	u32 released; // number of AU released
 
 	u32 put; // AU that is being written now
+	u32 pending; // size of AU data assembled at put + 128
 
 	bool is_full(u32 space);
 	
@@ -451,16 +452,24 @@ public:
 	const u32 cbArg;
 	const u32 spec; //addr
 
-	std::vector<u8> raw_data; // demultiplexed data stream (managed by demuxer thread)
-	size_t raw_pos; // should be <= raw_data.size()
 	u64 last_dts;
 	u64 last_pts;
 
-	void push(DemuxerStream& stream, u32 size); // called by demuxer thread (not multithread-safe)
+	// Size of the AU being assembled (demuxer thread only)
+	u32 pending_size() const
+	{
+		return pending;
+	}
+
+	// Data of the AU being assembled, located in the ES buffer (demuxer thread only)
+	const u8* pending_data() const
+	{
+		return vm::_ptr<u8>(put + 128);
+	}
 
-	bool isfull(u32 space);
+	bool push(DemuxerStream& stream, u32 size); // append data to the AU being assembled, false if the buffer is full (called by demuxer thread)
 
-	void push_au(u32 size, u64 dts, u64 pts, u64 userdata, bool rap, u32 specific);
+	void push_au(u64 dts, u64 pts, u64 userdata, bool rap, u32 specific); // publish the AU being assembled
 
 	bool release();
 
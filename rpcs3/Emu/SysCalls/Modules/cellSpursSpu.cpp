@@ -32,6 +32,7 @@ static bool spursDma(SPUThread & spu, u32 cmd, u64 ea, u32 lsa, u32 size, u32 ta
 static u32 spursDmaGetCompletionStatus(SPUThread & spu, u32 tagMask);
 static u32 spursDmaWaitForCompletion(SPUThread & spu, u32 tagMask, bool waitForAll = true);
 static void spursHalt(SPUThread & spu);
+static void spursStop(SPUThread & spu);
 
 //
 // SPURS kernel functions
@@ -153,6 +154,19 @@ void spursHalt(SPUThread & spu) {
     spu.halt();
 }
 
+/// Stop the SPU thread like sys_spu_thread_exit does (wakes up sys_spu_thread_group_join)
+void spursStop(SPUThread & spu) {
+    LV2_LOCK;
+
+    spu.status |= SPU_STATUS_STOPPED_BY_STOP;
+
+    if (const auto group = spu.tg.lock()) {
+        group->notify_all(lv2_lock);
+    }
+
+    spu.stop();
+}
+
 //----------------------------------------------------------------------------
 // SPURS kernel functions
 //----------------------------------------------------------------------------
@@ -563,7 +577,6 @@ bool spursKernelEntry(SPUThread & spu) {
     }
 
     // Register SPURS kernel HLE functions
-    spu.UnregisterHleFunctions(0, 0x40000/*LS_BOTTOM*/);
     spu.RegisterHleFunction(isKernel2 ? CELL_SPURS_KERNEL2_ENTRY_ADDR : CELL_SPURS_KERNEL1_ENTRY_ADDR, spursKernelEntry);
     spu.RegisterHleFunction(ctxt->exitToKernelAddr, spursKernelWorkloadExit);
     spu.RegisterHleFunction(ctxt->selectWorkloadAddr, isKernel2 ? spursKernel2SelectWorkload : spursKernel1SelectWorkload);
@@ -1097,7 +1110,6 @@ bool spursTasksetEntry(SPUThread & spu) {
     ctxt->taskId         = 0xFFFFFFFF;
 
     // Register SPURS takset policy module HLE functions
-    spu.UnregisterHleFunctions(CELL_SPURS_TASKSET_PM_ENTRY_ADDR, 0x40000/*LS_BOTTOM*/);
     spu.RegisterHleFunction(CELL_SPURS_TASKSET_PM_ENTRY_ADDR, spursTasksetEntry);
     spu.RegisterHleFunction(ctxt->syscallAddr, spursTasksetSyscallEntry);
 
@@ -1505,8 +1517,7 @@ void spursTasksetDispatch(SPUThread & spu) {
         cellSpursModulePutTrace(&pkt, 0x1F);
 
         if (elfAddr & 2) { // TODO: Figure this out
-            spu.status |= SPU_STATUS_STOPPED_BY_STOP;
-            spu.stop();
+            spursStop(spu);
             return;
         }
 
@@ -1551,8 +1562,7 @@ void spursTasksetDispatch(SPUThread & spu) {
         cellSpursModulePutTrace(&pkt, 0x1F);
 
         if (elfAddr & 2) { // TODO: Figure this out
-            spu.status |= SPU_STATUS_STOPPED_BY_STOP;
-            spu.stop();
+            spursStop(spu);
             return;
         }
 
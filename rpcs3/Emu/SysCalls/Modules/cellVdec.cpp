@@ -1,6 +1,7 @@
 #include "stdafx.h"
 #include "Emu/Memory/Memory.h"
 #include "Emu/System.h"
+#include "Emu/state.h"
 #include "Emu/IdManager.h"
 #include "Emu/SysCalls/Modules.h"
 
@@ -11,9 +12,9 @@ extern "C"
 #include "libavcodec/avcodec.h"
 #include "libavformat/avformat.h"
 #include "libavutil/imgutils.h"
-#include "libswscale/swscale.h"
 }
 
+#include "Emu/Video/VideoConvert.h"
 #include "cellPamf.h"
 #include "cellVdec.h"
 
@@ -95,6 +96,10 @@ VideoDecoder::~VideoDecoder()
 		av_frame_unref(vf.data);
 		av_frame_free(&vf.data);
 	}
+	for (AVFrame* frame : frame_pool)
+	{
+		av_frame_free(&frame);
+	}
 	if (ctx)
 	{
 		avcodec_close(ctx);
@@ -111,6 +116,47 @@ VideoDecoder::~VideoDecoder()
 	}
 }
 
+AVFrame* VideoDecoder::alloc_frame()
+{
+	{
+		std::lock_guard<std::mutex> lock(frame_pool_mutex);
+
+		if (!frame_pool.empty())
+		{
+			AVFrame* frame = frame_pool.back();
+			frame_pool.pop_back();
+			return frame;
+		}
+	}
+
+	AVFrame* frame = av_frame_alloc();
+
+	if (!frame)
+	{
+		throw EXCEPTION("av_frame_alloc() failed");
+	}
+
+	return frame;
+}
+
+void VideoDecoder::release_frame(AVFrame* frame)
+{
+	// Picture buffers go back to the decoder's buffer pool, the frame itself is kept
+	av_frame_unref(frame);
+
+	std::lock_guard<std::mutex> lock(frame_pool_mutex);
+	frame_pool.push_back(frame);
+}
+
+void VideoDecoder::set_threading(AVCodecContext* ctx)
+{
+	// Frame threading delays output by thread_count - 1 pictures, which are drained by the empty packet at the end of the stream.
+	// The default count is kept low, games waiting for a picture after submitting a few AUs would stall otherwise.
+	const u32 threads = rpcs3::config.core.video_decoder_threads.value();
+	ctx->thread_count = threads ? threads : std::min<u32>(std::max<u32>(std::thread::hardware_concurrency(), 1), 4);
+	ctx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+}
+
 int vdecRead(void* opaque, u8* buf, int buf_size)
 {
 	VideoDecoder& vdec = *(VideoDecoder*)opaque;
@@ -327,7 +373,10 @@ void vdecOpen(u32 vdec_id) // TODO: call from the constructor
 						}
 					}
 					vdec.ctx = vdec.fmt->streams[0]->codec; // TODO: check data
-						
+
+					// AU user data is passed with the packet through reordered_opaque, pts/dts are computed from the output picture
+					VideoDecoder::set_threading(vdec.ctx);
+
 					opts = nullptr;
 					av_dict_set(&opts, "refcounted_frames", "1", 0);
 					{
@@ -364,29 +413,29 @@ void vdecOpen(u32 vdec_id) // TODO: call from the constructor
 
 					struct VdecFrameHolder : VdecFrame
 					{
-						VdecFrameHolder()
+						VideoDecoder& vdec;
+
+						VdecFrameHolder(VideoDecoder& vdec)
+							: vdec(vdec)
 						{
-							data = av_frame_alloc();
+							data = vdec.alloc_frame();
 						}
 
 						~VdecFrameHolder()
 						{
 							if (data)
 							{
-								av_frame_unref(data);
-								av_frame_free(&data);
+								vdec.release_frame(data);
 							}
 						}
 
-					} frame;
-
-					if (!frame.data)
-					{
-						throw EXCEPTION("av_frame_alloc() failed");
-					}
+					} frame(vdec);
 
 					int got_picture = 0;
 
+					// returned in frame->reordered_opaque of the picture decoded from this AU (which may be output later)
+					vdec.ctx->reordered_opaque = task.userData;
+
 					int decode = avcodec_decode_video2(vdec.ctx, frame.data, &got_picture, &au);
 
 					if (decode <= 0)
@@ -500,7 +549,7 @@ void vdecOpen(u32 vdec_id) // TODO: call from the constructor
 
 						frame.pts = vdec.last_pts;
 						frame.dts = (frame.pts - vdec.first_pts) + vdec.first_dts;
-						frame.userdata = task.userData;
+						frame.userdata = frame.data->reordered_opaque;
 
 						//LOG_NOTICE(HLE, "got picture (pts=0x%llx, dts=0x%llx)", frame.pts, frame.dts);
 
@@ -684,10 +733,9 @@ s32 cellVdecGetPicture(u32 handle, vm::cptr<CellVdecPicFormat> format, vm::ptr<u
 		return CELL_OK;
 	}
 
-	std::unique_ptr<AVFrame, void(*)(AVFrame*)> frame(vf.data, [](AVFrame* frame)
+	std::unique_ptr<AVFrame, std::function<void(AVFrame*)>> frame(vf.data, [&](AVFrame* frame)
 	{
-		av_frame_unref(frame);
-		av_frame_free(&frame);
+		vdec->release_frame(frame);
 	});
 
 	if (outBuff)
@@ -696,62 +744,43 @@ s32 cellVdecGetPicture(u32 handle, vm::cptr<CellVdecPicFormat> format, vm::ptr<u
 		const auto w = vdec->ctx->width;
 		const auto h = vdec->ctx->height;
 
-		auto out_f = AV_PIX_FMT_YUV420P;
-
-		std::unique_ptr<u8[]> alpha_plane;
-
-		switch (const u32 type = format->formatType)
-		{
-		case CELL_VDEC_PICFMT_ARGB32_ILV: out_f = AV_PIX_FMT_ARGB; alpha_plane.reset(new u8[w * h]); break;
-		case CELL_VDEC_PICFMT_RGBA32_ILV: out_f = AV_PIX_FMT_RGBA; alpha_plane.reset(new u8[w * h]); break;
-		case CELL_VDEC_PICFMT_UYVY422_ILV: out_f = AV_PIX_FMT_UYVY422; break;
-		case CELL_VDEC_PICFMT_YUV420_PLANAR: out_f = AV_PIX_FMT_YUV420P; break;
-
-		default:
-		{
-			throw EXCEPTION("Unknown formatType(%d)", type);
-		}
-		}
-
 		if (format->colorMatrixType != CELL_VDEC_COLOR_MATRIX_TYPE_BT709)
 		{
 			throw EXCEPTION("Unknown colorMatrixType(%d)", format->colorMatrixType);
 		}
 
-		if (alpha_plane)
+		if (f != AV_PIX_FMT_YUV420P)
 		{
-			memset(alpha_plane.get(), format->alpha, w * h);
+			throw EXCEPTION("Unknown pix_fmt(%d)", f);
 		}
 
-		auto in_f = AV_PIX_FMT_YUV420P;
+		// Convert straight into the output buffer (alpha constant is written by the converter)
+		u8* const out = outBuff.get_ptr();
 
-		switch (f)
+		switch (const u32 type = format->formatType)
 		{
-		case AV_PIX_FMT_YUV420P: in_f = alpha_plane ? AV_PIX_FMT_YUVA420P : AV_PIX_FMT_YUV420P; break;
-
-		default:
+		case CELL_VDEC_PICFMT_ARGB32_ILV:
+		case CELL_VDEC_PICFMT_RGBA32_ILV:
 		{
-			throw EXCEPTION("Unknown pix_fmt(%d)", f);
+			const auto out_f = type == CELL_VDEC_PICFMT_ARGB32_ILV ? video_convert::rgb_format::argb : video_convert::rgb_format::rgba;
+			video_convert::yuv420_to_rgb32(out, w * 4, frame->data[0], frame->linesize[0], frame->data[1], frame->data[2], frame->linesize[1], w, h, out_f, video_convert::color_matrix::bt709, format->alpha);
+			break;
 		}
+		case CELL_VDEC_PICFMT_UYVY422_ILV:
+		{
+			video_convert::yuv420_to_uyvy422(out, w * 2, frame->data[0], frame->linesize[0], frame->data[1], frame->data[2], frame->linesize[1], w, h);
+			break;
 		}
-
-		std::unique_ptr<SwsContext, void(*)(SwsContext*)> sws(sws_getContext(w, h, in_f, w, h, out_f, SWS_POINT, NULL, NULL, NULL), sws_freeContext);
-
-		u8* in_data[4] = { frame->data[0], frame->data[1], frame->data[2], alpha_plane.get() };
-		int in_line[4] = { frame->linesize[0], frame->linesize[1], frame->linesize[2], w * 1 };
-		u8* out_data[4] = { outBuff.get_ptr() };
-		int out_line[4] = { w * 4 };
-
-		if (!alpha_plane)
+		case CELL_VDEC_PICFMT_YUV420_PLANAR:
 		{
-			out_data[1] = out_data[0] + w * h;
-			out_data[2] = out_data[0] + w * h * 5 / 4;
-			out_line[0] = w;
-			out_line[1] = w / 2;
-			out_line[2] = w / 2;
+			video_convert::copy_yuv420(out, frame->data[0], frame->linesize[0], frame->data[1], frame->data[2], frame->linesize[1], w, h);
+			break;
+		}
+		default:
+		{
+			throw EXCEPTION("Unknown formatType(%d)", type);
+		}
 		}
-
-		sws_scale(sws.get(), in_data, in_line, 0, h, out_data, out_line);
 
 		//const u32 buf_size = align(av_image_get_buffer_size(vdec->ctx->pix_fmt, vdec->ctx->width, vdec->ctx->height, 1), 128);
 
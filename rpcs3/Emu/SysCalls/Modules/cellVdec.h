@@ -716,6 +716,9 @@ public:
 
 	squeue_t<VdecFrame> frames;
 
+	std::mutex frame_pool_mutex;
+	std::vector<AVFrame*> frame_pool; // released frames kept for reuse (buffers are unreferenced)
+
 	const s32 type;
 	const u32 profile;
 	const u32 memAddr;
@@ -734,4 +737,13 @@ public:
 	VideoDecoder(s32 type, u32 profile, u32 addr, u32 size, vm::ptr<CellVdecCbMsg> func, u32 arg);
 
 	~VideoDecoder();
+
+	// Get an empty frame from the pool (or allocate a new one)
+	AVFrame* alloc_frame();
+
+	// Unreference frame buffers and return the frame to the pool
+	void release_frame(AVFrame* frame);
+
+	// Set the decoder thread count and threading mode (before avcodec_open2)
+	static void set_threading(AVCodecContext* ctx);
 };
@@ -9,10 +9,16 @@ extern "C"
 #include "libswscale/swscale.h"
 }
 
+#include "Emu/Video/VideoConvert.h"
 #include "cellVpost.h"
 
 extern Module<> cellVpost;
 
+VpostInstance::~VpostInstance()
+{
+	sws_freeContext(sws);
+}
+
 s32 cellVpostQueryAttr(vm::cptr<CellVpostCfgParam> cfgParam, vm::ptr<CellVpostAttr> attr)
 {
 	cellVpost.warning("cellVpostQueryAttr(cfgParam=*0x%x, attr=*0x%x)", cfgParam, attr);
@@ -114,26 +120,49 @@ s32 cellVpostExec(u32 handle, vm::cptr<u8> inPicBuff, vm::cptr<CellVpostCtrlPara
 	picInfo->reserved1 = 0;
 	picInfo->reserved2 = 0;
 
-	//u64 stamp0 = get_system_time();
-	std::unique_ptr<u8[]> pA(new u8[w*h]);
+	const bool bt709 = ctrlParam->inColorMatrix == CELL_VPOST_COLOR_MATRIX_BT709;
 
-	memset(pA.get(), ctrlParam->outAlpha, w*h);
+	// Chroma planes (rounded up for odd sizes)
+	const s32 cw = (w + 1) / 2;
+	const u32 ch = (h + 1) / 2;
+	const u8* in_u = &inPicBuff[w * h];
+	const u8* in_v = &inPicBuff[w * h + cw * ch];
 
-	//u64 stamp1 = get_system_time();
+	if (w == ow && h == oh)
+	{
+		// No scaling: convert straight into the output buffer
+		video_convert::yuv420_to_rgb32(outPicBuff.get_ptr(), ow * 4, &inPicBuff[0], w, in_u, in_v, cw, w, h, video_convert::rgb_format::rgba, bt709 ? video_convert::color_matrix::bt709 : video_convert::color_matrix::bt601, ctrlParam->outAlpha);
+		return CELL_OK;
+	}
 
-	std::unique_ptr<SwsContext, void(*)(SwsContext*)> sws(sws_getContext(w, h, AV_PIX_FMT_YUVA420P, ow, oh, AV_PIX_FMT_RGBA, SWS_BILINEAR, NULL, NULL, NULL), sws_freeContext);
+	// The alpha plane is only refilled when the size or the alpha value changes
+	if (vpost->alpha_plane.size() != w * h || vpost->alpha != ctrlParam->outAlpha)
+	{
+		vpost->alpha = ctrlParam->outAlpha;
+		vpost->alpha_plane.assign(w * h, vpost->alpha);
+	}
+
+	// Returns the same context if the parameters didn't change
+	vpost->sws = sws_getCachedContext(vpost->sws, w, h, AV_PIX_FMT_YUVA420P, ow, oh, AV_PIX_FMT_RGBA, SWS_BILINEAR, NULL, NULL, NULL);
+
+	// Use the same color matrix as the unscaled conversion (swscale defaults to BT.601, new contexts are reset to it)
+	const int* coefs = sws_getCoefficients(bt709 ? SWS_CS_ITU709 : SWS_CS_ITU601);
+	int* inv_table;
+	int* table;
+	int src_range, dst_range, brightness, contrast, saturation;
 
-	//u64 stamp2 = get_system_time();
+	if (sws_getColorspaceDetails(vpost->sws, &inv_table, &src_range, &table, &dst_range, &brightness, &contrast, &saturation) >= 0 && std::memcmp(inv_table, coefs, 4 * sizeof(int)))
+	{
+		sws_setColorspaceDetails(vpost->sws, coefs, src_range, table, dst_range, brightness, contrast, saturation);
+	}
 
-	const u8* in_data[4] = { &inPicBuff[0], &inPicBuff[w * h], &inPicBuff[w * h * 5 / 4], pA.get() };
-	int in_line[4] = { w, w/2, w/2, w };
+	const u8* in_data[4] = { &inPicBuff[0], in_u, in_v, vpost->alpha_plane.data() };
+	int in_line[4] = { w, cw, cw, w };
 	u8* out_data[4] = { outPicBuff.get_ptr(), NULL, NULL, NULL };
 	int out_line[4] = { static_cast<int>(ow*4), 0, 0, 0 };
 
-	sws_scale(sws.get(), in_data, in_line, 0, h, out_data, out_line);
+	sws_scale(vpost->sws, in_data, in_line, 0, h, out_data, out_line);
 
-	//ConLog.Write("cellVpostExec() perf (access=%d, getContext=%d, scale=%d, finalize=%d)",
-		//stamp1 - stamp0, stamp2 - stamp1, stamp3 - stamp2, get_system_time() - stamp3);
 	return CELL_OK;
 }
 
@@ -318,13 +318,22 @@ struct CellVpostPictureInfo
 	be_t<u32> reserved2;
 };
 
+struct SwsContext;
+
 class VpostInstance
 {
 public:
 	const bool to_rgba;
 
+	// Scaler state reused between cellVpostExec calls
+	SwsContext* sws = nullptr;
+	std::vector<u8> alpha_plane;
+	u8 alpha = 0;
+
 	VpostInstance(bool rgba)
 		: to_rgba(rgba)
 	{
 	}
+
+	~VpostInstance();
 };
@@ -4,6 +4,7 @@
 #include "Emu/IdManager.h"
 #include "Emu/SysCalls/Modules.h"
 #include "Emu/Cell/PPUInstrTable.h"
+#include "Emu/Audio/AudioMixer.h"
 
 #include "cellAudio.h"
 #include "libmixer.h"
@@ -43,54 +44,13 @@ s32 cellAANAddData(u32 aan_handle, u32 aan_port, u32 offset, vm::ptr<float> addr
 
 	std::lock_guard<std::mutex> lock(g_surmx.mutex);
 
-	if (type == CELL_SURMIXER_CHSTRIP_TYPE1A)
-	{
-		// mono upmixing
-		for (u32 i = 0; i < samples; i++)
-		{
-			const float center = addr[i];
-			g_surmx.mixdata[i * 8 + 0] += center;
-			g_surmx.mixdata[i * 8 + 1] += center;
-		}		
-	}
-	else if (type == CELL_SURMIXER_CHSTRIP_TYPE2A)
-	{
-		// stereo upmixing
-		for (u32 i = 0; i < samples; i++)
-		{
-			const float left = addr[i * 2 + 0];
-			const float right = addr[i * 2 + 1];
-			g_surmx.mixdata[i * 8 + 0] += left;
-			g_surmx.mixdata[i * 8 + 1] += right;
-		}
-	}
-	else if (type == CELL_SURMIXER_CHSTRIP_TYPE6A)
-	{
-		// 5.1 upmixing
-		for (u32 i = 0; i < samples; i++)
-		{
-			const float left = addr[i * 6 + 0];
-			const float right = addr[i * 6 + 1];
-			const float center = addr[i * 6 + 2];
-			const float low_freq = addr[i * 6 + 3];
-			const float rear_left = addr[i * 6 + 4];
-			const float rear_right = addr[i * 6 + 5];
-			g_surmx.mixdata[i * 8 + 0] += left;
-			g_surmx.mixdata[i * 8 + 1] += right;
-			g_surmx.mixdata[i * 8 + 2] += center;
-			g_surmx.mixdata[i * 8 + 3] += low_freq;
-			g_surmx.mixdata[i * 8 + 4] += rear_left;
-			g_surmx.mixdata[i * 8 + 5] += rear_right;
-		}
-	}
-	else if (type == CELL_SURMIXER_CHSTRIP_TYPE8A)
-	{
-		// 7.1
-		for (u32 i = 0; i < samples * 8; i++)
-		{
-			g_surmx.mixdata[i] += addr[i];
-		}
-	}
+	// mono is upmixed to both front channels, other types are mixed into matching channels
+	const u32 channels =
+		type == CELL_SURMIXER_CHSTRIP_TYPE1A ? 1 :
+		type == CELL_SURMIXER_CHSTRIP_TYPE2A ? 2 :
+		type == CELL_SURMIXER_CHSTRIP_TYPE6A ? 6 : 8;
+
+	audio_mixer::mix_to_8ch(g_surmx.mixdata, addr.get_ptr(), channels, samples);
 
 	return CELL_OK; 
 }
@@ -333,7 +293,14 @@ s32 cellSurMixerCreate(vm::cptr<CellSurMixerConfig> config)
 
 			if (g_surmx.mixcount > (port.tag + 0)) // adding positive value (1-15): preemptive buffer filling (hack)
 			{
-				std::this_thread::sleep_for(std::chrono::milliseconds(1)); // hack
+				// wait for the next mixing period of the audio thread
+				std::unique_lock<std::mutex> lock(g_audio.mutex);
+
+				if (g_surmx.mixcount > port.tag)
+				{
+					g_audio.cv.wait_for(lock, std::chrono::microseconds(AUDIO_SAMPLES * 1000000 / 48000));
+				}
+
 				continue;
 			}
 
@@ -430,11 +397,7 @@ s32 cellSurMixerCreate(vm::cptr<CellSurMixerConfig> config)
 
 				auto buf = vm::_ptr<f32>(port.addr + (g_surmx.mixcount % port.block) * port.channel * AUDIO_SAMPLES * sizeof(float));
 
-				for (auto& mixdata : g_surmx.mixdata)
-				{
-					// reverse byte order
-					*buf++ = mixdata;
-				}
+				audio_mixer::store_be(buf, g_surmx.mixdata, 8 * AUDIO_SAMPLES);
 
 				//u64 stamp3 = get_system_time();
 
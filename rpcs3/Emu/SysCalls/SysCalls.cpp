@@ -3,6 +3,7 @@
 #include "Emu/Memory/Memory.h"
 #include "Emu/System.h"
 #include "Emu/state.h"
+#include "Emu/perf.h"
 #include "Modules.h"
 
 #include "lv2/sys_lwmutex.h"
@@ -902,7 +903,11 @@ void execute_syscall_by_index(PPUThread& ppu, u64 code)
 
 	LOG_TRACE(PPU, "Syscall %lld called: %s", code, get_ps3_function_name(~code));
 
-	g_sc_table[code](ppu);
+	{
+		perf::scope perf_scope(perf::counter::syscall, code);
+
+		g_sc_table[code](ppu);
+	}
 
 	LOG_TRACE(PPU, "Syscall %lld finished: %s -> 0x%llx", code, get_ps3_function_name(~code), ppu.GPR[3]);
 
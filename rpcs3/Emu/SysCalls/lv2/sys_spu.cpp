@@ -219,6 +219,17 @@ s32 sys_spu_thread_get_exit_status(u32 id, vm::ptr<u32> status)
 	return CELL_OK;
 }
 
+void lv2_spu_group_t::notify_all(lv2_lock_t& lv2_lock)
+{
+	CHECK_LV2_LOCK(lv2_lock);
+
+	for (auto& thread : sq)
+	{
+		// waiters use their own condition variable with lv2_lock
+		thread->cv.notify_one();
+	}
+}
+
 s32 sys_spu_thread_group_create(vm::ptr<u32> id, u32 num, s32 prio, vm::ptr<sys_spu_thread_group_attribute> attr)
 {
 	sys_spu.warning("sys_spu_thread_group_create(id=*0x%x, num=%d, prio=%d, attr=*0x%x)", id, num, prio, attr);
@@ -425,7 +436,7 @@ s32 sys_spu_thread_group_resume(u32 id)
 		if (t) t->awake(); // untrigger status check
 	}
 
-	group->cv.notify_all();
+	group->notify_all(lv2_lock);
 
 	return CELL_OK;
 }
@@ -507,7 +518,7 @@ s32 sys_spu_thread_group_terminate(u32 id, s32 value)
 	group->state = SPU_THREAD_GROUP_STATUS_INITIALIZED;
 	group->exit_status = value;
 	group->join_state |= SPU_TGJSF_TERMINATED;
-	group->cv.notify_one();
+	group->notify_all(lv2_lock);
 
 	return CELL_OK;
 }
@@ -536,6 +547,11 @@ s32 sys_spu_thread_group_join(u32 id, vm::ptr<u32> cause, vm::ptr<u32> status)
 		return CELL_EBUSY;
 	}
 
+	CPUThread& cpu = *get_current_cpu_thread();
+
+	// add waiter, woken up by the thread group exit or termination, or by SPU thread exit
+	sleep_queue_entry_t waiter(cpu, group->sq);
+
 	while ((group->join_state & ~SPU_TGJSF_IS_JOINING) == 0)
 	{
 		bool stopped = true;
@@ -559,7 +575,7 @@ s32 sys_spu_thread_group_join(u32 id, vm::ptr<u32> cause, vm::ptr<u32> status)
 
 		CHECK_EMU_STATUS;
 
-		group->cv.wait_for(lv2_lock, std::chrono::milliseconds(1));
+		cpu.cv.wait(lv2_lock);
 	}
 
 	switch (group->join_state & ~SPU_TGJSF_IS_JOINING)
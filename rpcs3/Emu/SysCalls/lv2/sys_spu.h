@@ -159,7 +159,7 @@ struct lv2_spu_group_t
 	s32 exit_status; // SPU Thread Group Exit Status
 
 	std::atomic<u32> join_state; // flags used to detect exit cause
-	std::condition_variable cv; // used to signal waiting PPU thread
+	sleep_queue_t sq; // threads waiting for the thread group state change (joining PPU thread, SPU threads waiting for resume)
 
 	std::weak_ptr<lv2_event_queue_t> ep_run; // port for SYS_SPU_THREAD_GROUP_EVENT_RUN events
 	std::weak_ptr<lv2_event_queue_t> ep_exception; // TODO: SYS_SPU_THREAD_GROUP_EVENT_EXCEPTION
@@ -177,6 +177,9 @@ struct lv2_spu_group_t
 	{
 	}
 
+	// wake up all threads waiting for the thread group state change
+	void notify_all(lv2_lock_t& lv2_lock);
+
 	void send_run_event(lv2_lock_t& lv2_lock, u64 data1, u64 data2, u64 data3)
 	{
 		CHECK_LV2_LOCK(lv2_lock);
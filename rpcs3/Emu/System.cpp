@@ -6,6 +6,7 @@
 
 #include "Emu/Memory/Memory.h"
 #include "Emu/System.h"
+#include "Emu/perf.h"
 
 #include "Emu/GameInfo.h"
 #include "Emu/SysCalls/ModuleManager.h"
@@ -311,6 +312,9 @@ void Emulator::Run()
 		return;
 	}
 
+	perf::set_mode((rpcs3::config.misc.debug.perf_counters.value() ? perf::counters : 0) | (rpcs3::config.misc.debug.perf_trace.value() ? perf::trace : 0));
+	perf::reset();
+
 	rpcs3::onstart();
 
 	SendDbgCommand(DID_START_EMU);
@@ -426,6 +430,16 @@ void Emulator::Stop()
 
 	LOG_NOTICE(GENERAL, "All threads stopped...");
 
+	if (const u32 mode = perf::g_mode)
+	{
+		LOG_NOTICE(GENERAL, "Performance counters:\n%s", perf::report());
+
+		if (mode & perf::trace)
+		{
+			perf::save_trace(fs::get_config_dir() + "perf_trace.json");
+		}
+	}
+
 	idm::clear();
 	fxm::clear();
 
@@ -0,0 +1,169 @@
+#include "stdafx.h"
+#include "VideoConvert.h"
+
+namespace video_convert
+{
+	// Coefficients * 256 for (Y - 16), (V - 128) -> R, (U - 128) -> G, (V - 128) -> G, (U - 128) -> B
+	struct yuv_coefficients
+	{
+		s16 y, rv, gu, gv, bu;
+	};
+
+	static const yuv_coefficients s_bt601 = { 298, 409, 100, 208, 516 };
+	static const yuv_coefficients s_bt709 = { 298, 459, 55, 136, 541 };
+
+	// Same rounding as _mm_mulhrs_epi16 with (value << 7)
+	static force_inline s32 mul_coef(s32 value, s32 coef)
+	{
+		return (value * 128 * coef + 0x4000) >> 15;
+	}
+
+	static force_inline u8 clamp_u8(s32 value)
+	{
+		return value < 0 ? 0 : value > 255 ? 255 : static_cast<u8>(value);
+	}
+
+	void yuv420_to_rgb32(u8* dst, u32 dst_pitch, const u8* y, u32 y_pitch, const u8* u, const u8* v, u32 uv_pitch, u32 width, u32 height, rgb_format format, color_matrix matrix, u8 alpha)
+	{
+		const yuv_coefficients& k = matrix == color_matrix::bt709 ? s_bt709 : s_bt601;
+
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i k_y = _mm_set1_epi16(k.y);
+		const __m128i k_rv = _mm_set1_epi16(k.rv);
+		const __m128i k_gu = _mm_set1_epi16(k.gu);
+		const __m128i k_gv = _mm_set1_epi16(k.gv);
+		const __m128i k_bu = _mm_set1_epi16(k.bu);
+		const __m128i y_bias = _mm_set1_epi16(16);
+		const __m128i uv_bias = _mm_set1_epi16(128);
+		const __m128i a = _mm_set1_epi8(alpha);
+
+		for (u32 row = 0; row < height; row++)
+		{
+			const u8* y_row = y + row * y_pitch;
+			const u8* u_row = u + (row / 2) * uv_pitch;
+			const u8* v_row = v + (row / 2) * uv_pitch;
+			u8* out = dst + row * dst_pitch;
+			u32 x = 0;
+
+			// 16 pixels per iteration
+			for (; x + 16 <= width; x += 16)
+			{
+				const __m128i y8 = _mm_loadu_si128((const __m128i*)(y_row + x));
+				const __m128i u16 = _mm_slli_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(u_row + x / 2)), zero), uv_bias), 7);
+				const __m128i v16 = _mm_slli_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(v_row + x / 2)), zero), uv_bias), 7);
+
+				const __m128i y_lo = _mm_mulhrs_epi16(_mm_slli_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(y8, zero), y_bias), 7), k_y);
+				const __m128i y_hi = _mm_mulhrs_epi16(_mm_slli_epi16(_mm_sub_epi16(_mm_unpackhi_epi8(y8, zero), y_bias), 7), k_y);
+
+				// chroma terms, each one is used by two horizontal pixels
+				const __m128i r = _mm_mulhrs_epi16(v16, k_rv);
+				const __m128i g = _mm_add_epi16(_mm_mulhrs_epi16(u16, k_gu), _mm_mulhrs_epi16(v16, k_gv));
+				const __m128i b = _mm_mulhrs_epi16(u16, k_bu);
+
+				const __m128i r8 = _mm_packus_epi16(_mm_adds_epi16(y_lo, _mm_unpacklo_epi16(r, r)), _mm_adds_epi16(y_hi, _mm_unpackhi_epi16(r, r)));
+				const __m128i g8 = _mm_packus_epi16(_mm_subs_epi16(y_lo, _mm_unpacklo_epi16(g, g)), _mm_subs_epi16(y_hi, _mm_unpackhi_epi16(g, g)));
+				const __m128i b8 = _mm_packus_epi16(_mm_adds_epi16(y_lo, _mm_unpacklo_epi16(b, b)), _mm_adds_epi16(y_hi, _mm_unpackhi_epi16(b, b)));
+
+				__m128i p0, p1, q0, q1;
+
+				if (format == rgb_format::argb)
+				{
+					p0 = _mm_unpacklo_epi8(a, r8);
+					p1 = _mm_unpackhi_epi8(a, r8);
+					q0 = _mm_unpacklo_epi8(g8, b8);
+					q1 = _mm_unpackhi_epi8(g8, b8);
+				}
+				else
+				{
+					p0 = _mm_unpacklo_epi8(r8, g8);
+					p1 = _mm_unpackhi_epi8(r8, g8);
+					q0 = _mm_unpacklo_epi8(b8, a);
+					q1 = _mm_unpackhi_epi8(b8, a);
+				}
+
+				_mm_storeu_si128((__m128i*)(out + x * 4 + 0), _mm_unpacklo_epi16(p0, q0));
+				_mm_storeu_si128((__m128i*)(out + x * 4 + 16), _mm_unpackhi_epi16(p0, q0));
+				_mm_storeu_si128((__m128i*)(out + x * 4 + 32), _mm_unpacklo_epi16(p1, q1));
+				_mm_storeu_si128((__m128i*)(out + x * 4 + 48), _mm_unpackhi_epi16(p1, q1));
+			}
+
+			for (; x < width; x++)
+			{
+				const s32 cy = mul_coef(y_row[x] - 16, k.y);
+				const s32 cu = u_row[x / 2] - 128;
+				const s32 cv = v_row[x / 2] - 128;
+
+				const u8 r = clamp_u8(cy + mul_coef(cv, k.rv));
+				const u8 g = clamp_u8(cy - (mul_coef(cu, k.gu) + mul_coef(cv, k.gv)));
+				const u8 b = clamp_u8(cy + mul_coef(cu, k.bu));
+
+				u8* pixel = out + x * 4;
+
+				if (format == rgb_format::argb)
+				{
+					pixel[0] = alpha, pixel[1] = r, pixel[2] = g, pixel[3] = b;
+				}
+				else
+				{
+					pixel[0] = r, pixel[1] = g, pixel[2] = b, pixel[3] = alpha;
+				}
+			}
+		}
+	}
+
+	void yuv420_to_uyvy422(u8* dst, u32 dst_pitch, const u8* y, u32 y_pitch, const u8* u, const u8* v, u32 uv_pitch, u32 width, u32 height)
+	{
+		for (u32 row = 0; row < height; row++)
+		{
+			const u8* y_row = y + row * y_pitch;
+			const u8* u_row = u + (row / 2) * uv_pitch;
+			const u8* v_row = v + (row / 2) * uv_pitch;
+			u8* out = dst + row * dst_pitch;
+			u32 x = 0;
+
+			for (; x + 16 <= width; x += 16)
+			{
+				const __m128i y8 = _mm_loadu_si128((const __m128i*)(y_row + x));
+				const __m128i uv = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(u_row + x / 2)), _mm_loadl_epi64((const __m128i*)(v_row + x / 2)));
+
+				_mm_storeu_si128((__m128i*)(out + x * 2 + 0), _mm_unpacklo_epi8(uv, y8));
+				_mm_storeu_si128((__m128i*)(out + x * 2 + 16), _mm_unpackhi_epi8(uv, y8));
+			}
+
+			for (; x + 2 <= width; x += 2)
+			{
+				out[x * 2 + 0] = u_row[x / 2];
+				out[x * 2 + 1] = y_row[x];
+				out[x * 2 + 2] = v_row[x / 2];
+				out[x * 2 + 3] = y_row[x + 1];
+			}
+
+			// odd width: last column has no pair, only U and Y are written
+			if (x < width)
+			{
+				out[x * 2 + 0] = u_row[x / 2];
+				out[x * 2 + 1] = y_row[x];
+			}
+		}
+	}
+
+	void copy_yuv420(u8* dst, const u8* y, u32 y_pitch, const u8* u, const u8* v, u32 uv_pitch, u32 width, u32 height)
+	{
+		const u32 uv_width = (width + 1) / 2;
+		const u32 uv_height = (height + 1) / 2;
+
+		u8* dst_u = dst + width * height;
+		u8* dst_v = dst_u + uv_width * uv_height;
+
+		for (u32 row = 0; row < height; row++)
+		{
+			std::memcpy(dst + row * width, y + row * y_pitch, width);
+		}
+
+		for (u32 row = 0; row < uv_height; row++)
+		{
+			std::memcpy(dst_u + row * uv_width, u + row * uv_pitch, uv_width);
+			std::memcpy(dst_v + row * uv_width, v + row * uv_pitch, uv_width);
+		}
+	}
+}
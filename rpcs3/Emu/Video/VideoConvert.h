@@ -0,0 +1,27 @@
+#pragma once
+
+// SIMD picture format conversion shared by cellVdec and cellVpost
+// Chroma planes of YUV420 pictures have (width + 1) / 2 samples per line and (height + 1) / 2 lines
+namespace video_convert
+{
+	enum class color_matrix
+	{
+		bt601,
+		bt709,
+	};
+
+	enum class rgb_format
+	{
+		argb, // A R G B bytes
+		rgba, // R G B A bytes
+	};
+
+	// Convert YUV420 planar (broadcast range) to interleaved 32-bit RGB with constant alpha
+	void yuv420_to_rgb32(u8* dst, u32 dst_pitch, const u8* y, u32 y_pitch, const u8* u, const u8* v, u32 uv_pitch, u32 width, u32 height, rgb_format format, color_matrix matrix, u8 alpha);
+
+	// Convert YUV420 planar to interleaved UYVY422 (chroma lines are duplicated)
+	void yuv420_to_uyvy422(u8* dst, u32 dst_pitch, const u8* y, u32 y_pitch, const u8* u, const u8* v, u32 uv_pitch, u32 width, u32 height);
+
+	// Copy YUV420 planes to a packed YUV420 planar buffer (Y, then U and V with chroma width as pitch)
+	void copy_yuv420(u8* dst, const u8* y, u32 y_pitch, const u8* u, const u8* v, u32 uv_pitch, u32 width, u32 height);
+}
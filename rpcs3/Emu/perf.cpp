@@ -0,0 +1,316 @@
+#include "stdafx.h"
+#include "Utilities/Thread.h"
+#include "Emu/SysCalls/SysCalls.h"
+#include "Emu/Cell/MFC.h"
+#include "Emu/Cell/SPUDisAsm.h"
+#include "Emu/RSX/GCM.h"
+#include "perf.h"
+
+namespace perf
+{
+	std::atomic<u32> g_mode{ 0 };
+
+	// Maximal number of trace events recorded per thread (the rest is dropped)
+	static const std::size_t g_max_events = 1 << 20;
+
+	struct stat_t
+	{
+		u64 calls;
+		u64 value;
+		u64 time;
+	};
+
+	struct event_t
+	{
+		counter type;
+		u64 id;
+		u64 start;
+		u64 duration;
+	};
+
+	struct thread_data
+	{
+		const std::string name;
+		const u32 tid;
+
+		std::mutex mutex;
+		std::unordered_map<u64, stat_t> stats; // key: counter type and id
+		std::vector<event_t> events;
+		u64 dropped = 0;
+
+		thread_data(std::string name, u32 tid)
+			: name(std::move(name))
+			, tid(tid)
+		{
+		}
+	};
+
+	static std::mutex g_mutex;
+	static std::vector<std::shared_ptr<thread_data>> g_threads;
+	static u64 g_start = get_time();
+
+	static thread_data& get_thread_data()
+	{
+		thread_local std::shared_ptr<thread_data> data;
+
+		if (!data)
+		{
+			const auto ctrl = thread_ctrl::get_current();
+
+			std::lock_guard<std::mutex> lock(g_mutex);
+
+			data = std::make_shared<thread_data>(ctrl ? ctrl->get_name() : "Unknown Thread"s, size32(g_threads) + 1);
+			g_threads.emplace_back(data);
+		}
+
+		return *data;
+	}
+
+	static u64 get_key(counter type, u64 id)
+	{
+		return static_cast<u64>(type) << 32 | static_cast<u32>(id);
+	}
+
+	static const char* get_category(counter type)
+	{
+		switch (type)
+		{
+		case counter::syscall: return "syscall";
+		case counter::hle_call: return "hle";
+		case counter::spu_channel_stall: return "spu_stall";
+		case counter::spu_dma: return "spu_dma";
+		case counter::rsx_method: return "rsx_method";
+		case counter::rsx_draw: return "rsx_draw";
+		case counter::rsx_texture_upload: return "rsx_texture_upload";
+		case counter::rsx_vertex_upload: return "rsx_vertex_upload";
+		case counter::jit_compile: return "jit";
+		default: break;
+		}
+
+		return "unknown";
+	}
+
+	static std::string get_name(counter type, u64 id)
+	{
+		switch (type)
+		{
+		case counter::syscall: return get_ps3_function_name(~id);
+		case counter::hle_call: return get_ps3_function_name(id);
+		case counter::spu_channel_stall: return id < 128 ? spu_ch_name[id] : fmt::format("ch%d", id);
+		case counter::spu_dma: return get_mfc_cmd_name(static_cast<u32>(id));
+		case counter::rsx_method: return rsx::get_method_name(static_cast<u32>(id));
+		case counter::jit_compile: return fmt::format("0x%08x", id);
+		default: break; // counters without id
+		}
+
+		return get_category(type);
+	}
+
+	static std::string escape_json(const std::string& str)
+	{
+		std::string result;
+
+		for (const char c : str)
+		{
+			if (c == '"' || c == '\\')
+			{
+				result += '\\';
+				result += c;
+			}
+			else if (static_cast<u8>(c) < 0x20)
+			{
+				result += fmt::format("\\u%04x", c);
+			}
+			else
+			{
+				result += c;
+			}
+		}
+
+		return result;
+	}
+
+	u64 get_time()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	void set_mode(u32 mode)
+	{
+		if (mode & trace)
+		{
+			mode |= counters;
+		}
+
+		if (g_mode.exchange(mode) != mode)
+		{
+			LOG_NOTICE(GENERAL, "Performance counters %s, trace %s", mode & counters ? "enabled" : "disabled", mode & trace ? "enabled" : "disabled");
+		}
+	}
+
+	void add_impl(counter type, u64 id, u64 value)
+	{
+		auto& data = get_thread_data();
+
+		std::lock_guard<std::mutex> lock(data.mutex);
+
+		auto& stat = data.stats[get_key(type, id)];
+		stat.calls++;
+		stat.value += value;
+	}
+
+	void scope::finish()
+	{
+		const u64 duration = get_time() - m_start;
+
+		auto& data = get_thread_data();
+
+		std::lock_guard<std::mutex> lock(data.mutex);
+
+		auto& stat = data.stats[get_key(m_type, m_id)];
+		stat.calls++;
+		stat.time += duration;
+
+		if (g_mode.load(std::memory_order_relaxed) & trace)
+		{
+			if (data.events.size() < g_max_events)
+			{
+				data.events.push_back({ m_type, m_id, m_start, duration });
+			}
+			else
+			{
+				data.dropped++;
+			}
+		}
+	}
+
+	void reset()
+	{
+		std::lock_guard<std::mutex> lock(g_mutex);
+
+		// forget finished threads
+		g_threads.erase(std::remove_if(g_threads.begin(), g_threads.end(), [](const std::shared_ptr<thread_data>& data)
+		{
+			return data.use_count() == 1;
+		}), g_threads.end());
+
+		for (auto& data : g_threads)
+		{
+			std::lock_guard<std::mutex> lock(data->mutex);
+
+			data->stats.clear();
+			data->events.clear();
+			data->dropped = 0;
+		}
+
+		g_start = get_time();
+	}
+
+	std::string report()
+	{
+		std::lock_guard<std::mutex> lock(g_mutex);
+
+		std::string result;
+
+		for (auto& data : g_threads)
+		{
+			std::vector<std::pair<u64, stat_t>> stats;
+
+			{
+				std::lock_guard<std::mutex> lock(data->mutex);
+
+				stats.assign(data->stats.begin(), data->stats.end());
+			}
+
+			if (stats.empty())
+			{
+				continue;
+			}
+
+			// the most expensive entries first
+			std::sort(stats.begin(), stats.end(), [](const std::pair<u64, stat_t>& a, const std::pair<u64, stat_t>& b)
+			{
+				return a.second.time > b.second.time || (a.second.time == b.second.time && a.second.calls > b.second.calls);
+			});
+
+			result += fmt::format("%s:\n", data->name);
+
+			for (const auto& pair : stats)
+			{
+				const auto type = static_cast<counter>(pair.first >> 32);
+
+				result += fmt::format("\t%-18s %-40s calls=%-10llu value=%-12llu time=%.3f ms\n",
+					get_category(type), get_name(type, pair.first & 0xffffffff), pair.second.calls, pair.second.value, pair.second.time / 1000000.);
+			}
+		}
+
+		return result;
+	}
+
+	bool save_trace(const std::string& path)
+	{
+		fs::file f(path, fom::rewrite);
+
+		if (!f)
+		{
+			LOG_ERROR(GENERAL, "perf::save_trace(): failed to create '%s'", path);
+			return false;
+		}
+
+		std::lock_guard<std::mutex> lock(g_mutex);
+
+		std::unordered_map<u64, std::string> names;
+		std::string buffer = "{\"traceEvents\":[\n";
+		bool first = true;
+
+		const auto add_event = [&](const std::string& event)
+		{
+			buffer += first ? "" : ",\n";
+			buffer += event;
+			first = false;
+
+			if (buffer.size() >= 1024 * 1024)
+			{
+				f.write(buffer);
+				buffer.clear();
+			}
+		};
+
+		for (auto& data : g_threads)
+		{
+			std::vector<event_t> events;
+			u64 dropped;
+
+			{
+				std::lock_guard<std::mutex> lock(data->mutex);
+
+				events = data->events;
+				dropped = data->dropped;
+			}
+
+			add_event(fmt::format("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}", data->tid, escape_json(data->name)));
+
+			if (dropped)
+			{
+				LOG_WARNING(GENERAL, "perf::save_trace(): %llu events dropped (%s)", dropped, data->name);
+			}
+
+			for (const auto& event : events)
+			{
+				auto& name = names[get_key(event.type, event.id)];
+
+				if (name.empty())
+				{
+					name = escape_json(get_name(event.type, event.id));
+				}
+
+				add_event(fmt::format("{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+					name, get_category(event.type), data->tid, (static_cast<s64>(event.start - g_start)) / 1000., event.duration / 1000.));
+			}
+		}
+
+		buffer += "\n]}\n";
+		f.write(buffer);
+		return true;
+	}
+}
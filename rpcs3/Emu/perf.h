@@ -0,0 +1,81 @@
+#pragma once
+
+// Performance counters and timeline trace of emulator threads (disabled by default, switchable at runtime)
+namespace perf
+{
+	enum class counter : u32
+	{
+		syscall, // id: syscall index
+		hle_call, // id: function NID
+		spu_channel_stall, // id: SPU channel
+		spu_dma, // id: MFC command, value: bytes transferred
+		rsx_method, // id: first method register of the FIFO packet, value: method count
+		rsx_draw, // value: vertex count
+		rsx_texture_upload, // value: bytes
+		rsx_vertex_upload, // value: bytes
+		jit_compile, // id: address
+
+		max_value
+	};
+
+	enum mode : u32
+	{
+		counters = 1 << 0, // accumulate per-thread statistics
+		trace = 1 << 1, // record timeline events (implies counters)
+	};
+
+	extern std::atomic<u32> g_mode;
+
+	// Set mode flags (takes effect immediately for all threads)
+	void set_mode(u32 mode);
+
+	void add_impl(counter type, u64 id, u64 value);
+
+	// Add value to the counter of the current thread
+	force_inline void add(counter type, u64 id, u64 value = 1)
+	{
+		if (g_mode.load(std::memory_order_relaxed))
+		{
+			add_impl(type, id, value);
+		}
+	}
+
+	u64 get_time();
+
+	// Count the scope execution in the current thread and measure its duration
+	class scope final
+	{
+		const counter m_type;
+		const u64 m_id;
+		const u64 m_start;
+
+		void finish();
+
+	public:
+		force_inline scope(counter type, u64 id)
+			: m_type(type)
+			, m_id(id)
+			, m_start(g_mode.load(std::memory_order_relaxed) ? get_time() : 0)
+		{
+		}
+
+		scope(const scope&) = delete;
+
+		force_inline ~scope()
+		{
+			if (m_start)
+			{
+				finish();
+			}
+		}
+	};
+
+	// Clear statistics and trace events of all threads
+	void reset();
+
+	// Get statistics of all threads as text table
+	std::string report();
+
+	// Save recorded events in Chrome trace event format (chrome://tracing)
+	bool save_trace(const std::string& path);
+}
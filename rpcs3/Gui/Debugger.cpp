@@ -9,7 +9,7 @@
 #include "Emu/CPU/CPUThreadManager.h"
 #include "Emu/CPU/CPUThread.h"
 
-extern bool user_asked_for_frame_capture;
+extern std::atomic<bool> user_asked_for_frame_capture;
 
 class DbgEmuPanel : public wxPanel
 {
@@ -0,0 +1,308 @@
+#include "stdafx.h"
+#include "Loader/PSF.h"
+#include "GameScanner.h"
+
+static const u64 g_game_cache_magic = *(u64*)"RPCS3GL\0";
+static const u32 g_game_cache_version = 1;
+
+static void write_string(const fs::file& f, const std::string& str)
+{
+	f.write(static_cast<u32>(str.size()));
+	f.write(str);
+}
+
+static bool read_string(const fs::file& f, std::string& str)
+{
+	u32 size;
+
+	if (!f.read(size) || size > 0x10000)
+	{
+		return false;
+	}
+
+	str.resize(size);
+	return f.read(str);
+}
+
+game_scanner::game_scanner(const std::string& cache_path)
+	: m_cache_path(cache_path)
+{
+	load_cache();
+}
+
+game_scanner::~game_scanner()
+{
+	stop();
+
+	if (m_cache_modified)
+	{
+		save_cache();
+	}
+}
+
+void game_scanner::load_cache()
+{
+	fs::file f(m_cache_path);
+
+	if (!f)
+	{
+		return;
+	}
+
+	u64 magic;
+	u32 version;
+	u32 count;
+
+	if (!f.read(magic) || !f.read(version) || !f.read(count) || magic != g_game_cache_magic || version != g_game_cache_version)
+	{
+		LOG_WARNING(LOADER, "Game list cache ignored (%s)", m_cache_path);
+		return;
+	}
+
+	for (u32 i = 0; i < count; i++)
+	{
+		std::string key;
+		cache_entry entry{};
+
+		if (!read_string(f, key) || !f.read(entry.mtime) || !f.read(entry.size) ||
+			!read_string(f, entry.info.icon_path) ||
+			!read_string(f, entry.info.name) ||
+			!read_string(f, entry.info.serial) ||
+			!read_string(f, entry.info.app_ver) ||
+			!read_string(f, entry.info.category) ||
+			!read_string(f, entry.info.fw) ||
+			!f.read(entry.info.parental_lvl) ||
+			!f.read(entry.info.resolution) ||
+			!f.read(entry.info.sound_format))
+		{
+			LOG_ERROR(LOADER, "Game list cache is corrupted (%s)", m_cache_path);
+			m_cache.clear();
+			return;
+		}
+
+		m_cache.emplace(std::move(key), std::move(entry));
+	}
+}
+
+void game_scanner::save_cache()
+{
+	fs::file f(m_cache_path, fom::rewrite);
+
+	if (!f)
+	{
+		LOG_ERROR(LOADER, "Failed to save game list cache (%s)", m_cache_path);
+		return;
+	}
+
+	f.write(g_game_cache_magic);
+	f.write(g_game_cache_version);
+	f.write(static_cast<u32>(m_cache.size()));
+
+	for (const auto& pair : m_cache)
+	{
+		const auto& entry = pair.second;
+
+		write_string(f, pair.first);
+		f.write(entry.mtime);
+		f.write(entry.size);
+		write_string(f, entry.info.icon_path);
+		write_string(f, entry.info.name);
+		write_string(f, entry.info.serial);
+		write_string(f, entry.info.app_ver);
+		write_string(f, entry.info.category);
+		write_string(f, entry.info.fw);
+		f.write(entry.info.parental_lvl);
+		f.write(entry.info.resolution);
+		f.write(entry.info.sound_format);
+	}
+
+	m_cache_modified = false;
+}
+
+void game_scanner::start(const std::string& local_path, std::function<void(GameInfo&&)> callback)
+{
+	stop();
+
+	m_task = std::async(std::launch::async, [=]()
+	{
+		scan(local_path, callback);
+	});
+}
+
+void game_scanner::stop()
+{
+	m_stop = true;
+
+	if (m_task.valid())
+	{
+		m_task.get();
+	}
+
+	m_stop = false;
+}
+
+void game_scanner::scan(const std::string& local_path, const std::function<void(GameInfo&&)>& callback)
+{
+	std::vector<std::string> games;
+
+	for (const auto& entry : fs::dir(local_path))
+	{
+		if (entry.info.is_directory && entry.name != "." && entry.name != "..")
+		{
+			games.push_back(entry.name);
+		}
+	}
+
+	for (auto& pair : m_cache)
+	{
+		pair.second.visited = false;
+	}
+
+	// reading is mostly I/O bound, so use more threads than available
+	const u32 threads = std::max<u32>(1, std::min<u32>(std::max<u32>(std::thread::hardware_concurrency(), 1) * 2, static_cast<u32>(games.size())));
+
+	std::atomic<u32> next{ 0 };
+
+	const auto worker = [&]()
+	{
+		for (u32 i; !m_stop && (i = next++) < games.size();)
+		{
+			GameInfo game;
+
+			try
+			{
+				if (scan_game(local_path, games[i], game))
+				{
+					callback(std::move(game));
+				}
+			}
+			catch (const std::exception& e)
+			{
+				LOG_ERROR(LOADER, "Failed to read game information ('%s'): %s", games[i], e.what());
+			}
+		}
+	};
+
+	std::vector<std::future<void>> tasks;
+
+	for (u32 i = 1; i < threads; i++)
+	{
+		tasks.emplace_back(std::async(std::launch::async, worker));
+	}
+
+	worker();
+
+	for (auto& task : tasks)
+	{
+		task.get();
+	}
+
+	if (m_stop)
+	{
+		return;
+	}
+
+	// forget removed games
+	for (auto it = m_cache.begin(); it != m_cache.end();)
+	{
+		if (!it->second.visited)
+		{
+			it = m_cache.erase(it);
+			m_cache_modified = true;
+		}
+		else
+		{
+			it++;
+		}
+	}
+
+	if (m_cache_modified)
+	{
+		save_cache();
+	}
+
+	LOG_NOTICE(LOADER, "Game list scanned: %u directories (%s)", static_cast<u32>(games.size()), local_path);
+}
+
+bool game_scanner::scan_game(const std::string& local_path, const std::string& name, GameInfo& game)
+{
+	const std::string dir = local_path + "/" + name;
+	const std::string sfo = dir + (fs::is_file(dir + "/PS3_DISC.SFB") ? "/PS3_GAME/PARAM.SFO" : "/PARAM.SFO");
+
+	fs::stat_t info;
+
+	if (!fs::stat(sfo, info) || info.is_directory)
+	{
+		return false;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		const auto found = m_cache.find(sfo);
+
+		if (found != m_cache.end() && found->second.mtime == info.mtime && found->second.size == info.size)
+		{
+			found->second.visited = true;
+			game = found->second.info;
+			game.root = name;
+			return true;
+		}
+	}
+
+	fs::file f(sfo);
+
+	if (!f)
+	{
+		return false;
+	}
+
+	const auto& psf = psf::load(f.to_vector<char>());
+
+	game.root = name;
+	game.serial = psf::get_string(psf, "TITLE_ID", "unknown");
+	game.name = psf::get_string(psf, "TITLE", "unknown");
+	game.app_ver = psf::get_string(psf, "APP_VER", "unknown");
+	game.category = psf::get_string(psf, "CATEGORY", "unknown");
+	game.fw = psf::get_string(psf, "PS3_SYSTEM_VER", "unknown");
+	game.parental_lvl = psf::get_integer(psf, "PARENTAL_LEVEL");
+	game.resolution = psf::get_integer(psf, "RESOLUTION");
+	game.sound_format = psf::get_integer(psf, "SOUND_FORMAT");
+
+	if (game.serial.length() == 9)
+	{
+		game.serial = game.serial.substr(0, 4) + "-" + game.serial.substr(4, 5);
+	}
+
+	if (game.category.substr(0, 2) == "HG")
+	{
+		game.category = "HDD Game";
+		game.icon_path = dir + "/ICON0.PNG";
+	}
+	else if (game.category.substr(0, 2) == "DG")
+	{
+		game.category = "Disc Game";
+		game.icon_path = dir + "/PS3_GAME/ICON0.PNG";
+	}
+	else if (game.category.substr(0, 2) == "HM")
+	{
+		game.category = "Home";
+		game.icon_path = dir + "/ICON0.PNG";
+	}
+	else if (game.category.substr(0, 2) == "AV")
+	{
+		game.category = "Audio/Video";
+		game.icon_path = dir + "/ICON0.PNG";
+	}
+	else if (game.category.substr(0, 2) == "GD")
+	{
+		game.category = "Game Data";
+		game.icon_path = dir + "/ICON0.PNG";
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_cache[sfo] = { info.mtime, info.size, game, true };
+	m_cache_modified = true;
+	return true;
+}
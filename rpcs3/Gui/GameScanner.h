@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Emu/GameInfo.h"
+
+// Background game list scanner: reads PARAM.SFO of every game directory using several threads.
+// Parsed metadata is kept in a persistent index keyed by the SFO path, modification time and size.
+class game_scanner final
+{
+	struct cache_entry
+	{
+		s64 mtime;
+		u64 size;
+		GameInfo info;
+		bool visited;
+	};
+
+	const std::string m_cache_path;
+
+	std::mutex m_mutex;
+	std::unordered_map<std::string, cache_entry> m_cache;
+	bool m_cache_modified = false;
+
+	std::atomic<bool> m_stop{ false };
+	std::future<void> m_task;
+
+	void load_cache();
+	void save_cache();
+
+	void scan(const std::string& local_path, const std::function<void(GameInfo&&)>& callback);
+
+	// Get game information (from the index if PARAM.SFO wasn't modified)
+	bool scan_game(const std::string& local_path, const std::string& name, GameInfo& game);
+
+public:
+	game_scanner(const std::string& cache_path);
+
+	~game_scanner();
+
+	// Start scanning game directories in local_path (callback is called from worker threads for every game found)
+	void start(const std::string& local_path, std::function<void(GameInfo&&)> callback);
+
+	// Cancel scanning and wait for the worker threads
+	void stop();
+};
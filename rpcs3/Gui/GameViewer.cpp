@@ -4,10 +4,7 @@
 #include "Emu/Memory/Memory.h"
 #include "Emu/System.h"
 #include "Emu/FS/VFS.h"
-#include "Emu/FS/vfsDir.h"
-#include "Emu/FS/vfsFile.h"
 #include "GameViewer.h"
-#include "Loader/PSF.h"
 #include "SettingsDialog.h"
 
 static const std::string m_class_name = "GameViewer";
@@ -37,7 +34,9 @@ public:
 };
 
 // GameViewer functions
-GameViewer::GameViewer(wxWindow* parent) : wxListView(parent)
+GameViewer::GameViewer(wxWindow* parent)
+	: wxListView(parent)
+	, m_scanner(fs::get_config_dir() + "games.dat")
 {
 	LoadSettings();
 	m_columns.Show(this);
@@ -50,12 +49,14 @@ GameViewer::GameViewer(wxWindow* parent) : wxListView(parent)
 	Bind(wxEVT_LIST_ITEM_ACTIVATED, &GameViewer::DClick, this);
 	Bind(wxEVT_LIST_COL_CLICK, &GameViewer::OnColClick, this);
 	Bind(wxEVT_LIST_ITEM_RIGHT_CLICK, &GameViewer::RightClick, this);
+	Bind(wxEVT_IDLE, &GameViewer::OnIdle, this);
 
 	Refresh();
 }
 
 GameViewer::~GameViewer()
 {
+	m_scanner.stop();
 	SaveSettings();
 }
 
@@ -78,92 +79,45 @@ void GameViewer::OnColClick(wxListEvent& event)
 	ShowData();
 }
 
-void GameViewer::LoadGames()
+void GameViewer::AddPendingGames()
 {
-	m_games.clear();
-
-	for (const auto info : vfsDir(m_path))
+	std::vector<GameInfo> games;
 	{
-		if(info->flags & DirEntry_TypeDir)
-		{
-			m_games.push_back(info->name);
-		}
+		std::lock_guard<std::mutex> lock(m_pending_mutex);
+		games.swap(m_pending);
 	}
-}
 
-void GameViewer::LoadPSF()
-{
-	m_game_data.clear();
-	for (u32 i = 0; i < m_games.size(); ++i)
+	if (games.empty())
 	{
-		const std::string sfb = m_path + m_games[i] + "/PS3_DISC.SFB"; 
-		const std::string sfo = m_path + m_games[i] + (Emu.GetVFS().ExistsFile(sfb) ? "/PS3_GAME/PARAM.SFO" : "/PARAM.SFO");
-
-		if (!Emu.GetVFS().ExistsFile(sfo))
-		{
-			continue;
-		}
+		return;
+	}
 
-		vfsFile f;
-		if (!f.Open(sfo))
-		{
-			continue;
-		}
+	for (auto& game : games)
+	{
+		m_game_data.emplace_back(std::move(game));
+	}
 
-		const auto& psf = psf::load(f.VRead<char>());
-
-		// get local path from VFS...
-		std::string local_path;
-		Emu.GetVFS().GetDevice(m_path, local_path);
-
-		GameInfo game;
-		game.root = m_games[i];
-		game.serial = psf::get_string(psf, "TITLE_ID", "unknown");
-		game.name = psf::get_string(psf, "TITLE", "unknown");
-		game.app_ver = psf::get_string(psf, "APP_VER", "unknown");
-		game.category = psf::get_string(psf, "CATEGORY", "unknown");
-		game.fw = psf::get_string(psf, "PS3_SYSTEM_VER", "unknown");
-		game.parental_lvl = psf::get_integer(psf, "PARENTAL_LEVEL");
-		game.resolution = psf::get_integer(psf, "RESOLUTION");
-		game.sound_format = psf::get_integer(psf, "SOUND_FORMAT");
-		
-		if (game.serial.length() == 9)
-		{
-			game.serial = game.serial.substr(0, 4) + "-" + game.serial.substr(4, 5);
-		}
+	// Sort entries, update columns and refresh the panel
+	std::sort(m_game_data.begin(), m_game_data.end(), sortGameData(m_sortColumn, m_sortAscending));
+	m_columns.Update(m_game_data);
+	ShowData();
+}
 
-		if (game.category.substr(0, 2) == "HG")
-		{
-			game.category = "HDD Game";
-			game.icon_path = local_path + "/" + m_games[i] + "/ICON0.PNG";
-		}
-		else if (game.category.substr(0, 2) == "DG")
-		{
-			game.category = "Disc Game";
-			game.icon_path = local_path + "/" + m_games[i] + "/PS3_GAME/ICON0.PNG";
-		}
-		else if (game.category.substr(0, 2) == "HM")
-		{
-			game.category = "Home";
-			game.icon_path = local_path + "/" + m_games[i] + "/ICON0.PNG";
-		}
-		else if (game.category.substr(0, 2) == "AV")
-		{
-			game.category = "Audio/Video";
-			game.icon_path = local_path + "/" + m_games[i] + "/ICON0.PNG";
-		}
-		else if (game.category.substr(0, 2) == "GD")
+void GameViewer::OnIdle(wxIdleEvent& event)
+{
+	// decode one icon at a time, so the list stays responsive
+	for (std::size_t i = 0; i < m_columns.m_icon_indexes.size(); i++)
+	{
+		if (m_columns.m_icon_indexes[i] < 0)
 		{
-			game.category = "Game Data";
-			game.icon_path = local_path + "/" + m_games[i] + "/ICON0.PNG";
+			m_columns.m_icon_indexes[i] = m_columns.DecodeIcon(m_columns.m_col_icon->data[i]);
+			SetItemColumnImage(i, 0, m_columns.m_icon_indexes[i]);
+			event.RequestMore();
+			return;
 		}
-			
-		m_game_data.push_back(game);
 	}
 
-	// Sort entries and update columns
-	std::sort(m_game_data.begin(), m_game_data.end(), sortGameData(m_sortColumn, m_sortAscending));
-	m_columns.Update(m_game_data);
+	event.Skip();
 }
 
 void GameViewer::ShowData()
@@ -173,11 +127,31 @@ void GameViewer::ShowData()
 
 void GameViewer::Refresh()
 {
-	Emu.GetVFS().Init("/");
-	LoadGames();
-	LoadPSF();
+	m_scanner.stop();
+
+	m_pending.clear();
+	m_game_data.clear();
+	m_columns.Update(m_game_data);
 	ShowData();
+
+	// get local path from VFS...
+	Emu.GetVFS().Init("/");
+	std::string local_path;
+	Emu.GetVFS().GetDevice(m_path, local_path);
 	Emu.GetVFS().UnMountAll();
+
+	// games are added to the list in batches as they are found
+	m_scanner.start(local_path, [this](GameInfo&& game)
+	{
+		std::lock_guard<std::mutex> lock(m_pending_mutex);
+
+		m_pending.emplace_back(std::move(game));
+
+		if (m_pending.size() == 1)
+		{
+			CallAfter(&GameViewer::AddPendingGames);
+		}
+	});
 }
 
 void GameViewer::SaveSettings()
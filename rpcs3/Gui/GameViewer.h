@@ -2,6 +2,7 @@
 
 #include "Emu/GameInfo.h"
 #include "Emu/state.h"
+#include "GameScanner.h"
 
 struct Column
 {
@@ -80,9 +81,13 @@ public:
 	wxImageList* m_img_list;
 	std::vector<int> m_icon_indexes;
 
+	// Image list indices of decoded icons (by path)
+	std::unordered_map<std::string, int> m_icons;
+
 	void Init()
 	{
 		m_img_list = new wxImageList(80, 44);
+		m_icons.clear();
 
 		m_columns.clear();
 		m_columns.emplace_back(m_columns.size(),  90, "Icon");
@@ -125,18 +130,39 @@ public:
 			m_col_path->data.push_back(game.root);
 		}
 
-		// load icons
+		// icons are decoded later (GameViewer::OnIdle)
 		for (const auto& path : m_col_icon->data)
 		{
-			wxImage game_icon(80, 44);
-			{
-				wxLogNull logNo; // temporary disable wx warnings ("iCCP: known incorrect sRGB profile" spamming)
-				if (game_icon.LoadFile(fmt::FromUTF8(path), wxBITMAP_TYPE_PNG))
-					game_icon.Rescale(80, 44, wxIMAGE_QUALITY_HIGH);
-			}
+			m_icon_indexes.push_back(FindIcon(path));
+		}
+	}
+
+	// Get image list index of the icon (-1 if it wasn't decoded yet)
+	int FindIcon(const std::string& path) const
+	{
+		const auto found = m_icons.find(path);
+
+		return found != m_icons.end() ? found->second : -1;
+	}
+
+	// Decode the icon and add it to the image list
+	int DecodeIcon(const std::string& path)
+	{
+		const int index = FindIcon(path);
 
-			m_icon_indexes.push_back(m_img_list->Add(game_icon));
+		if (index >= 0)
+		{
+			return index;
+		}
+
+		wxImage game_icon(80, 44);
+		{
+			wxLogNull logNo; // temporary disable wx warnings ("iCCP: known incorrect sRGB profile" spamming)
+			if (game_icon.LoadFile(fmt::FromUTF8(path), wxBITMAP_TYPE_PNG))
+				game_icon.Rescale(80, 44, wxIMAGE_QUALITY_HIGH);
 		}
+
+		return m_icons[path] = m_img_list->Add(game_icon);
 	}
 
 	void Show(wxListView* list)
@@ -262,19 +288,26 @@ class GameViewer : public wxListView
 	int m_sortColumn;
 	bool m_sortAscending;
 	std::string m_path;
-	std::vector<std::string> m_games;
 	std::vector<GameInfo> m_game_data;
 	ColumnsArr m_columns;
 	wxMenu* m_popup;
 
+	game_scanner m_scanner;
+
+	// Games found by the scanner, not added to the list yet
+	std::mutex m_pending_mutex;
+	std::vector<GameInfo> m_pending;
+
+	void AddPendingGames();
+
+	void OnIdle(wxIdleEvent& event);
+
 public:
 	GameViewer(wxWindow* parent);
 	~GameViewer();
 
 	void DoResize(wxSize size);
 
-	void LoadGames();
-	void LoadPSF();
 	void ShowData();
 
 	void SaveSettings();
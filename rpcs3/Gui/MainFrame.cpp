@@ -8,6 +8,7 @@
 #include "Emu/Memory/Memory.h"
 #include "Emu/SysCalls/Modules/cellSysutil.h"
 #include "Emu/System.h"
+#include "Emu/perf.h"
 #include "Gui/PADManager.h"
 #include "Gui/VHDDManager.h"
 #include "Gui/VFSManager.h"
@@ -56,6 +57,9 @@ enum IDs
 	id_tools_rsx_debugger,
 	id_tools_string_search,
 	id_tools_cg_disasm,
+	id_tools_perf_counters,
+	id_tools_perf_trace,
+	id_tools_perf_save,
 	id_help_about,
 	id_update_dbg
 };
@@ -114,6 +118,10 @@ MainFrame::MainFrame()
 	menu_tools->Append(id_tools_rsx_debugger, "&RSX Debugger")->Enable(false);
 	menu_tools->Append(id_tools_string_search, "&String Search")->Enable(false);
 	menu_tools->Append(id_tools_cg_disasm, "&Cg Disasm")->Enable();
+	menu_tools->AppendSeparator();
+	menu_tools->AppendCheckItem(id_tools_perf_counters, "&Performance Counters")->Check(rpcs3::config.misc.debug.perf_counters.value() || rpcs3::config.misc.debug.perf_trace.value());
+	menu_tools->AppendCheckItem(id_tools_perf_trace, "Performance &Trace")->Check(rpcs3::config.misc.debug.perf_trace.value());
+	menu_tools->Append(id_tools_perf_save, "Save Performance &Report...");
 
 	wxMenu* menu_help = new wxMenu();
 	menubar->Append(menu_help, "&Help");
@@ -156,6 +164,9 @@ MainFrame::MainFrame()
 	Bind(wxEVT_MENU, &MainFrame::OpenRSXDebugger, this, id_tools_rsx_debugger);
 	Bind(wxEVT_MENU, &MainFrame::OpenStringSearch, this, id_tools_string_search);
 	Bind(wxEVT_MENU, &MainFrame::OpenCgDisasm, this, id_tools_cg_disasm);
+	Bind(wxEVT_MENU, &MainFrame::TogglePerf, this, id_tools_perf_counters);
+	Bind(wxEVT_MENU, &MainFrame::TogglePerf, this, id_tools_perf_trace);
+	Bind(wxEVT_MENU, &MainFrame::SavePerfReport, this, id_tools_perf_save);
 
 	Bind(wxEVT_MENU, &MainFrame::AboutDialogHandler, this, id_help_about);
 
@@ -284,7 +295,7 @@ void MainFrame::InstallPkg(wxCommandEvent& WXUNUSED(event))
 
 	wxProgressDialog pdlg("PKG Decrypter / Installer", "Please wait, unpacking...", 1000, this, wxPD_AUTO_HIDE | wxPD_APP_MODAL);
 
-	volatile f64 progress = 0.0;
+	std::atomic<f64> progress{ 0.0 };
 
 	// Run PKG unpacking asynchronously
 	auto result = std::async(std::launch::async, WRAP_EXPR(pkg_install(pkg_f, local_path + '/', progress)));
@@ -449,6 +460,48 @@ void MainFrame::OpenCgDisasm(wxCommandEvent& WXUNUSED(event))
 	(new CgDisasm(this))->Show();
 }
 
+void MainFrame::TogglePerf(wxCommandEvent& event)
+{
+	wxMenuBar& menubar(*GetMenuBar());
+
+	// trace implies counters: keep both items consistent with the mode set by perf::set_mode()
+	if (event.GetId() == id_tools_perf_trace && menubar.IsChecked(id_tools_perf_trace))
+	{
+		menubar.Check(id_tools_perf_counters, true);
+	}
+	else if (event.GetId() == id_tools_perf_counters && !menubar.IsChecked(id_tools_perf_counters))
+	{
+		menubar.Check(id_tools_perf_trace, false);
+	}
+
+	const bool counters = menubar.IsChecked(id_tools_perf_counters);
+	const bool trace = menubar.IsChecked(id_tools_perf_trace);
+
+	rpcs3::config.misc.debug.perf_counters = counters;
+	rpcs3::config.misc.debug.perf_trace = trace;
+	rpcs3::config.save();
+
+	// applied immediately if the emulator is running
+	if (!Emu.IsStopped())
+	{
+		perf::set_mode((counters ? perf::counters : 0) | (trace ? perf::trace : 0));
+	}
+}
+
+void MainFrame::SavePerfReport(wxCommandEvent& WXUNUSED(event))
+{
+	wxFileDialog ctrl(this, L"Save Performance Trace", wxEmptyString, "perf_trace.json", "Chrome trace files (*.json)|*.json|All files (*.*)|*.*", wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+
+	if (ctrl.ShowModal() == wxID_CANCEL)
+	{
+		return;
+	}
+
+	LOG_NOTICE(GENERAL, "Performance counters:\n%s", perf::report());
+
+	perf::save_trace(fmt::ToUTF8(ctrl.GetPath()));
+}
+
 void MainFrame::AboutDialogHandler(wxCommandEvent& WXUNUSED(event))
 {
 	AboutDialog(this).ShowModal();
@@ -45,6 +45,8 @@ private:
 	void OpenRSXDebugger(wxCommandEvent& evt);
 	void OpenStringSearch(wxCommandEvent& evt);
 	void OpenCgDisasm(wxCommandEvent& evt);
+	void TogglePerf(wxCommandEvent& event);
+	void SavePerfReport(wxCommandEvent& event);
 	void AboutDialogHandler(wxCommandEvent& event);
 	void UpdateUI(wxCommandEvent& event);
 	void OnKeyDown(wxKeyEvent& event);
@@ -2,6 +2,7 @@
 #include "stdafx_gui.h"
 #include "Utilities/rPlatform.h"
 #include "Emu/Memory/Memory.h"
+#include "Emu/Memory/vm_search.h"
 #include "Emu/System.h"
 
 #include "MemoryStringSearcher.h"
@@ -27,43 +28,58 @@ MemoryStringSearcher::MemoryStringSearcher(wxWindow* parent)
 	s_panel->Add(b_search);
 };
 
+MemoryStringSearcher::~MemoryStringSearcher()
+{
+	exit = true;
+
+	if (m_search_thread.joinable())
+	{
+		m_search_thread.join();
+	}
+}
+
 void MemoryStringSearcher::Search(wxCommandEvent& event)
 {
-	const wxString wstr = t_addr->GetValue();
-	const char *str = wstr.c_str();
-	const u32 len = wstr.length();
+	const std::string str = fmt::ToUTF8(t_addr->GetValue());
+
+	if (str.empty())
+	{
+		return;
+	}
+
+	if (m_search_thread.joinable())
+	{
+		m_search_thread.join();
+	}
 
 	LOG_NOTICE(GENERAL, "Searching for string %s", str);
 
-	// Search the address space for the string
-	u32 strIndex = 0;
-	u32 numFound = 0;
-	const auto area = vm::get(vm::main);
-	for (u32 addr = area->addr; addr < area->addr + area->size; addr++) {
-		if (!vm::check_addr(addr)) {
-			strIndex = 0;
-			continue;
-		}
+	// The button is enabled again when the results are posted back to the GUI thread
+	b_search->Disable();
 
-		u8 byte = vm::read8(addr);
-		if (byte == str[strIndex]) {
-			if (strIndex == len) {
-				// Found it
-				LOG_NOTICE(GENERAL, "Found @ %04x", addr - len);
-				numFound++;
-				strIndex = 0;
-				continue;
-			}
+	m_search_thread = std::thread([this, str]()
+	{
+		std::vector<vm::search_result> results;
 
-			strIndex++;
+		try
+		{
+			results = vm::search(vm::main, { vm::search_pattern::from_string(str) });
 		}
-		else
-			strIndex = 0;
-
-		if (addr % (1024 * 1024 * 64) == 0) { // Log every 64mb
-			LOG_NOTICE(GENERAL, "Searching %04x ...", addr);
+		catch (const std::exception& e)
+		{
+			LOG_ERROR(GENERAL, "Search failed: %s", e.what());
 		}
-	}
 
-	LOG_NOTICE(GENERAL, "Search completed (found %d matches)", numFound);
-}
\ No newline at end of file
+		CallAfter([this, results = std::move(results)]()
+		{
+			for (const auto& result : results)
+			{
+				LOG_NOTICE(GENERAL, "Found @ 0x%08x", result.addr);
+			}
+
+			LOG_NOTICE(GENERAL, "Search completed (found %d matches)", results.size());
+
+			b_search->Enable();
+		});
+	});
+}
@@ -6,13 +6,12 @@ class MemoryStringSearcher : public wxDialog
 	wxBoxSizer* s_panel;
 	wxButton* b_search;
 
+	std::thread m_search_thread; // vm::search() is called outside of the GUI thread
+
 public:
 	bool exit;
 	MemoryStringSearcher(wxWindow* parent);
-	~MemoryStringSearcher()
-	{
-		exit = true;
-	}
+	~MemoryStringSearcher();
 
 	void Search(wxCommandEvent& event);
 };
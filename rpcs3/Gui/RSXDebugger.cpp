@@ -73,9 +73,15 @@ RSXDebugger::RSXDebugger(wxWindow* parent)
 	b_break_prim->Disable();
 	b_break_inst->Disable();
 	
+	// Controls: Frame capture
+	wxStaticBoxSizer* s_controls_capture = new wxStaticBoxSizer(wxHORIZONTAL, this, "Capture:");
+	wxButton* b_load_capture = new wxButton(this, wxID_ANY, "Load", wxDefaultPosition, wxSize(40,-1));
+	s_controls_capture->Add(b_load_capture);
+
 	s_controls->Add(s_controls_addr);
 	s_controls->Add(s_controls_goto);
 	s_controls->Add(s_controls_breaks);
+	s_controls->Add(s_controls_capture);
 
 
 	wxNotebook* nb_rsx = new wxNotebook(this, wxID_ANY, wxDefaultPosition, wxSize(732, 732));
@@ -146,8 +152,6 @@ RSXDebugger::RSXDebugger(wxWindow* parent)
 	{
 		m_list_commands->InsertItem(m_list_commands->GetItemCount(), wxEmptyString);
 	}
-	for (u32 i = 0; i<frame_debug.command_queue.size(); i++)
-		m_list_captured_frame->InsertItem(1, wxEmptyString);
 
 	//Tools: Tools = Controls + Notebook Tabs
 	s_tools->AddSpacer(10);
@@ -251,6 +255,7 @@ RSXDebugger::RSXDebugger(wxWindow* parent)
 
 	b_goto_get->Bind(wxEVT_BUTTON, &RSXDebugger::GoToGet, this);
 	b_goto_put->Bind(wxEVT_BUTTON, &RSXDebugger::GoToPut, this);
+	b_load_capture->Bind(wxEVT_BUTTON, &RSXDebugger::OnLoadCapture, this);
 
 	p_buffer_colorA->Bind(wxEVT_LEFT_DOWN, &RSXDebugger::OnClickBuffer, this);
 	p_buffer_colorB->Bind(wxEVT_LEFT_DOWN, &RSXDebugger::OnClickBuffer, this);
@@ -462,7 +467,12 @@ namespace
 
 void RSXDebugger::OnClickDrawCalls(wxMouseEvent& event)
 {
-	size_t draw_id = m_list_captured_draw_calls->GetFirstSelected();
+	const long draw_id = m_list_captured_draw_calls->GetFirstSelected();
+
+	if (draw_id < 0 || static_cast<size_t>(draw_id) >= frame_debug.draw_calls.size())
+	{
+		return;
+	}
 
 	const auto& draw_call = frame_debug.draw_calls[draw_id];
 
@@ -479,9 +489,11 @@ void RSXDebugger::OnClickDrawCalls(wxMouseEvent& event)
 
 	for (size_t i = 0; i < 4; i++)
 	{
-		if (width && height && !draw_call.color_buffer[i].empty())
+		const auto color_buffer = frame_debug.get_blob(draw_call.color_buffer[i]);
+
+		if (width && height && !color_buffer.empty())
 		{
-			buffer_img[i] = wxImage(width, height, convert_to_wximage_buffer(draw_call.color_format, draw_call.color_buffer[i], width, height));
+			buffer_img[i] = wxImage(width, height, convert_to_wximage_buffer(draw_call.color_format, color_buffer, width, height));
 			wxClientDC dc_canvas(p_buffers[i]);
 
 			if (buffer_img[i].IsOk())
@@ -491,9 +503,11 @@ void RSXDebugger::OnClickDrawCalls(wxMouseEvent& event)
 
 	// Buffer Z
 	{
-		if (width && height && !draw_call.depth_stencil[0].empty())
+		const auto depth_buffer = frame_debug.get_blob(draw_call.depth_stencil[0]);
+
+		if (width && height && !depth_buffer.empty())
 		{
-			gsl::span<const gsl::byte> orig_buffer = draw_call.depth_stencil[0];
+			gsl::span<const gsl::byte> orig_buffer = depth_buffer;
 			unsigned char *buffer = (unsigned char *)malloc(width * height * 3);
 
 			if (draw_call.depth_format == rsx::surface_depth_format::z24s8)
@@ -535,9 +549,11 @@ void RSXDebugger::OnClickDrawCalls(wxMouseEvent& event)
 
 	// Buffer S
 	{
-		if (width && height && !draw_call.depth_stencil[1].empty())
+		const auto stencil_buffer = frame_debug.get_blob(draw_call.depth_stencil[1]);
+
+		if (width && height && !stencil_buffer.empty())
 		{
-			gsl::span<const gsl::byte> orig_buffer = draw_call.depth_stencil[1];
+			gsl::span<const gsl::byte> orig_buffer = stencil_buffer;
 			unsigned char *buffer = (unsigned char *)malloc(width * height * 3);
 
 			for (u32 row = 0; row < height; row++)
@@ -567,24 +583,49 @@ void RSXDebugger::OnClickDrawCalls(wxMouseEvent& event)
 
 	m_list_index_buffer->ClearAll();
 	m_list_index_buffer->InsertColumn(0, "Index", 0, 700);
+
+	const auto index = frame_debug.get_blob(draw_call.index);
+
 	if (frame_debug.draw_calls[draw_id].index_type == rsx::index_array_type::u16)
 	{
-		u16 *index_buffer = (u16*)frame_debug.draw_calls[draw_id].index.data();
-		for (u32 i = 0; i < frame_debug.draw_calls[draw_id].vertex_count; ++i)
+		u16 *index_buffer = (u16*)index.data();
+		for (u32 i = 0; i < index.size() / 2; ++i)
 		{
 			m_list_index_buffer->InsertItem(i, std::to_string(index_buffer[i]));
 		}
 	}
 	if (frame_debug.draw_calls[draw_id].index_type == rsx::index_array_type::u32)
 	{
-		u32 *index_buffer = (u32*)frame_debug.draw_calls[draw_id].index.data();
-		for (u32 i = 0; i < frame_debug.draw_calls[draw_id].vertex_count; ++i)
+		u32 *index_buffer = (u32*)index.data();
+		for (u32 i = 0; i < index.size() / 4; ++i)
 		{
 			m_list_index_buffer->InsertItem(i, std::to_string(index_buffer[i]));
 		}
 	}
 }
 
+void RSXDebugger::OnLoadCapture(wxCommandEvent& event)
+{
+	wxFileDialog ctrl(this, L"Load Frame Capture", wxEmptyString, wxEmptyString, "Frame capture files (*.rcap)|*.rcap|All files (*.*)|*.*", wxFD_OPEN | wxFD_FILE_MUST_EXIST);
+
+	if (ctrl.ShowModal() == wxID_CANCEL)
+	{
+		return;
+	}
+
+	// frame_debug is written by the RSX thread during the capture (a new capture is only requested by the GUI thread)
+	if (user_asked_for_frame_capture || (RSXReady() && Emu.GetGSManager().GetRender().capture_current_frame))
+	{
+		wxMessageBox("Cannot load a frame capture while a frame is being captured.", "Load Frame Capture", wxICON_ERROR);
+		return;
+	}
+
+	if (frame_debug.load(fmt::ToUTF8(ctrl.GetPath())))
+	{
+		GetCapture();
+	}
+}
+
 void RSXDebugger::GoToGet(wxCommandEvent& event)
 {
 	if (!RSXReady()) return;
@@ -617,6 +658,7 @@ void RSXDebugger::UpdateInformation()
 {
 	t_addr->SetValue(wxString::Format("%08x", m_addr));
 	GetMemory();
+	GetCapture();
 	GetBuffers();
 	GetFlags();
 	GetLightning();
@@ -655,13 +697,19 @@ void RSXDebugger::GetMemory()
 			m_list_commands->SetItem(i, 1, "????????");
 		}
 	}
+}
+
+void RSXDebugger::GetCapture()
+{
+	m_list_captured_frame->DeleteAllItems();
+	m_list_captured_draw_calls->DeleteAllItems();
 
 	std::string dump;
 
 	for (u32 i = 0; i < frame_debug.command_queue.size(); i++)
 	{
 		const std::string& str = rsx::get_pretty_printing_function(frame_debug.command_queue[i].first)(frame_debug.command_queue[i].second);
-		m_list_captured_frame->SetItem(i, 0, str);
+		m_list_captured_frame->InsertItem(i, str);
 
 		dump += str;
 		dump += '\n';
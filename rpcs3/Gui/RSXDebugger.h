@@ -51,12 +51,14 @@ public:
 	virtual void OnScrollMemory(wxMouseEvent& event);
 	virtual void OnClickBuffer(wxMouseEvent& event);
 	virtual void OnClickDrawCalls(wxMouseEvent &event);
+	virtual void OnLoadCapture(wxCommandEvent& event);
 
 	virtual void GoToGet(wxCommandEvent& event);
 	virtual void GoToPut(wxCommandEvent& event);
 
 	virtual void UpdateInformation();
 	virtual void GetMemory();
+	virtual void GetCapture();
 	virtual void GetBuffers();
 	virtual void GetFlags();
 	virtual void GetLightning();
@@ -215,6 +215,7 @@ SettingsDialog::SettingsDialog(wxWindow *parent, rpcs3::config_t* cfg)
 	ppu_decoder_modes.Add("Interpreter");
 	ppu_decoder_modes.Add("Interpreter 2");
 	ppu_decoder_modes.Add("Recompiler (LLVM)");
+	ppu_decoder_modes.Add("Recompiler (ASMJIT)");
 	rbox_ppu_decoder = new wxRadioBox(p_core, wxID_ANY, "PPU Decoder", wxDefaultPosition, wxSize(215, -1), ppu_decoder_modes, 1);
 
 #if !defined(LLVM_AVAILABLE)
@@ -11,6 +11,7 @@
 #include "Emu/SysCalls/ModuleManager.h"
 #include "Emu/SysCalls/lv2/sys_prx.h"
 #include "Emu/Cell/PPUInstrTable.h"
+#include "Emu/Cell/SPUInterpreter.h"
 #include "ELF64.h"
 
 using namespace PPU_instr;
@@ -122,90 +123,86 @@ namespace loader
 							m_stream->Read(segment.begin.get_ptr(), phdr.p_filesz);
 						}
 
-						if (phdr.p_paddr)
+						// Module info, export and import tables are parsed from the loaded segment data (offset is relative to the segment)
+						auto get_data = [&](u64 offset, u64 size) -> const void*
 						{
-							sys_prx_module_info_t module_info;
-							m_stream->Seek(handler::get_stream_offset() + phdr.p_paddr.addr());
-							m_stream->Read(&module_info, sizeof(module_info));
-
-							info.name = std::string(module_info.name, 28);
-							info.rtoc = module_info.toc + segment.begin.addr();
+							if (offset + size > phdr.p_filesz || offset + size < offset)
+							{
+								LOG_ERROR(LOADER, "%s() sprx: invalid data range (offset=0x%llx, size=0x%llx, filesz=0x%llx)", __FUNCTION__, offset, size, phdr.p_filesz);
+								return nullptr;
+							}
 
-							LOG_WARNING(LOADER, "%s (rtoc=0x%x):", info.name, info.rtoc);
+							return vm::base(segment.begin.addr() + static_cast<u32>(offset));
+						};
 
-							sys_prx_library_info_t lib;
-							for (u32 e = module_info.exports_start.addr();
-								e < module_info.exports_end.addr();
-								e += lib.size ? lib.size : sizeof(sys_prx_library_info_t))
+						// Parse the library table, calling func(module, nid, stub) for every function
+						auto parse_libs = [&](u32 start, u32 end, const char* type, auto func)
+						{
+							for (u32 e = start; e < end;)
 							{
-								m_stream->Seek(handler::get_stream_offset() + phdr.p_offset + e);
-								m_stream->Read(&lib, sizeof(lib));
+								const auto lib = static_cast<const sys_prx_library_info_t*>(get_data(e, sizeof(sys_prx_library_info_t)));
 
-								std::string modulename;
-								if (lib.name_addr)
+								if (!lib)
 								{
-									char name[27];
-									m_stream->Seek(handler::get_stream_offset() + phdr.p_offset + lib.name_addr);
-									m_stream->Read(name, sizeof(name));
-									modulename = name;
-									LOG_WARNING(LOADER, "**** Exported: %s", name);
+									break;
 								}
 
-								auto &module = info.modules[modulename];
-
-								LOG_WARNING(LOADER, "**** 0x%x - 0x%x - 0x%x", (u32)lib.unk4, (u32)lib.unk5, (u32)lib.unk6);
+								e += lib->size ? lib->size : sizeof(sys_prx_library_info_t);
 
-								for (u16 i = 0, end = lib.num_func; i < end; ++i)
+								std::string modulename;
+								if (lib->name_addr)
 								{
-									be_t<u32> fnid, fstub;
-									m_stream->Seek(handler::get_stream_offset() + phdr.p_offset + lib.fnid_addr + i * sizeof(fnid));
-									m_stream->Read(&fnid, sizeof(fnid));
+									if (const auto name = static_cast<const char*>(get_data(lib->name_addr, 1)))
+									{
+										modulename.assign(name, strnlen(name, std::min<u64>(27, phdr.p_filesz - lib->name_addr)));
+										LOG_WARNING(LOADER, "**** %s: %s", type, modulename);
+									}
+								}
 
-									m_stream->Seek(handler::get_stream_offset() + phdr.p_offset + lib.fstub_addr + i * sizeof(fstub));
-									m_stream->Read(&fstub, sizeof(fstub));
+								auto &module = info.modules[modulename];
 
-									module.exports[fnid] = fstub;
+								LOG_WARNING(LOADER, "**** 0x%x - 0x%x - 0x%x", (u32)lib->unk4, (u32)lib->unk5, (u32)lib->unk6);
 
-									//LOG_NOTICE(LOADER, "Exported function '%s' in '%s' module  (LLE)", get_ps3_function_name(fnid), module_name);
-									LOG_WARNING(LOADER, "**** %s: [%s] -> 0x%x", modulename, get_ps3_function_name(fnid), (u32)fstub);
-								}
-							}
+								const auto fnids = static_cast<const be_t<u32>*>(get_data(lib->fnid_addr, lib->num_func * sizeof(be_t<u32>)));
+								const auto fstubs = static_cast<const be_t<u32>*>(get_data(lib->fstub_addr, lib->num_func * sizeof(be_t<u32>)));
 
-							for (u32 i = module_info.imports_start;
-								i < module_info.imports_end;
-								i += lib.size ? lib.size : sizeof(sys_prx_library_info_t))
-							{
-								m_stream->Seek(handler::get_stream_offset() + phdr.p_offset + i);
-								m_stream->Read(&lib, sizeof(lib));
+								if (!fnids || !fstubs)
+								{
+									continue;
+								}
 
-								std::string modulename;
-								if (lib.name_addr)
+								for (u16 i = 0, end = lib->num_func; i < end; ++i)
 								{
-									char name[27];
-									m_stream->Seek(handler::get_stream_offset() + phdr.p_offset + lib.name_addr);
-									m_stream->Read(name, sizeof(name));
-									modulename = name;
-									LOG_WARNING(LOADER, "**** Imported: %s", name);
+									func(module, fnids[i], fstubs[i]);
+
+									LOG_WARNING(LOADER, "**** %s: [%s] -> 0x%x", modulename, get_ps3_function_name(fnids[i]), (u32)fstubs[i]);
 								}
+							}
+						};
 
-								auto &module = info.modules[modulename];
+						if (phdr.p_paddr)
+						{
+							const auto module_info = static_cast<const sys_prx_module_info_t*>(get_data(phdr.p_paddr.addr() - phdr.p_offset, sizeof(sys_prx_module_info_t)));
 
-								LOG_WARNING(LOADER, "**** 0x%x - 0x%x - 0x%x", (u32)lib.unk4, (u32)lib.unk5, (u32)lib.unk6);
+							if (!module_info)
+							{
+								return broken_file;
+							}
 
-								for (u16 i = 0, end = lib.num_func; i < end; ++i)
-								{
-									be_t<u32> fnid, fstub;
-									m_stream->Seek(handler::get_stream_offset() + phdr.p_offset + lib.fnid_addr + i * sizeof(fnid));
-									m_stream->Read(&fnid, sizeof(fnid));
+							info.name = std::string(module_info->name, 28);
+							info.rtoc = module_info->toc + segment.begin.addr();
 
-									m_stream->Seek(handler::get_stream_offset() + phdr.p_offset + lib.fstub_addr + i * sizeof(fstub));
-									m_stream->Read(&fstub, sizeof(fstub));
+							LOG_WARNING(LOADER, "%s (rtoc=0x%x):", info.name, info.rtoc);
 
-									module.imports[fnid] = fstub;
+							parse_libs(module_info->exports_start.addr(), module_info->exports_end.addr(), "Exported", [](sprx_info::module_info& module, u32 fnid, u32 fstub)
+							{
+								module.exports[fnid] = fstub;
+							});
 
-									LOG_WARNING(LOADER, "**** %s: [%s] -> 0x%x", modulename, get_ps3_function_name(fnid), (u32)fstub);
-								}
-							}
+							parse_libs(module_info->imports_start, module_info->imports_end, "Imported", [](sprx_info::module_info& module, u32 fnid, u32 fstub)
+							{
+								module.imports[fnid] = fstub;
+							});
 						}
 
 						info.segments.push_back(segment);
@@ -216,12 +213,23 @@ namespace loader
 
 				case 0x700000a4: //relocation
 				{
+					// Read the whole relocation table at once
+					std::vector<sys_prx_relocation_info_t> rels(phdr.p_filesz / sizeof(sys_prx_relocation_info_t));
+
 					m_stream->Seek(handler::get_stream_offset() + phdr.p_offset);
 
-					for (uint i = 0; i < phdr.p_filesz; i += sizeof(sys_prx_relocation_info_t))
+					if (m_stream->Read(rels.data(), rels.size() * sizeof(sys_prx_relocation_info_t)) != rels.size() * sizeof(sys_prx_relocation_info_t))
+					{
+						return broken_file;
+					}
+
+					for (const auto& rel : rels)
 					{
-						sys_prx_relocation_info_t rel;
-						m_stream->Read(&rel, sizeof(rel));
+						if (rel.index_addr >= info.segments.size() || rel.index_value >= info.segments.size())
+						{
+							LOG_ERROR(LOADER, "invalid prx relocation segment (addr=%d, value=%d)", rel.index_addr, rel.index_value);
+							return broken_file;
+						}
 
 						u32 ADDR = info.segments[rel.index_addr].begin.addr() + rel.offset;
 
@@ -554,16 +562,9 @@ namespace loader
 			// branch to initialization
 			make_branch(entry, m_ehdr.e_entry);
 
-			const auto decoder_cache = fxm::make<ppu_decoder_cache_t>();
-
-			for (u32 page = 0; page < 0x20000000; page += 4096)
-			{
-				// TODO: scan only executable areas
-				if (vm::check_addr(page, 4096))
-				{
-					decoder_cache->initialize(page, 4096);
-				}
-			}
+			// executable pages are decoded on demand
+			fxm::make<ppu_decoder_cache_t>();
+			fxm::make<spu_decoder_cache_t>();
 
 			ppu_thread main_thread(OPD.addr(), "main_thread");
 
@@ -257,7 +257,8 @@ enum class ppu_decoder_type
 {
 	interpreter,
 	interpreter2,
-	recompiler_llvm
+	recompiler_llvm,
+	recompiler_asmjit,
 };
 
 namespace convert
@@ -272,6 +273,7 @@ namespace convert
 			case ppu_decoder_type::interpreter: return "interpreter";
 			case ppu_decoder_type::interpreter2: return "interpreter2";
 			case ppu_decoder_type::recompiler_llvm: return "recompiler_llvm";
+			case ppu_decoder_type::recompiler_asmjit: return "recompiler_asmjit";
 			}
 
 			return "Unknown";
@@ -292,6 +294,9 @@ namespace convert
 			if (value == "recompiler_llvm")
 				return ppu_decoder_type::recompiler_llvm;
 
+			if (value == "recompiler_asmjit")
+				return ppu_decoder_type::recompiler_asmjit;
+
 			return ppu_decoder_type::interpreter;
 		}
 	};
@@ -845,6 +850,7 @@ namespace rpcs3
 			entry<spu_decoder_type> spu_decoder { this, "SPU Decoder",               spu_decoder_type::interpreter_precise };
 			entry<bool> hook_st_func            { this, "Hook static functions",     false };
 			entry<bool> load_liblv2             { this, "Load liblv2.sprx",          false };
+			entry<u32> video_decoder_threads    { this, "Video decoder threads",     0 }; // 0 = host core count, up to 4
 
 		} core{ this };
 
@@ -888,6 +894,7 @@ namespace rpcs3
 			entry<audio_output_type> out{ this, "Audio Out",         audio_output_type::OpenAL };
 			entry<bool> dump_to_file    { this, "Dump to file",      false };
 			entry<bool> convert_to_u16  { this, "Convert to 16 bit", false };
+			entry<u32> buffer_count     { this, "Buffer count",      31 }; // mixed blocks queued for the backend (2..32)
 		} audio{ this };
 
 		struct io_group : protected group
@@ -958,6 +965,8 @@ namespace rpcs3
 
 				entry<bool> auto_pause_syscall   { this, "Auto Pause at System Call",        false };
 				entry<bool> auto_pause_func_call { this, "Auto Pause at Function Call",      false };
+				entry<bool> perf_counters        { this, "Performance counters",             false };
+				entry<bool> perf_trace           { this, "Performance trace",                false };
 			} debug{ this };
 
 			entry<bool> exit_on_stop             { this, "Exit RPCS3 when process finishes", false };